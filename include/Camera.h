@@ -1,6 +1,7 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 #include "esp_camera.h"
+#include "driver/ledc.h"
 #include <Arduino.h>
 
 // CAMERA_MODEL_ESP32S3_EYE
@@ -102,6 +103,23 @@ public:
         sensor_t * s = esp_camera_sensor_get();
         if (s) s->set_framesize(s, size);
     }
+
+    // --- Sensor standby ---
+    // OV3660/OV5640 SYSTEM CTRL0 (0x3008) bit 6 is software power down.
+    // The register is written while XCLK still runs, then XCLK is paused.
+
+    static void standby() {
+        sensor_t * s = esp_camera_sensor_get();
+        if (s && s->set_reg) s->set_reg(s, 0x3008, 0x40, 0x40);
+        ledc_timer_pause(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0);
+    }
+
+    static void resume() {
+        ledc_timer_resume(LEDC_LOW_SPEED_MODE, LEDC_TIMER_0);
+        delay(2); // a few XCLK cycles before talking SCCB again
+        sensor_t * s = esp_camera_sensor_get();
+        if (s && s->set_reg) s->set_reg(s, 0x3008, 0x40, 0x00);
+    }
 };
 
 #endif
\ No newline at end of file
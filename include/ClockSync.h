@@ -0,0 +1,273 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "WsTopics.h"
+
+// NTP style clock exchange with each WS client subscribed to the "sync" topic.
+//
+//   device -> client  {"type":"sync","t1":<device us>}
+//   client -> device  "sync=<t1>,<t2>,<t3>"   (client receive / send time, ms)
+//   device receives at t4 (device us)
+//
+//   rtt    = (t4 - t1) - (t3 - t2)
+//   offset = ((t2 - t1) + (t3 - t4)) / 2      client time - device time
+//
+// Queuing in the WiFi stack only ever adds delay, so the exchange with the
+// lowest RTT of every SYNC_WINDOW is kept and the others are discarded. A
+// least squares line through those (device time, offset) points gives the
+// drift, so a device timestamp can be mapped to client time between
+// exchanges. The ring spans SYNC_SAMPLES * SYNC_WINDOW * SYNC_INTERVAL_MS
+// (64 s), long enough for ms-level offset noise to stay a few ppm of drift.
+#define SYNC_SAMPLES      8
+#define SYNC_WINDOW       4
+#define SYNC_INTERVAL_MS  2000
+#define SYNC_MIN_SPAN_US  15000000LL // drift needs samples at least 15 s apart
+
+struct ClientClock {
+    uint32_t clientId;
+    bool     used;
+    int64_t  pendingT1;            // outstanding request (0 = none)
+    int64_t  devUs[SYNC_SAMPLES + 1]; // ring of window minima, last slot = current window
+    double   offUs[SYNC_SAMPLES + 1];
+    uint32_t rttUs[SYNC_SAMPLES + 1];
+    uint8_t  count;
+    uint8_t  head;
+    uint8_t  window;                  // exchanges in the current window
+    // Current estimate: client_us = device_us + offsetUs + drift * (device_us - refUs)
+    int64_t  refUs;
+    double   offsetUs;
+    double   drift;               // client rate - 1 (x 1e6 = ppm)
+    uint32_t lastRttUs;
+    uint32_t minRttUs;
+    uint32_t exchanges;
+};
+
+class ClockSync {
+private:
+    // Requests go out from loop(), replies arrive on the async TCP task
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    ClientClock _clients[WS_MAX_CLIENTS];
+
+    ClientClock *find(uint32_t clientId) {
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (_clients[i].used && _clients[i].clientId == clientId) return &_clients[i];
+        }
+        return nullptr;
+    }
+
+    // Refit offset and drift from the window minima (and the current window)
+    static void estimate(ClientClock &c) {
+        uint32_t limit = c.minRttUs + c.minRttUs / 2 + 1000; // best RTT + 50 % + 1 ms
+        int total = c.count;
+        if (c.window) {
+            // Current window goes in as an extra sample
+            c.devUs[total] = c.devUs[SYNC_SAMPLES];
+            c.offUs[total] = c.offUs[SYNC_SAMPLES];
+            c.rttUs[total] = c.rttUs[SYNC_SAMPLES];
+            total++;
+        }
+
+        int n = 0, best = -1;
+        int64_t first = 0, last = 0;
+        double sx = 0, sy = 0;
+        for (int i = 0; i < total; i++) {
+            if (c.rttUs[i] > limit) continue;
+            if (best < 0 || c.rttUs[i] < c.rttUs[best]) best = i;
+            if (!n || c.devUs[i] < first) first = c.devUs[i];
+            if (!n || c.devUs[i] > last) last = c.devUs[i];
+            sx += c.devUs[i];
+            sy += c.offUs[i];
+            n++;
+        }
+        if (best < 0) return;
+
+        if (n < 3 || last - first < SYNC_MIN_SPAN_US) {
+            c.refUs = c.devUs[best];
+            c.offsetUs = c.offUs[best];
+            c.drift = 0;
+            return;
+        }
+
+        // Least squares around the mean to keep the doubles well conditioned
+        double mx = sx / n, my = sy / n, sxx = 0, sxy = 0;
+        for (int i = 0; i < total; i++) {
+            if (c.rttUs[i] > limit) continue;
+            double dx = c.devUs[i] - mx;
+            sxx += dx * dx;
+            sxy += dx * (c.offUs[i] - my);
+        }
+        c.refUs = (int64_t)mx;
+        c.offsetUs = my;
+        c.drift = sxx > 0 ? sxy / sxx : 0;
+    }
+
+public:
+    ClockSync() { memset(_clients, 0, sizeof(_clients)); }
+
+    void add(uint32_t clientId) {
+        portENTER_CRITICAL(&_mux);
+        if (!find(clientId)) {
+            for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+                if (!_clients[i].used) {
+                    memset(&_clients[i], 0, sizeof(ClientClock));
+                    _clients[i].clientId = clientId;
+                    _clients[i].used = true;
+                    break;
+                }
+            }
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    void remove(uint32_t clientId) {
+        portENTER_CRITICAL(&_mux);
+        ClientClock *c = find(clientId);
+        if (c) c->used = false;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // Start an exchange: returns t1 to put in the request
+    int64_t request(uint32_t clientId) {
+        int64_t t1 = esp_timer_get_time();
+        portENTER_CRITICAL(&_mux);
+        ClientClock *c = find(clientId);
+        if (c) c->pendingT1 = t1;
+        portEXIT_CRITICAL(&_mux);
+        return t1;
+    }
+
+    static bool isReply(const char *msg, size_t len) {
+        return len >= 5 && strncmp(msg, "sync=", 5) == 0;
+    }
+
+    // Apply "sync=t1,t2,t3" received at t4. Returns true when the sample was
+    // accepted (out then holds the new estimate); stale replies are ignored.
+    bool reply(uint32_t clientId, const char *msg, size_t len, int64_t t4, ClientClock &out) {
+        char buf[80];
+        if (!isReply(msg, len) || len >= sizeof(buf)) return false;
+        memcpy(buf, msg, len);
+        buf[len] = '\0';
+
+        char *end;
+        int64_t t1 = strtoll(buf + 5, &end, 10);
+        if (*end != ',') return false;
+        double t2 = strtod(end + 1, &end) * 1000.0;
+        if (*end != ',') return false;
+        double t3 = strtod(end + 1, &end) * 1000.0;
+        if (t3 < t2) return false;
+
+        double rtt = (double)(t4 - t1) - (t3 - t2);
+        if (rtt < 0) rtt = 0;
+
+        portENTER_CRITICAL(&_mux);
+        ClientClock *c = find(clientId);
+        bool ok = c && c->pendingT1 && c->pendingT1 == t1;
+        if (ok) {
+            c->pendingT1 = 0;
+
+            // Keep the fastest exchange of the window in the spare slot
+            const int w = SYNC_SAMPLES;
+            if (!c->window || (uint32_t)rtt < c->rttUs[w]) {
+                c->devUs[w] = t1 + (t4 - t1) / 2;
+                c->offUs[w] = ((t2 - t1) + (t3 - t4)) / 2.0;
+                c->rttUs[w] = (uint32_t)rtt;
+            }
+            if (++c->window >= SYNC_WINDOW) {
+                int i = c->head;
+                c->devUs[i] = c->devUs[w];
+                c->offUs[i] = c->offUs[w];
+                c->rttUs[i] = c->rttUs[w];
+                c->head = (c->head + 1) % SYNC_SAMPLES;
+                if (c->count < SYNC_SAMPLES) c->count++;
+                c->window = 0;
+            }
+
+            c->lastRttUs = (uint32_t)rtt;
+            // Best RTT among the samples still in the ring, so a route change can recover
+            c->minRttUs = c->window ? c->rttUs[w] : c->rttUs[0];
+            for (int k = 0; k < c->count; k++) {
+                if (c->rttUs[k] < c->minRttUs) c->minRttUs = c->rttUs[k];
+            }
+            c->exchanges++;
+            out = *c;
+        }
+        portEXIT_CRITICAL(&_mux);
+        if (!ok) return false;
+
+        // The fit (soft float doubles) runs outside the critical section
+        estimate(out);
+
+        portENTER_CRITICAL(&_mux);
+        c = find(clientId);
+        if (c) {
+            c->refUs = out.refUs;
+            c->offsetUs = out.offsetUs;
+            c->drift = out.drift;
+        }
+        portEXIT_CRITICAL(&_mux);
+        return true;
+    }
+
+    // Map a device timestamp (us since boot) to this client's clock (us):
+    //   client_us = device_us + offsetUs + drift * (device_us - refUs)
+    // False until the client completed at least one exchange.
+    bool toClientUs(uint32_t clientId, int64_t deviceUs, int64_t &clientUs) {
+        bool ok = false;
+        int64_t ref = 0;
+        double offset = 0, drift = 0;
+        portENTER_CRITICAL(&_mux);
+        ClientClock *c = find(clientId);
+        if (c && c->exchanges) {
+            ref = c->refUs;
+            offset = c->offsetUs;
+            drift = c->drift;
+            ok = true;
+        }
+        portEXIT_CRITICAL(&_mux);
+
+        if (ok) clientUs = deviceUs + (int64_t)(offset + drift * (double)(deviceUs - ref));
+        return ok;
+    }
+
+    bool toClientMs(uint32_t clientId, int64_t deviceUs, double &clientMs) {
+        int64_t us;
+        if (!toClientUs(clientId, deviceUs, us)) return false;
+        clientMs = us / 1000.0;
+        return true;
+    }
+
+    // Same for millis() based timestamps (the ones in radar / stats messages)
+    bool millisToClientMs(uint32_t clientId, uint32_t deviceMs, double &clientMs) {
+        return toClientMs(clientId, (int64_t)deviceMs * 1000, clientMs);
+    }
+
+    // Wall clock of whichever synced client came first (browsers report unix ms)
+    bool wallClockMs(uint32_t deviceMs, int64_t &unixMs) {
+        uint32_t id = 0;
+        bool found = false;
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < WS_MAX_CLIENTS && !found; i++) {
+            if (_clients[i].used && _clients[i].exchanges) { id = _clients[i].clientId; found = true; }
+        }
+        portEXIT_CRITICAL(&_mux);
+
+        double ms;
+        if (!found || !millisToClientMs(id, deviceMs, ms)) return false;
+        unixMs = (int64_t)ms;
+        return true;
+    }
+
+    int copy(ClientClock *out) {
+        int n = 0;
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (_clients[i].used) out[n++] = _clients[i];
+        }
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+};
+
+#endif
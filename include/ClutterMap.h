@@ -0,0 +1,174 @@
+#ifndef CLUTTER_MAP_H
+#define CLUTTER_MAP_H
+
+#include <Arduino.h>
+#include "LD2451_Defines.h"
+
+// Learned background of stationary reflections (guard rails, posts, walls)
+// for one radar. Unlike a higher SNR limit it only touches near-zero speed
+// returns in the places they keep showing up, so far moving cars stay visible.
+//
+// The field of view is cut into angle x distance bins. Every frame with a slow
+// return in a bin pulls its occupancy (0-255) up by 1/32 of the way to 255 and
+// tracks the SNR seen there; every CLUTTER_DECAY_MS all bins lose 1/16. A bin
+// that is hit in about a quarter of the frames or more for a few seconds
+// crosses CLUTTER_OCC_ON, and forgets again ~10 s after the scene changed.
+// A slow return in such a bin is clutter unless it is clearly stronger than
+// what the bin learned (a car stopping there).
+
+#define CLUTTER_ANGLE_BIN   5    // deg per bin
+#define CLUTTER_ANGLE_BINS  24   // -60 .. +59 deg
+#define CLUTTER_DIST_BIN    2    // m per bin
+#define CLUTTER_DIST_BINS   50   // 0 .. 99 m
+#define CLUTTER_SLOW_KMH    3    // returns up to this speed are learned / matched
+#define CLUTTER_LEARN_SHIFT 5
+#define CLUTTER_DECAY_MS    1000
+#define CLUTTER_DECAY_SHIFT 4
+#define CLUTTER_OCC_ON      128
+#define CLUTTER_SNR_MARGIN  6
+
+enum ClutterMode : uint8_t {
+    CLUTTER_OFF      = 0, // map cleared, nothing learned
+    CLUTTER_LEARN    = 1, // learn and count matches, keep the detections
+    CLUTTER_SUPPRESS = 2  // drop detections matching clutter
+};
+
+struct ClutterCell {
+    uint8_t occ;
+    uint8_t snr;
+};
+
+struct ClutterStats {
+    uint32_t frames;      // frames learned from
+    uint32_t slow;        // near-zero speed returns seen
+    uint32_t matched;     // returns that matched clutter (any mode)
+    uint32_t suppressed;  // of those, dropped
+    uint16_t bins;        // bins over CLUTTER_OCC_ON at the last decay step
+};
+
+class ClutterMap {
+private:
+    ClutterCell _cells[CLUTTER_ANGLE_BINS * CLUTTER_DIST_BINS];
+    uint32_t _lastDecay = 0;
+    bool _empty = true;
+    ClutterStats _stats = {};
+
+    // -1 outside the mapped field of view
+    static int binOf(const RadarTarget &t) {
+        int a, d;
+        if (!position(t, a, d)) return -1;
+        return (a / CLUTTER_ANGLE_BIN) * CLUTTER_DIST_BINS + d / CLUTTER_DIST_BIN;
+    }
+
+    // Angle (shifted to >= 0) and distance inside the map
+    static bool position(const RadarTarget &t, int &a, int &d) {
+        a = t.angle + CLUTTER_ANGLE_BINS * CLUTTER_ANGLE_BIN / 2;
+        d = t.distance;
+        return a >= 0 && a < CLUTTER_ANGLE_BINS * CLUTTER_ANGLE_BIN && d < CLUTTER_DIST_BINS * CLUTTER_DIST_BIN;
+    }
+
+    void decay(uint32_t now) {
+        if (!_lastDecay) _lastDecay = now;
+        uint32_t steps = (now - _lastDecay) / CLUTTER_DECAY_MS;
+        if (!steps) return;
+        _lastDecay += steps * CLUTTER_DECAY_MS;
+
+        uint16_t bins = 0;
+        for (ClutterCell &c : _cells) {
+            for (uint32_t s = 0; s < steps && c.occ; s++) c.occ -= (c.occ >> CLUTTER_DECAY_SHIFT) + 1;
+            if (c.occ >= CLUTTER_OCC_ON) bins++;
+        }
+        _stats.bins = bins;
+    }
+
+    void learn(const RadarTarget *t, int n) {
+        int hit[RADAR_MAX_TARGETS];
+        int hits = 0;
+        for (int i = 0; i < n; i++) {
+            if (t[i].speed > CLUTTER_SLOW_KMH) continue;
+            _stats.slow++;
+            int b = binOf(t[i]);
+            if (b < 0) continue;
+
+            ClutterCell &c = _cells[b];
+            if (!c.occ) c.snr = t[i].snr;
+            else c.snr += ((int)t[i].snr - c.snr) / 4;
+
+            // Several returns in one bin count as one frame
+            bool seen = false;
+            for (int k = 0; k < hits && !seen; k++) seen = hit[k] == b;
+            if (!seen && hits < RADAR_MAX_TARGETS) hit[hits++] = b;
+        }
+        for (int k = 0; k < hits; k++) {
+            ClutterCell &c = _cells[hit[k]];
+            c.occ += (255 - c.occ + (1 << CLUTTER_LEARN_SHIFT) - 1) >> CLUTTER_LEARN_SHIFT;
+        }
+        if (hits) _empty = false;
+        _stats.frames++;
+    }
+
+public:
+    ClutterMap() { reset(); }
+
+    void reset() {
+        memset(_cells, 0, sizeof(_cells));
+        _empty = true;
+        _stats.bins = 0;
+    }
+
+    // A reflector jittering around a bin edge is spread over two bins, so the
+    // bin and its nearest neighbours in angle and distance are all checked
+    bool isClutter(const RadarTarget &t) const {
+        int a, d;
+        if (t.speed > CLUTTER_SLOW_KMH || !position(t, a, d)) return false;
+
+        int ai = a / CLUTTER_ANGLE_BIN, di = d / CLUTTER_DIST_BIN;
+        int an = ai + (a % CLUTTER_ANGLE_BIN < CLUTTER_ANGLE_BIN / 2 ? -1 : 1);
+        int dn = di + (d % CLUTTER_DIST_BIN < CLUTTER_DIST_BIN / 2 ? -1 : 1);
+        if (an < 0 || an >= CLUTTER_ANGLE_BINS) an = ai;
+        if (dn < 0 || dn >= CLUTTER_DIST_BINS) dn = di;
+
+        const int cells[4] = {
+            ai * CLUTTER_DIST_BINS + di, ai * CLUTTER_DIST_BINS + dn,
+            an * CLUTTER_DIST_BINS + di, an * CLUTTER_DIST_BINS + dn,
+        };
+        for (int b : cells) {
+            const ClutterCell &c = _cells[b];
+            if (c.occ >= CLUTTER_OCC_ON && t.snr <= c.snr + CLUTTER_SNR_MARGIN) return true;
+        }
+        return false;
+    }
+
+    // Learn from one parsed frame, then drop its clutter (CLUTTER_SUPPRESS).
+    // Returns how many detections are left.
+    int apply(uint8_t mode, RadarTarget *t, int n, uint32_t now) {
+        if (mode == CLUTTER_OFF) {
+            if (!_empty) reset();
+            return n;
+        }
+        decay(now);
+
+        // Matched against the map before this frame, so a new return is not its own clutter
+        bool clutter[RADAR_MAX_TARGETS];
+        for (int i = 0; i < n; i++) clutter[i] = isClutter(t[i]);
+        learn(t, n);
+
+        int kept = 0;
+        for (int i = 0; i < n; i++) {
+            if (clutter[i]) {
+                _stats.matched++;
+                if (mode == CLUTTER_SUPPRESS) {
+                    _stats.suppressed++;
+                    continue;
+                }
+            }
+            if (kept != i) t[kept] = t[i];
+            kept++;
+        }
+        return kept;
+    }
+
+    const ClutterStats &stats() const { return _stats; }
+};
+
+#endif
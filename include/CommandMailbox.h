@@ -0,0 +1,155 @@
+#ifndef COMMAND_MAILBOX_H
+#define COMMAND_MAILBOX_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "ExclusionZones.h"
+
+#ifndef CMD_QUEUE
+#define CMD_QUEUE 16 // per mailbox, power of two
+#endif
+
+// Control plane requests from the HTTP handlers (all on the async_tcp task)
+// to the task that owns the state: loop() for config and power, the stream
+// task for the camera sensor. Handlers only validate and post; the owner
+// drains its mailbox at a safe point, merges everything that queued up and
+// applies it once, so a burst of UI clicks costs one radar reconfiguration.
+//
+// Every post returns a ticket; a ticket is applied once the owner finished
+// the command (the mailbox bit is in the low bit, the rest is a sequence
+// number, so "applied" is a single compare). 0 = mailbox full, try again.
+
+enum CommandBox : uint8_t {
+    CMD_BOX_LOOP   = 0,
+    CMD_BOX_CAMERA = 1
+};
+
+enum CommandType : uint8_t {
+    CMD_CONFIG = 1,    // loop(): ConfigPatch
+    CMD_WAKE,          // loop(): camera demand, leaves low power
+    CMD_REBOOT,        // loop()
+    CMD_CAM_FLIP,      // stream task: toggle vertical flip
+    CMD_CAM_MIRROR     // stream task: toggle horizontal mirror
+};
+
+// Fields of POST /config, applied by loop() only
+enum ConfigField : uint8_t {
+    CFG_MAX_DIST, CFG_DIRECTION, CFG_MIN_SPEED, CFG_DELAY_TIME, CFG_TRIGGER_ACC,
+    CFG_SNR_LIMIT, CFG_RAPID_THRESHOLD, CFG_CAMERA_TIMER, CFG_DISPLAY_FPS, CFG_CLUTTER,
+    CFG_RADAR_BAUD, CFG_FIELDS
+};
+
+struct ConfigPatch {
+    uint16_t set;               // bit per ConfigField present
+    uint32_t value[CFG_FIELDS];
+    bool     zonesSet;
+    uint8_t  zoneCount;
+    ExclusionZone zones[ZONE_MAX];
+
+    void put(ConfigField f, uint32_t v) { set |= 1 << f; value[f] = v; }
+    bool has(ConfigField f) const { return set & (1 << f); }
+
+    // Later patches win field by field
+    void merge(const ConfigPatch &p) {
+        for (int f = 0; f < CFG_FIELDS; f++) {
+            if (p.has((ConfigField)f)) put((ConfigField)f, p.value[f]);
+        }
+        if (p.zonesSet) {
+            zonesSet = true;
+            zoneCount = p.zoneCount;
+            memcpy(zones, p.zones, sizeof(zones));
+        }
+    }
+};
+
+struct Command {
+    uint32_t ticket;
+    uint8_t  type;
+    ConfigPatch config; // CMD_CONFIG only
+};
+
+struct MailboxStats {
+    uint32_t posted;
+    uint32_t full;      // rejected, queue full
+    uint32_t drained;   // commands taken by the owner
+    uint32_t applies;   // merged applications (drained - applies = coalesced)
+};
+
+// Bounded single producer (HTTP) / single consumer (owner task) ring
+class CommandMailbox {
+private:
+    Command _ring[CMD_QUEUE];
+    std::atomic<uint32_t> _head{0};    // written by the producer
+    std::atomic<uint32_t> _tail{0};    // written by the consumer
+    std::atomic<uint32_t> _applied{0}; // last applied ticket, written by the consumer
+    uint8_t _box;
+    uint32_t _seq = 0;                 // producer only
+    uint32_t _posted = 0;              // producer only, like the reader of stats()
+    uint32_t _full = 0;
+    std::atomic<uint32_t> _drained{0}; // consumer counters, read on the producer's task
+    std::atomic<uint32_t> _applies{0};
+
+public:
+    explicit CommandMailbox(uint8_t box) : _box(box) {}
+
+    // Producer. Returns the ticket, 0 when the queue is full.
+    uint32_t post(const Command &c) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail >= CMD_QUEUE) {
+            _full++;
+            return 0;
+        }
+
+        Command &slot = _ring[head & (CMD_QUEUE - 1)];
+        slot = c;
+        slot.ticket = (++_seq << 1) | _box;
+        _posted++;
+        _head.store(head + 1, std::memory_order_release);
+        return slot.ticket;
+    }
+
+    uint32_t post(uint8_t type) {
+        Command c;
+        c.type = type;
+        c.config.set = 0;
+        c.config.zonesSet = false;
+        return post(c);
+    }
+
+    // Consumer. Commands come out in posting order.
+    bool take(Command &out) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        out = _ring[tail & (CMD_QUEUE - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        _drained.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer: everything up to ticket is applied (counts one application)
+    void done(uint32_t ticket) {
+        _applied.store(ticket, std::memory_order_release);
+        _applies.fetch_add(1, std::memory_order_release);
+    }
+
+    // Tickets of this mailbox compare by sequence, the box bit is the same
+    bool applied(uint32_t ticket) const {
+        return (int32_t)(_applied.load(std::memory_order_acquire) - ticket) >= 0;
+    }
+
+    bool owns(uint32_t ticket) const { return ticket && (ticket & 1) == _box; }
+
+    // Producer side. applies is loaded first: every application follows the
+    // take() of its commands, so the copy never has applies > drained.
+    MailboxStats stats() const {
+        MailboxStats s;
+        s.applies = _applies.load(std::memory_order_acquire);
+        s.drained = _drained.load(std::memory_order_relaxed);
+        s.posted = _posted;
+        s.full = _full;
+        return s;
+    }
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include "ExclusionZones.h"
+#include "LD2451_Defines.h"
 
 // Declare your existing globals
 extern uint8_t cfg_max_dist;
@@ -12,7 +14,11 @@ extern uint8_t cfg_delay_time;
 extern uint8_t cfg_trigger_acc;
 extern uint8_t cfg_snr_limit;
 extern uint8_t cfg_rapid_threshold;
+extern uint8_t cfg_display_fps;
+extern uint8_t cfg_clutter;
+extern uint32_t cfg_radar_baud[RADAR_SENSOR_COUNT];
 extern uint32_t cameraTimerMs;
+extern ExclusionMap exclusions;
 
 class ConfigManager {
 public:
@@ -28,6 +34,19 @@ public:
         cfg_snr_limit      = preferences.getUChar("snr_limit", cfg_snr_limit);
         cfg_rapid_threshold= preferences.getUChar("rapid_th", cfg_rapid_threshold);
         cameraTimerMs      = preferences.getUInt("cam_timer", cameraTimerMs);
+        cfg_display_fps    = preferences.getUChar("disp_fps", cfg_display_fps);
+        cfg_clutter        = preferences.getUChar("clutter", cfg_clutter);
+        for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+            char key[8];
+            snprintf(key, sizeof(key), "baud%d", i);
+            cfg_radar_baud[i] = preferences.getUInt(key, cfg_radar_baud[i]);
+        }
+
+        if (preferences.isKey("zones")) {
+            ExclusionZone zones[ZONE_MAX];
+            size_t zoneBytes = preferences.getBytes("zones", zones, sizeof(zones));
+            exclusions.set(zones, zoneBytes / sizeof(ExclusionZone));
+        }
 
         preferences.end();
     }
@@ -44,6 +63,18 @@ public:
         preferences.putUChar("snr_limit", cfg_snr_limit);
         preferences.putUChar("rapid_th", cfg_rapid_threshold);
         preferences.putUInt("cam_timer", cameraTimerMs);
+        preferences.putUChar("disp_fps", cfg_display_fps);
+        preferences.putUChar("clutter", cfg_clutter);
+        for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+            char key[8];
+            snprintf(key, sizeof(key), "baud%d", i);
+            preferences.putUInt(key, cfg_radar_baud[i]);
+        }
+
+        ExclusionZone zones[ZONE_MAX];
+        int zoneCount = exclusions.copy(zones);
+        if (zoneCount) preferences.putBytes("zones", zones, zoneCount * sizeof(ExclusionZone));
+        else preferences.remove("zones");
 
         preferences.end();
     }
@@ -5,12 +5,33 @@
 #define USE_DISPLAY 0
 #endif
 
+#include <stdint.h>
+
+// The display renders at a fixed rate (cfg_display_fps) instead of once per
+// radar frame. Between frames every car moves on from its last smoothed
+// distance at its measured speed, for at most DISPLAY_MAX_EXTRAPOLATE_MS
+// (a lost frame must not carry a car across the screen). When the next
+// frame lands, the gap between where the car was drawn and where the radar
+// puts it is blended out over DISPLAY_CORRECT_MS rather than jumped.
+#define DISPLAY_MAX_EXTRAPOLATE_MS 500
+#define DISPLAY_CORRECT_MS         150
+#define DISPLAY_SNAP_M             5.0f // larger jumps are a different car: no blending
+
+struct DisplayStats {
+    uint32_t frames;      // rendered frames
+    uint32_t radarFrames; // target updates received
+    uint32_t overruns;    // renders longer than the frame budget
+    uint32_t renderUs;    // last render
+    uint32_t maxRenderUs;
+};
+
 #if USE_DISPLAY
 
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7735.h>
 #include <math.h>
 #include "LD2451_Defines.h"
+#include "VisionFeedback.h"
 
 #define TFT_SCL    38
 #define TFT_SDA    39
@@ -20,6 +41,7 @@
 
 extern uint8_t cfg_max_dist;
 extern uint8_t cfg_rapid_threshold;
+extern uint8_t cfg_display_fps;
 
 class DisplayModule {
 private:
@@ -30,9 +52,23 @@ private:
     const int footerTopY = 134;
     const int centerX = 64;
 
-    RadarTarget previousTargets[5];
     int previousCount = 0;
 
+    // Latest radar frame and where each car was drawn relative to it
+    struct Track {
+        RadarTarget target;
+        float mps;         // signed rate of change of the distance
+        float corrDist;    // drawn - measured at the time of the frame
+        float corrAngle;
+    };
+
+    Track tracks[RADAR_MERGED_MAX];
+    int trackCount = 0;
+    unsigned long frameMs = 0;
+    unsigned long lastRenderMs = 0;
+    bool dirty = true;
+    DisplayStats stats_ = {};
+
     struct CarRect {
         int x;
         int y;
@@ -40,7 +76,7 @@ private:
         int h;
     };
 
-    CarRect previousRects[5];
+    CarRect previousRects[RADAR_MERGED_MAX];
 
     // -------------------------
     // Smooth Perspective Mapping (vertical only)
@@ -191,16 +227,27 @@ public:
         _display.print(msg);
     }
 
-    void render(int count, RadarTarget *targets) {
+private:
+    // Where track i is drawn at time now
+    void position(const Track &t, unsigned long now, float &dist, float &angle) const {
+        unsigned long dt = now - frameMs;
+        unsigned long ahead = dt > DISPLAY_MAX_EXTRAPOLATE_MS ? DISPLAY_MAX_EXTRAPOLATE_MS : dt;
+        float blend = dt >= DISPLAY_CORRECT_MS ? 0.0f : 1.0f - (float)dt / DISPLAY_CORRECT_MS;
+
+        dist = t.target.smoothedDist + t.mps * ahead / 1000.0f + t.corrDist * blend;
+        if (dist < 0) dist = 0;
+        angle = t.target.angle + t.corrAngle * blend;
+    }
+
+    void draw(unsigned long now) {
 
         erasePreviousCars();
 
-        if (count <= 0 || targets == nullptr)
-            return;
+        for (int i = 0; i < trackCount; i++) {
 
-        for (int i = 0; i < count; i++) {
-
-            float d = targets[i].smoothedDist;
+            const RadarTarget &target = tracks[i].target;
+            float d, angle;
+            position(tracks[i], now, d, angle);
             int y = distanceToY(d);
 
             int w = map(y, roadTopY, roadBottomY, 6, 22);
@@ -209,13 +256,16 @@ public:
             if (y + (h/2) >= footerTopY)
                 y = footerTopY - (h/2) - 1;
 
-            int angleOffset = targets[i].angle;
-            int x = map(angleOffset, -30, 30, 20, 108);
+            int x = 20 + (int)((angle + 30.0f) * (108 - 20) / 60.0f);
+
+            // Vision veto suppresses the alert, a confirmation raises it
+            bool rapid = target.approaching &&
+                (target.speed > cfg_rapid_threshold || target.vision == VISION_CONFIRM);
 
             uint16_t color =
-                (targets[i].approaching && targets[i].speed > cfg_rapid_threshold)
-                ? ST77XX_RED
-                : (targets[i].approaching ? ST77XX_ORANGE : ST77XX_GREEN);
+                (target.vision == VISION_VETO)
+                ? 0x4208
+                : (rapid ? ST77XX_RED : (target.approaching ? ST77XX_ORANGE : ST77XX_GREEN));
 
             int drawX = x - (w/2);
             int drawY = y - (h/2);
@@ -231,11 +281,65 @@ public:
 
             // Store exact rectangle for next erase
             previousRects[i] = { drawX, drawY, w, h };
-            previousTargets[i] = targets[i];
         }
 
-        previousCount = count;
+        previousCount = trackCount;
     }
+
+public:
+    // New radar frame (count 0 = targets gone). Only stores it, drawing happens in tick().
+    void update(int count, const RadarTarget *targets, unsigned long now) {
+        Track next[RADAR_MERGED_MAX];
+        if (count < 0 || targets == nullptr) count = 0;
+
+        for (int i = 0; i < count; i++) {
+            next[i].target = targets[i];
+            float mps = targets[i].speed / 3.6f;
+            next[i].mps = targets[i].approaching ? -mps : mps;
+            next[i].corrDist = 0;
+            next[i].corrAngle = 0;
+
+            // Same slot, same radar, close by: blend from where it is drawn now
+            if (i < trackCount && tracks[i].target.sensor == targets[i].sensor) {
+                float d, angle;
+                position(tracks[i], now, d, angle);
+                float jump = d - targets[i].smoothedDist;
+                if (fabsf(jump) < DISPLAY_SNAP_M) {
+                    next[i].corrDist = jump;
+                    next[i].corrAngle = angle - targets[i].angle;
+                }
+            }
+        }
+
+        memcpy(tracks, next, count * sizeof(Track));
+        trackCount = count;
+        frameMs = now;
+        dirty = true;
+        stats_.radarFrames++;
+    }
+
+    // Called every loop(); renders when the next frame is due
+    void tick(unsigned long now) {
+        uint8_t fps = cfg_display_fps ? cfg_display_fps : 1;
+        unsigned long frameBudgetMs = 1000 / fps;
+        if (now - lastRenderMs < frameBudgetMs) return;
+
+        // Nothing moves while there are no cars: only draw the change to empty
+        if (!trackCount && !dirty) return;
+        lastRenderMs = now;
+        dirty = false;
+
+        unsigned long start = micros();
+        draw(now);
+        uint32_t us = micros() - start;
+
+        stats_.frames++;
+        stats_.renderUs = us;
+        if (us > stats_.maxRenderUs) stats_.maxRenderUs = us;
+        if (us > frameBudgetMs * 1000) stats_.overruns++;
+    }
+
+    const DisplayStats &stats() const { return stats_; }
 };
 
 #else
@@ -246,11 +350,14 @@ public:
 #define ST77XX_RED   0
 struct RadarTarget; 
 class DisplayModule {
+    DisplayStats stats_ = {};
 public:
     void init() {}
     void updateMessage(const char*, uint16_t) {}
-    void render(int, RadarTarget*) {}
+    void update(int, const RadarTarget*, unsigned long) {}
+    void tick(unsigned long) {}
     void redrawBackground() {}
+    const DisplayStats &stats() const { return stats_; }
 };
 
 #endif
@@ -0,0 +1,398 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include <Preferences.h>
+#include "LD2451_Defines.h"
+#include "VisionFeedback.h"
+#include "MotionFilter.h"
+
+// Alert log on LittleFS that survives reboots.
+//
+// loop() only copies finished alerts into a small RAM queue (never touches
+// flash, drops and counts when full). A low priority task appends them in
+// batches of EVENT_BATCH, or once the oldest waited EVENT_FLUSH_MS, with one
+// open/write/close per batch: few flash programs, and LittleFS commits a file
+// atomically on close, so a power cut loses at most the queued batch.
+//
+// The log is a ring of segment files /log/<seq>.bin of EVENT_SEGMENT_RECORDS
+// fixed size records; when a new segment is started past EVENT_MAX_SEGMENTS
+// the oldest is deleted, so the log stays bounded (LittleFS spreads the
+// erases itself). Every record carries a CRC; a torn or corrupt record is
+// skipped on read and a segment with a torn tail is never appended to again.
+
+#define EVENT_LOG_DIR         "/log"
+#define EVENT_SEGMENT_RECORDS 512  // 16 KB per segment
+#define EVENT_MAX_SEGMENTS    16   // 256 KB at most
+#define EVENT_QUEUE           32
+#define EVENT_BATCH           8
+#define EVENT_FLUSH_MS        5000
+#define EVENT_MAGIC           0xE7
+
+enum EventKind : uint8_t {
+    EVENT_RAPID      = 1, // rapid approach alert
+    EVENT_CLOSE_PASS = 2  // approaching car came within the close pass range
+};
+
+#define EVENT_FLAG_VETO  0x01 // vision client vetoed the target during the alert
+#define EVENT_FLAG_GHOST 0x02 // motion pre-filter flagged it as a likely ghost
+
+// 32 bytes on flash, little endian
+struct __attribute__((packed)) EventRecord {
+    uint8_t  magic;
+    uint8_t  kind;
+    uint16_t boot;       // boot counter, startMs is uptime within that boot
+    uint32_t startMs;
+    int64_t  unixMs;     // wall clock from a synced WS client, 0 = unknown
+    uint32_t durationMs;
+    uint8_t  peakSpeed;  // km/h
+    uint8_t  minDist;    // m
+    int8_t   angle;      // deg, at the closest point
+    uint8_t  sensor;
+    uint8_t  flags;
+    uint8_t  reserved[3];
+    uint32_t crc;        // CRC-32 of the 28 bytes above
+};
+
+static_assert(sizeof(EventRecord) == 32, "EventRecord is a fixed 32 byte flash record");
+
+struct EventLogStats {
+    uint32_t queued;    // accepted from loop()
+    uint32_t dropped;   // queue full or file system unavailable
+    uint32_t written;   // records on flash since boot
+    uint32_t flushes;   // batch writes
+    uint32_t errors;    // failed writes
+    uint32_t rotations;
+    uint16_t boot;
+};
+
+// Which records a reader wants. from/to are unix ms, or uptime ms when boot >= 0.
+struct EventQuery {
+    int32_t  boot = -1;
+    int64_t  from = 0;
+    int64_t  to = INT64_MAX;
+    uint32_t limit = 1000;
+};
+
+// Position of a streaming reader; survives segment rotation (deleted segments are skipped)
+struct EventCursor {
+    uint32_t seq = 0;
+    uint32_t offset = 0;
+    uint32_t matched = 0;
+    bool     started = false;
+    bool     done = false;
+};
+
+// One alert from its rising to its falling edge
+class AlertEpisode {
+private:
+    uint8_t _kind;
+    bool _active = false;
+    EventRecord _rec = {};
+
+public:
+    explicit AlertEpisode(uint8_t kind) : _kind(kind) {}
+
+    // t is the target that holds the alert (nullptr when it is not active).
+    // Returns true when the alert just ended; out then holds its record.
+    bool update(const RadarTarget *t, uint32_t now, EventRecord &out) {
+        if (t) {
+            if (!_active) {
+                memset(&_rec, 0, sizeof(_rec));
+                _rec.kind = _kind;
+                _rec.startMs = now;
+                _rec.minDist = 255;
+                _active = true;
+            }
+            if (t->speed > _rec.peakSpeed) _rec.peakSpeed = t->speed;
+            if (t->distance < _rec.minDist) {
+                _rec.minDist = t->distance;
+                _rec.angle = t->angle;
+                _rec.sensor = t->sensor;
+            }
+            if (t->vision == VISION_VETO) _rec.flags |= EVENT_FLAG_VETO;
+            if (t->motion == MOTION_GHOST) _rec.flags |= EVENT_FLAG_GHOST;
+            return false;
+        }
+
+        if (!_active) return false;
+        _active = false;
+        _rec.durationMs = now - _rec.startMs;
+        out = _rec;
+        return true;
+    }
+};
+
+class EventLog {
+private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Filled by loop(), drained by the writer task
+    EventRecord _queue[EVENT_QUEUE];
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+    uint32_t _oldestMs = 0;
+
+    // Segment range, written by the writer task, read by HTTP readers
+    uint32_t _firstSeq = 0;
+    uint32_t _lastSeq = 0;
+    uint32_t _lastRecords = 0; // records in the last segment
+    bool _ready = false;
+
+    EventLogStats _stats = {};
+    TaskHandle_t _task = nullptr;
+
+    static uint32_t crc32(const uint8_t *p, size_t len) {
+        uint32_t crc = 0xFFFFFFFF;
+        while (len--) {
+            crc ^= *p++;
+            for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+        return ~crc;
+    }
+
+    static void segmentPath(char *buf, size_t len, uint32_t seq) {
+        snprintf(buf, len, EVENT_LOG_DIR "/%08lu.bin", (unsigned long)seq);
+    }
+
+    // Find the segment range left by the previous boots
+    void scan() {
+        uint32_t first = UINT32_MAX, last = 0;
+        File dir = LittleFS.open(EVENT_LOG_DIR);
+        for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+            const char *name = strrchr(f.name(), '/'); // older cores return the full path
+            uint32_t seq = strtoul(name ? name + 1 : f.name(), nullptr, 10);
+            if (seq < first) first = seq;
+            if (seq > last) last = seq;
+            f.close();
+        }
+        dir.close();
+
+        if (first == UINT32_MAX) {
+            first = last = 1;
+            _lastRecords = 0;
+        } else {
+            char path[32];
+            segmentPath(path, sizeof(path), last);
+            File f = LittleFS.open(path, "r");
+            size_t size = f ? f.size() : 0;
+            if (f) f.close();
+            _lastRecords = size / sizeof(EventRecord);
+            // Torn tail (power cut mid write): leave that segment as it is
+            if (size % sizeof(EventRecord)) _lastRecords = EVENT_SEGMENT_RECORDS;
+        }
+        _firstSeq = first;
+        _lastSeq = last;
+    }
+
+    // Start the next segment, dropping the oldest past EVENT_MAX_SEGMENTS
+    void rotate() {
+        uint32_t dropFrom, dropTo;
+        portENTER_CRITICAL(&_mux);
+        dropFrom = _firstSeq;
+        _lastSeq++;
+        _lastRecords = 0;
+        while (_lastSeq - _firstSeq + 1 > EVENT_MAX_SEGMENTS) _firstSeq++;
+        dropTo = _firstSeq;
+        portEXIT_CRITICAL(&_mux);
+
+        // Readers skip missing segments, so deleting after the range moved is safe
+        char path[32];
+        for (uint32_t seq = dropFrom; seq < dropTo; seq++) {
+            segmentPath(path, sizeof(path), seq);
+            if (LittleFS.exists(path)) LittleFS.remove(path);
+        }
+        portENTER_CRITICAL(&_mux);
+        _stats.rotations++;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    void flush() {
+        EventRecord batch[EVENT_QUEUE];
+        int n = 0;
+        portENTER_CRITICAL(&_mux);
+        while (_count) {
+            batch[n++] = _queue[_head];
+            _head = (_head + 1) % EVENT_QUEUE;
+            _count--;
+        }
+        portEXIT_CRITICAL(&_mux);
+
+        for (int i = 0; i < n;) {
+            if (_lastRecords >= EVENT_SEGMENT_RECORDS) rotate();
+
+            int chunk = n - i;
+            if (chunk > (int)(EVENT_SEGMENT_RECORDS - _lastRecords)) chunk = EVENT_SEGMENT_RECORDS - _lastRecords;
+
+            char path[32];
+            segmentPath(path, sizeof(path), _lastSeq);
+            File f = LittleFS.open(path, "a");
+            size_t bytes = chunk * sizeof(EventRecord);
+            bool ok = f && f.write((const uint8_t*)&batch[i], bytes) == bytes;
+            if (f) f.close();
+
+            if (!ok) {
+                // Never append behind a partial write
+                portENTER_CRITICAL(&_mux);
+                _stats.errors++;
+                _stats.dropped += n - i;
+                portEXIT_CRITICAL(&_mux);
+                _lastRecords = EVENT_SEGMENT_RECORDS;
+                return;
+            }
+            portENTER_CRITICAL(&_mux);
+            _lastRecords += chunk;
+            _stats.written += chunk;
+            if (i + chunk == n) _stats.flushes++;
+            portEXIT_CRITICAL(&_mux);
+            i += chunk;
+        }
+    }
+
+    static void writerTask(void *arg) {
+        EventLog *log = (EventLog*)arg;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+
+            portENTER_CRITICAL(&log->_mux);
+            bool due = log->_count >= EVENT_BATCH ||
+                       (log->_count && millis() - log->_oldestMs >= EVENT_FLUSH_MS);
+            portEXIT_CRITICAL(&log->_mux);
+
+            if (due) log->flush();
+        }
+    }
+
+    static bool matches(const EventRecord &r, const EventQuery &q) {
+        if (r.magic != EVENT_MAGIC || r.crc != crc32((const uint8_t*)&r, offsetof(EventRecord, crc))) return false;
+        if (q.boot >= 0) {
+            return r.boot == q.boot && (int64_t)r.startMs >= q.from && (int64_t)r.startMs <= q.to;
+        }
+        if (q.from == 0 && q.to == INT64_MAX) return true;
+        return r.unixMs != 0 && r.unixMs >= q.from && r.unixMs <= q.to;
+    }
+
+public:
+    void begin() {
+        if (!LittleFS.begin(true)) return; // formats a blank partition on first use
+        if (!LittleFS.exists(EVENT_LOG_DIR)) LittleFS.mkdir(EVENT_LOG_DIR);
+
+        Preferences preferences;
+        preferences.begin("evlog", false);
+        _stats.boot = preferences.getUShort("boot", 0) + 1;
+        preferences.putUShort("boot", _stats.boot);
+        preferences.end();
+
+        scan();
+        _ready = true;
+        xTaskCreatePinnedToCore(writerTask, "evlog", 4096, this, 1, &_task, 0);
+    }
+
+    // loop(): queue a finished alert. Never blocks; drops when the queue is full.
+    bool append(EventRecord r) {
+        if (!_ready) {
+            portENTER_CRITICAL(&_mux);
+            _stats.dropped++;
+            portEXIT_CRITICAL(&_mux);
+            return false;
+        }
+
+        r.magic = EVENT_MAGIC;
+        r.boot = _stats.boot;
+        memset(r.reserved, 0, sizeof(r.reserved));
+        r.crc = crc32((const uint8_t*)&r, offsetof(EventRecord, crc));
+
+        bool ok = false, wake = false;
+        portENTER_CRITICAL(&_mux);
+        if (_count < EVENT_QUEUE) {
+            if (!_count) _oldestMs = millis();
+            _queue[(_head + _count) % EVENT_QUEUE] = r;
+            _count++;
+            ok = true;
+            wake = _count >= EVENT_BATCH;
+        }
+        if (ok) _stats.queued++;
+        else _stats.dropped++;
+        portEXIT_CRITICAL(&_mux);
+
+        if (wake) xTaskNotifyGive(_task);
+        return ok;
+    }
+
+    // Up to max matching records from the cursor on, reading one segment at a
+    // time straight from flash. Returns 0 once the cursor is done.
+    size_t read(EventCursor &c, const EventQuery &q, EventRecord *out, size_t max) {
+        if (!_ready) { c.done = true; return 0; }
+
+        size_t n = 0;
+        while (!c.done && n < max) {
+            uint32_t first, last, lastRecords;
+            portENTER_CRITICAL(&_mux);
+            first = _firstSeq;
+            last = _lastSeq;
+            lastRecords = _lastRecords;
+            portEXIT_CRITICAL(&_mux);
+
+            if (!c.started || c.seq < first) { c.seq = first; c.offset = 0; c.started = true; }
+            if (c.seq > last || c.matched >= q.limit) { c.done = true; break; }
+
+            // Only records the writer finished (the last segment may be growing)
+            uint32_t end = c.seq == last ? lastRecords : EVENT_SEGMENT_RECORDS;
+            if (c.offset >= end) {
+                if (c.seq == last) { c.done = true; break; }
+                c.seq++;
+                c.offset = 0;
+                continue;
+            }
+
+            char path[32];
+            segmentPath(path, sizeof(path), c.seq);
+            File f = LittleFS.open(path, "r");
+            if (!f) { c.seq++; c.offset = 0; continue; } // rotated away meanwhile
+            f.seek(c.offset * sizeof(EventRecord));
+
+            while (n < max && c.offset < end && c.matched < q.limit) {
+                EventRecord r;
+                if (f.read((uint8_t*)&r, sizeof(r)) != sizeof(r)) { c.offset = end; break; }
+                c.offset++;
+                if (matches(r, q)) { out[n++] = r; c.matched++; }
+            }
+            f.close();
+        }
+        return n;
+    }
+
+    int segments() {
+        portENTER_CRITICAL(&_mux);
+        int n = _ready ? _lastSeq - _firstSeq + 1 : 0;
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    int pending() {
+        portENTER_CRITICAL(&_mux);
+        int n = _count;
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    // Counters move on loop() and the writer task, /stats reads a copy
+    EventLogStats stats() {
+        portENTER_CRITICAL(&_mux);
+        EventLogStats st = _stats;
+        portEXIT_CRITICAL(&_mux);
+        return st;
+    }
+
+    static const char *kindName(uint8_t kind) {
+        switch (kind) {
+            case EVENT_RAPID:      return "rapid";
+            case EVENT_CLOSE_PASS: return "close_pass";
+            default:               return "unknown";
+        }
+    }
+};
+
+#endif
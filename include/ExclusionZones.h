@@ -0,0 +1,155 @@
+#ifndef EXCLUSION_ZONES_H
+#define EXCLUSION_ZONES_H
+
+#include <Arduino.h>
+#include "LD2451_Defines.h"
+
+// User defined areas whose detections are dropped right after parsing
+// (parked cars, sign posts, guard rails on a regular route), so they never
+// reach the filter, the display or the network.
+//
+// A zone is an angle range x distance range, optionally only up to a speed
+// and only for one sensor. The zones are compiled into one bit mask table per
+// target field (bit z set = value inside zone z), so a detection is checked
+// with four loads and ANDs however many zones there are.
+
+#define ZONE_MAX      8   // one bit per zone in the masks
+#define ZONE_ANY      255 // maxSpeed / sensor: no limit
+#define ZONE_SPEC_LEN (ZONE_MAX * 24)
+
+struct ExclusionZone {
+    int8_t  angleMin;  // deg
+    int8_t  angleMax;
+    uint8_t distMin;   // m
+    uint8_t distMax;
+    uint8_t maxSpeed;  // km/h, only slower detections are dropped
+    uint8_t sensor;
+};
+
+class ExclusionMap {
+private:
+    // Compiled on set() (HTTP task / setup), read by the ingest of every sensor
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t _angle[256]; // indexed by angle + 128
+    uint8_t _dist[256];
+    uint8_t _speed[256];
+    uint8_t _sensor[RADAR_SENSOR_COUNT];
+
+    ExclusionZone _zones[ZONE_MAX];
+    int _count = 0;
+    uint32_t _hits[ZONE_MAX];
+    uint32_t _suppressed = 0;
+
+public:
+    ExclusionMap() { set(nullptr, 0); }
+
+    void set(const ExclusionZone *zones, int count) {
+        if (count > ZONE_MAX) count = ZONE_MAX;
+        uint8_t angle[256] = {}, dist[256] = {}, speed[256] = {}, sensor[RADAR_SENSOR_COUNT] = {};
+
+        for (int z = 0; z < count; z++) {
+            const ExclusionZone &e = zones[z];
+            uint8_t bit = 1 << z;
+            for (int a = e.angleMin; a <= e.angleMax; a++) angle[a + 128] |= bit;
+            for (int d = e.distMin; d <= e.distMax; d++) dist[d] |= bit;
+            for (int s = 0; s <= e.maxSpeed; s++) speed[s] |= bit;
+            for (int s = 0; s < RADAR_SENSOR_COUNT; s++) {
+                if (e.sensor == ZONE_ANY || e.sensor == s) sensor[s] |= bit;
+            }
+        }
+
+        portENTER_CRITICAL(&_mux);
+        memcpy(_angle, angle, sizeof(angle));
+        memcpy(_dist, dist, sizeof(dist));
+        memcpy(_speed, speed, sizeof(speed));
+        memcpy(_sensor, sensor, sizeof(sensor));
+        if (count) memcpy(_zones, zones, count * sizeof(ExclusionZone));
+        _count = count;
+        memset(_hits, 0, sizeof(_hits));
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // Drop excluded detections in place. Returns how many are left.
+    int apply(uint8_t sensor, RadarTarget *t, int n) {
+        int kept = 0;
+        portENTER_CRITICAL(&_mux);
+        uint8_t sensorMask = sensor < RADAR_SENSOR_COUNT ? _sensor[sensor] : 0;
+        for (int i = 0; i < n; i++) {
+            uint8_t hit = sensorMask & _angle[t[i].angle + 128] & _dist[t[i].distance] & _speed[t[i].speed];
+            if (hit) {
+                _hits[__builtin_ctz(hit)]++;
+                _suppressed++;
+                continue;
+            }
+            if (kept != i) t[kept] = t[i];
+            kept++;
+        }
+        portEXIT_CRITICAL(&_mux);
+        return kept;
+    }
+
+    int copy(ExclusionZone *out, uint32_t *hits = nullptr) {
+        portENTER_CRITICAL(&_mux);
+        int n = _count;
+        memcpy(out, _zones, n * sizeof(ExclusionZone));
+        if (hits) memcpy(hits, _hits, n * sizeof(uint32_t));
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    uint32_t suppressed() const { return _suppressed; }
+
+    // "angleMin,angleMax,distMin,distMax[,maxSpeed[,sensor]];..." Returns the
+    // zone count, -1 if malformed. Swapped bounds are put in order.
+    static int parse(const char *spec, ExclusionZone *out) {
+        int n = 0;
+        const char *p = spec;
+        while (*p) {
+            if (*p == ';' || *p == ' ') { p++; continue; }
+            if (n == ZONE_MAX) return -1;
+
+            long v[6] = { 0, 0, 0, 0, ZONE_ANY, ZONE_ANY };
+            int k = 0;
+            for (;;) {
+                char *end;
+                long x = strtol(p, &end, 10);
+                if (end == p || k == 6) return -1;
+                v[k++] = x;
+                p = end;
+                if (*p != ',') break;
+                p++;
+            }
+            if (k < 4 || (*p && *p != ';')) return -1;
+            if (v[0] < -128 || v[0] > 127 || v[1] < -128 || v[1] > 127) return -1;
+            for (int i = 2; i < 6; i++) {
+                if (v[i] < 0 || v[i] > 255) return -1;
+            }
+
+            ExclusionZone &z = out[n++];
+            z.angleMin = v[0] < v[1] ? v[0] : v[1];
+            z.angleMax = v[0] < v[1] ? v[1] : v[0];
+            z.distMin  = v[2] < v[3] ? v[2] : v[3];
+            z.distMax  = v[2] < v[3] ? v[3] : v[2];
+            z.maxSpeed = v[4];
+            z.sensor   = v[5];
+        }
+        return n;
+    }
+
+    // Inverse of parse(), limits left out when they are "any"
+    static void format(const ExclusionZone *zones, int n, char *buf, size_t len) {
+        size_t pos = 0;
+        buf[0] = 0;
+        for (int i = 0; i < n && pos < len; i++) {
+            const ExclusionZone &z = zones[i];
+            pos += snprintf(buf + pos, len - pos, "%s%d,%d,%u,%u", i ? ";" : "",
+                            z.angleMin, z.angleMax, z.distMin, z.distMax);
+            if (pos < len && (z.maxSpeed != ZONE_ANY || z.sensor != ZONE_ANY))
+                pos += snprintf(buf + pos, len - pos, ",%u", z.maxSpeed);
+            if (pos < len && z.sensor != ZONE_ANY)
+                pos += snprintf(buf + pos, len - pos, ",%u", z.sensor);
+        }
+    }
+};
+
+#endif
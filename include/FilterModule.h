@@ -1,30 +1,72 @@
 #ifndef FILTER_MODULE_H
 #define FILTER_MODULE_H
 
+#include <math.h>
+
+// Alpha-beta tracker per target slot, driven by the real time between frames.
+// The LD2451 measures radial speed directly, so the velocity estimate leans
+// on that measurement and the position residual only trims it. Prediction
+// removes the lag a plain EMA has on an approaching car (the old double EMA
+// trailed by ~14 m at 60 km/h, see test_filter) while the position gain keeps
+// the 1 m distance quantization from showing as jitter.
+//
+// Tracks are kept by slot, and exclusions and clutter suppression compact
+// the target list, so a slot can change cars between frames. A measurement
+// further from the prediction than the gate starts the track over on the
+// new car instead of dragging the old one's estimate toward it.
 class SignalFilter {
 private:
-    float _values[5]; 
-    const float _alpha = 0.18f; // Smoothing factor (Adjust between 0.05 and 0.3)
+    struct Track {
+        float pos;            // m
+        float vel;            // m/s, negative = approaching
+        unsigned long lastMs;
+        bool active;
+    };
+
+    Track _tracks[5] = {};
+    const float _alpha = 0.25f;          // position correction
+    const float _beta = 0.05f;           // velocity correction from the position residual
+    const float _speedGain = 0.5f;       // weight of the measured radar speed
+    const unsigned long MAX_GAP_MS = 1000; // longer gaps restart the track
+    const float GATE_M = 3.0f;           // plus the distance covered since the last frame
 
 public:
     SignalFilter() {
-        for(int i = 0; i < 5; i++) _values[i] = -1.0f; 
+        for(int i = 0; i < 5; i++) reset(i);
     }
 
-    float smooth(int index, float raw) {
+    // raw: measured distance (m), speed: measured radial speed (m/s, negative = approaching)
+    float smooth(int index, float raw, float speed, unsigned long nowMs) {
+        Track &t = _tracks[index];
+
         // If it's a new target, snap immediately to the value
-        if (_values[index] < 0) {
-            _values[index] = raw;
-        } else {
-            // Native FPU handles this EMA calculation
-            _values[index] = (_alpha * raw) + (1.0f - _alpha) * _values[index];
+        if (!t.active || nowMs - t.lastMs > MAX_GAP_MS) {
+            t = { raw, speed, nowMs, true };
+            return raw;
+        }
+
+        float dt = (nowMs - t.lastMs) / 1000.0f;
+        float predicted = t.pos + t.vel * dt;
+        float residual = raw - predicted;
+
+        // Not the car this track followed
+        if (fabsf(residual) > GATE_M + fabsf(t.vel) * dt) {
+            t = { raw, speed, nowMs, true };
+            return raw;
         }
-        return _values[index];
+        t.lastMs = nowMs;
+
+        t.pos = predicted + _alpha * residual;
+        if (dt > 0) t.vel += _beta * residual / dt;
+        t.vel += _speedGain * (speed - t.vel);
+
+        if (t.pos < 0) t.pos = 0;
+        return t.pos;
     }
 
     void reset(int index) {
-        _values[index] = -1.0f;
+        _tracks[index].active = false;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
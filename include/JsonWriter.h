@@ -0,0 +1,172 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Allocation-free JSON writer over a caller supplied buffer.
+// Commas are inserted automatically, every append is bounds checked and
+// the buffer always stays NUL terminated. On overflow further writes are
+// dropped and ok() returns false, so callers never send half a document
+// thinking it is complete.
+class JsonWriter {
+private:
+    static const int MAX_DEPTH = 8;
+
+    char  *_buf;
+    size_t _cap;
+    size_t _len = 0;
+    bool   _overflow = false;
+    int    _depth = 0;
+    bool   _first[MAX_DEPTH + 1];
+
+    void put(char c) {
+        if (_overflow) return;
+        if (_len + 1 >= _cap) { _overflow = true; return; }
+        _buf[_len++] = c;
+        _buf[_len] = '\0';
+    }
+
+    void put(const char *s, size_t n) {
+        if (_overflow) return;
+        if (_len + n >= _cap) { _overflow = true; return; }
+        memcpy(_buf + _len, s, n);
+        _len += n;
+        _buf[_len] = '\0';
+    }
+
+    // Separator before a new element of the current container
+    void element() {
+        if (_first[_depth]) _first[_depth] = false;
+        else put(',');
+    }
+
+    void open(char c) {
+        put(c);
+        if (_depth < MAX_DEPTH) _depth++;
+        else _overflow = true;
+        _first[_depth] = true;
+    }
+
+    void close(char c) {
+        if (_depth > 0) _depth--;
+        put(c);
+    }
+
+    void putKey(const char *key) {
+        element();
+        put('"');
+        put(key, strlen(key));
+        put("\":", 2);
+    }
+
+    void putUnsigned(uint32_t v) {
+        char tmp[10];
+        int n = 0;
+        do {
+            tmp[n++] = '0' + (v % 10);
+            v /= 10;
+        } while (v);
+        if (_overflow) return;
+        if (_len + n >= _cap) { _overflow = true; return; }
+        while (n) _buf[_len++] = tmp[--n];
+        _buf[_len] = '\0';
+    }
+
+    void putUnsigned64(uint64_t v) {
+        char tmp[20];
+        int n = 0;
+        do {
+            tmp[n++] = '0' + (v % 10);
+            v /= 10;
+        } while (v);
+        if (_overflow) return;
+        if (_len + n >= _cap) { _overflow = true; return; }
+        while (n) _buf[_len++] = tmp[--n];
+        _buf[_len] = '\0';
+    }
+
+    void putSigned(int32_t v) {
+        if (v < 0) {
+            put('-');
+            putUnsigned((uint32_t)0 - (uint32_t)v);
+        } else {
+            putUnsigned((uint32_t)v);
+        }
+    }
+
+    // Fixed point, rounded to `decimals` places (0-6)
+    void putFixed(float v, uint8_t decimals) {
+        static const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+        if (decimals > 6) decimals = 6;
+        if (v != v) { put('0'); return; } // NaN is not valid JSON
+
+        bool neg = v < 0;
+        if (neg) v = -v;
+        if (v > 4.0e9f / POW10[decimals]) { _overflow = true; return; }
+
+        uint32_t scaled = (uint32_t)(v * POW10[decimals] + 0.5f);
+        uint32_t whole = scaled / POW10[decimals];
+        uint32_t frac  = scaled % POW10[decimals];
+
+        if (neg && scaled) put('-');
+        putUnsigned(whole);
+        if (!decimals) return;
+
+        put('.');
+        for (uint32_t p = POW10[decimals] / 10; p > 0; p /= 10) {
+            put('0' + (frac / p) % 10);
+        }
+    }
+
+    void putString(const char *s) {
+        put('"');
+        for (; *s; s++) {
+            char c = *s;
+            if (c == '"' || c == '\\') { put('\\'); put(c); }
+            else if ((uint8_t)c < 0x20) put(' ');
+            else put(c);
+        }
+        put('"');
+    }
+
+public:
+    JsonWriter(char *buf, size_t cap) : _buf(buf), _cap(cap) {
+        _first[0] = true;
+        if (_cap) _buf[0] = '\0';
+        else _overflow = true;
+    }
+
+    // ---- containers ----
+    JsonWriter &beginObject()                { element(); open('{'); return *this; }
+    JsonWriter &beginObject(const char *key) { putKey(key); open('{'); return *this; }
+    JsonWriter &endObject()                  { close('}'); return *this; }
+    JsonWriter &beginArray(const char *key)  { putKey(key); open('['); return *this; }
+    JsonWriter &endArray()                   { close(']'); return *this; }
+
+    // ---- object members ----
+    JsonWriter &field(const char *key, int32_t v)      { putKey(key); putSigned(v); return *this; }
+    JsonWriter &fieldU(const char *key, uint32_t v)    { putKey(key); putUnsigned(v); return *this; }
+    JsonWriter &field64(const char *key, int64_t v) {
+        putKey(key);
+        if (v < 0) { put('-'); putUnsigned64((uint64_t)0 - (uint64_t)v); }
+        else putUnsigned64((uint64_t)v);
+        return *this;
+    }
+    JsonWriter &fieldBool(const char *key, bool v)     { putKey(key); put(v ? '1' : '0'); return *this; } // 1/0 like the rest of the API
+    JsonWriter &fieldStr(const char *key, const char *v) { putKey(key); putString(v); return *this; }
+    JsonWriter &fieldFixed(const char *key, float v, uint8_t decimals) {
+        putKey(key); putFixed(v, decimals); return *this;
+    }
+
+    // ---- array values ----
+    JsonWriter &value(int32_t v)   { element(); putSigned(v); return *this; }
+    JsonWriter &valueU(uint32_t v) { element(); putUnsigned(v); return *this; }
+
+    const char *c_str() const { return _buf; }
+    size_t length() const { return _len; }
+    bool ok() const { return !_overflow && _depth == 0; }
+};
+
+#endif
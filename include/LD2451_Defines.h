@@ -7,14 +7,28 @@
 const uint8_t DATA_FRAME_HEADER[] = {0xF4, 0xF3, 0xF2, 0xF1};
 const uint8_t DATA_FRAME_FOOTER[] = {0xF8, 0xF7, 0xF6, 0xF5};
 
+// Targets reported per sensor by the LD2451
+#define RADAR_MAX_TARGETS 5
+
+// Number of LD2451 radars wired to the controller (1 = rear only, 2 = rear + side)
+#ifndef RADAR_SENSOR_COUNT
+#define RADAR_SENSOR_COUNT 1
+#endif
+
+// Size of the merged target list of all sensors
+#define RADAR_MERGED_MAX (RADAR_MAX_TARGETS * RADAR_SENSOR_COUNT)
+
 // Struct to hold target data for display and logic
 struct RadarTarget {
     uint8_t distance;    // Raw meters from radar
-    uint8_t angle;       // Raw 0-255 (128 = 0°)
+    int8_t  angle;       // Degrees, signed (0 = straight behind)
     bool    approaching; // True if moving toward sensor
     uint8_t speed;       // km/h
     uint8_t snr;         // Signal Quality
     float   smoothedDist;// Float value for FilterModule
+    uint8_t vision;      // VisionVerdict from the YOLO client (0 = unknown)
+    uint8_t motion;      // MotionVerdict from the on-device motion check (0 = unknown)
+    uint8_t sensor;      // Index of the radar that reported this target
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,142 @@
+#ifndef LINK_HEALTH_H
+#define LINK_HEALTH_H
+
+#include <Arduino.h>
+
+// Rates are computed over fixed windows from loop(); the counters themselves
+// only ever increase and are written by the ingest side (and the UART event
+// task for overruns), one writer per field.
+#define LINK_WINDOW_MS        1000
+#define LINK_MIN_FPS          5    // LD2451 sends ~10 frames/s (targets or heartbeat)
+#define LINK_MAX_ERRORS       3    // bad frames + overruns per window
+#define LINK_DEGRADE_WINDOWS  2    // consecutive bad windows before alerting
+#define LINK_RECOVER_WINDOWS  3    // consecutive good windows before clearing
+
+struct LinkCounters {
+    uint32_t bytes;          // bytes read from the UART
+    uint32_t frames;         // valid frames with payload
+    uint32_t heartbeats;     // valid empty frames
+    uint32_t resyncBytes;    // bytes discarded looking for a header
+    uint32_t badLength;      // length field above RADAR_MAX_PAYLOAD
+    uint32_t footerMismatch; // length ok, footer wrong
+    uint32_t overruns;       // UART FIFO / RX buffer overflow
+    uint32_t lineErrors;     // framing, parity, break
+    uint32_t frameBytes;     // bytes of the valid frames with payload
+    uint32_t ingestUs;       // time spent reading and parsing
+};
+
+// Results of the last closed window (loop side)
+struct LinkWindow {
+    bool        degraded;
+    const char *reason;
+    uint16_t    fpsX10;
+    uint16_t    errors;
+    uint16_t    cpuPermille;
+};
+
+enum LinkEvent : uint8_t {
+    LINK_EVENT_NONE = 0,
+    LINK_EVENT_DEGRADED,
+    LINK_EVENT_RECOVERED
+};
+
+class LinkHealth {
+private:
+    LinkCounters _last = {};
+    unsigned long _windowStart = 0;
+
+    // Inter-frame timing (ingest side)
+    unsigned long _lastFrameMs = 0;
+    float _intervalMs = 0;
+    float _jitterMs = 0;
+
+    // Window results (loop side)
+    uint16_t _fpsX10 = 0;
+    uint16_t _errorsPerWindow = 0;
+    uint16_t _cpuPermille = 0;
+    uint8_t _badWindows = 0;
+    uint8_t _goodWindows = 0;
+    bool _degraded = false;
+    const char *_reason = "ok";
+
+    static uint32_t errorsOf(const LinkCounters &c) {
+        return c.badLength + c.footerMismatch + c.overruns + c.lineErrors;
+    }
+
+public:
+    LinkCounters counters = {};
+
+    // A valid frame (data or heartbeat) was cut out of the stream.
+    // Jitter is the smoothed deviation from the mean interval (RFC 3550 style),
+    // so its resolution is the ingest cadence.
+    void onFrame(unsigned long now) {
+        if (_lastFrameMs) {
+            float interval = now - _lastFrameMs;
+            if (_intervalMs == 0) _intervalMs = interval;
+            float dev = interval - _intervalMs;
+            if (dev < 0) dev = -dev;
+            _intervalMs += (interval - _intervalMs) / 16.0f;
+            _jitterMs += (dev - _jitterMs) / 16.0f;
+        }
+        _lastFrameMs = now;
+    }
+
+    // Close the window when due, c being a copy of counters taken by the
+    // caller (see RadarSensor::linkStats). Returns an event on a
+    // degraded/recovered edge.
+    LinkEvent update(unsigned long now, const LinkCounters &c) {
+        // First call, or counters reset by a rate negotiation: start over
+        if (!_windowStart || c.bytes < _last.bytes) {
+            _windowStart = now;
+            _last = c;
+            return LINK_EVENT_NONE;
+        }
+
+        unsigned long elapsed = now - _windowStart;
+        if (elapsed < LINK_WINDOW_MS) return LINK_EVENT_NONE;
+
+        uint32_t frames = (c.frames - _last.frames) + (c.heartbeats - _last.heartbeats);
+        uint32_t errors = errorsOf(c) - errorsOf(_last);
+        _fpsX10 = frames * 10000 / elapsed;
+        _errorsPerWindow = errors;
+        _cpuPermille = (c.ingestUs - _last.ingestUs) / elapsed; // us per ms
+        _last = c;
+        _windowStart = now;
+
+        const char *reason = nullptr;
+        if (frames == 0) reason = "silent";
+        else if (_fpsX10 < LINK_MIN_FPS * 10) reason = "slow";
+        else if (errors > LINK_MAX_ERRORS) reason = "errors";
+
+        if (reason) {
+            _goodWindows = 0;
+            if (_badWindows < 255) _badWindows++;
+            if (!_degraded && _badWindows >= LINK_DEGRADE_WINDOWS) {
+                _degraded = true;
+                _reason = reason;
+                return LINK_EVENT_DEGRADED;
+            }
+            if (_degraded) _reason = reason;
+        } else {
+            _badWindows = 0;
+            if (_goodWindows < 255) _goodWindows++;
+            if (_degraded && _goodWindows >= LINK_RECOVER_WINDOWS) {
+                _degraded = false;
+                _reason = "ok";
+                return LINK_EVENT_RECOVERED;
+            }
+        }
+        return LINK_EVENT_NONE;
+    }
+
+    uint16_t fpsX10() const { return _fpsX10; }
+    uint16_t errorsPerWindow() const { return _errorsPerWindow; }
+    uint16_t cpuPermille() const { return _cpuPermille; }
+    float intervalMs() const { return _intervalMs; }
+    float jitterMs() const { return _jitterMs; }
+    bool degraded() const { return _degraded; }
+    LinkWindow window() const { return { _degraded, _reason, _fpsX10, _errorsPerWindow, _cpuPermille }; }
+    const char *reason() const { return _reason; }
+};
+
+#endif
@@ -0,0 +1,330 @@
+#ifndef MOTION_FILTER_H
+#define MOTION_FILTER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "LD2451_Defines.h"
+
+// Cheap on-device visual check of radar targets, long before a YOLO verdict
+// can come back. The stream task decodes a low resolution luma image (JPEG
+// decoded at 1/4 or 1/8 scale, at most 80x60) a few times per second and
+// differences it against the previous one in 4x4 pixel blocks. loop() then
+// projects every radar target onto the image columns it should occupy and
+// tags it:
+//
+//   MOTION_SEEN    enough changing blocks in its column band
+//   MOTION_GHOST   no visual change there for MOTION_GHOST_CHECKS fresh images
+//   MOTION_UNKNOWN out of view, too far to cover a block, no fresh image, or
+//                  the whole image changed (exposure step, bump)
+//
+// The bike itself moves, so a block only counts as moving when its change is
+// well above both an absolute floor and the median change of the image.
+//
+// Two kernels compute the block SADs: a plain scalar reference and a SWAR
+// one (four pixels per 32 bit word, no per-pixel branches, plain C rather
+// than PIE / ESP-DSP). They must give identical results: test_motion_kernel
+// checks that on the host, and the stream task re-runs the scalar one every
+// MOTION_VERIFY_EVERY images to check it and to time both on the device.
+
+#define MOTION_MAX_W        80
+#define MOTION_MAX_H        60
+#define MOTION_BLOCK        4
+#define MOTION_MAX_COLS     (MOTION_MAX_W / MOTION_BLOCK)
+#define MOTION_MAX_ROWS     (MOTION_MAX_H / MOTION_BLOCK)
+#define MOTION_MAX_BLOCKS   (MOTION_MAX_COLS * MOTION_MAX_ROWS)
+
+#define MOTION_INTERVAL_MS  150  // luma images per second ~6
+#define MOTION_MAX_GAP_MS   400  // images further apart are not differenced
+#define MOTION_MAX_AGE_MS   500  // a profile older than this gives no verdict
+#define MOTION_VERIFY_EVERY 32
+
+#define MOTION_MIN_SAD      96   // 6 luma levels per pixel over a 4x4 block
+#define MOTION_REL_GAIN     2    // and twice the image median
+#define MOTION_GLOBAL_PCT   60   // more moving blocks than this: no verdict
+#define MOTION_GLOBAL_SAD   320  // or a median above 20 levels per pixel (exposure step)
+
+#define MOTION_HFOV_DEG     66   // OV3660 stock lens
+#define MOTION_MIRROR       0    // 1 if radar angle and image x run opposite ways
+#define MOTION_ANGLE_TOL    5    // radar angle uncertainty (deg)
+#define MOTION_CAR_HALF_M   0.9f
+#define MOTION_MAX_RANGE_M  25   // further away a car is under one block
+#define MOTION_MIN_BLOCKS   2
+#define MOTION_GHOST_CHECKS 3
+#define MOTION_MATCH_M      3    // distance tolerance when following a car, plus its travel
+#define MOTION_MATCH_DEG    8    // angle tolerance when following a car
+
+enum MotionVerdict : uint8_t {
+    MOTION_UNKNOWN = 0,
+    MOTION_SEEN    = 1,
+    MOTION_GHOST   = 2
+};
+
+struct LumaFrame {
+    uint16_t w;           // multiple of MOTION_BLOCK, 0 = empty
+    uint16_t h;
+    uint32_t timestampMs; // capture time
+    uint8_t  px[MOTION_MAX_W * MOTION_MAX_H] __attribute__((aligned(4)));
+};
+
+// What loop() needs from the latest image pair
+struct MotionProfile {
+    uint32_t seq;         // increments with every differenced pair
+    uint32_t frameMs;     // capture time of the newer image
+    uint8_t  cols;
+    uint8_t  rows;
+    uint8_t  moving[MOTION_MAX_COLS]; // moving blocks per grid column
+    uint16_t movingTotal;
+    uint16_t medianSad;
+    bool     global;      // too much of the image changed to judge
+};
+
+// ---------------- kernels ----------------
+// Sum of absolute differences per 4x4 block, row major, (w/4) x (h/4) values.
+
+static inline void motionSadScalar(const uint8_t *a, const uint8_t *b, int w, int h, uint16_t *sad) {
+    int cols = w / MOTION_BLOCK, rows = h / MOTION_BLOCK;
+    for (int by = 0; by < rows; by++) {
+        for (int bx = 0; bx < cols; bx++) {
+            uint32_t sum = 0;
+            for (int y = 0; y < MOTION_BLOCK; y++) {
+                const uint8_t *pa = a + (by * MOTION_BLOCK + y) * w + bx * MOTION_BLOCK;
+                const uint8_t *pb = b + (by * MOTION_BLOCK + y) * w + bx * MOTION_BLOCK;
+                for (int x = 0; x < MOTION_BLOCK; x++) {
+                    int d = pa[x] - pb[x];
+                    sum += d < 0 ? -d : d;
+                }
+            }
+            sad[by * cols + bx] = sum;
+        }
+    }
+}
+
+// |a - b| of four packed bytes without carries between lanes
+static inline uint32_t motionAbsDiff4(uint32_t a, uint32_t b) {
+    const uint32_t H = 0x80808080u;
+    uint32_t d = ((a | H) - (b & ~H)) ^ ((a ^ ~b) & H);     // a - b mod 256 per byte
+    uint32_t borrow = ((~a & b) | (~(a ^ b) & d)) & H;     // lanes where a < b
+    uint32_t m = (borrow >> 7) * 0xFF;
+    return (d ^ m) + (m & 0x01010101u);                    // negate those lanes
+}
+
+static inline void motionSadSwar(const uint8_t *a, const uint8_t *b, int w, int h, uint16_t *sad) {
+    int cols = w / MOTION_BLOCK, rows = h / MOTION_BLOCK;
+    for (int by = 0; by < rows; by++) {
+        const uint8_t *ra = a + by * MOTION_BLOCK * w;
+        const uint8_t *rb = b + by * MOTION_BLOCK * w;
+        for (int bx = 0; bx < cols; bx++) {
+            // Two 16 bit lanes, at most 4 rows * 2 bytes * 255 each
+            uint32_t acc = 0;
+            for (int y = 0; y < MOTION_BLOCK; y++) {
+                uint32_t wa, wb;
+                memcpy(&wa, ra + y * w + bx * 4, 4);
+                memcpy(&wb, rb + y * w + bx * 4, 4);
+                uint32_t d = motionAbsDiff4(wa, wb);
+                acc += (d & 0x00FF00FFu) + ((d >> 8) & 0x00FF00FFu);
+            }
+            sad[by * cols + bx] = (acc & 0xFFFF) + (acc >> 16);
+        }
+    }
+}
+
+// ---------------- stream task side ----------------
+
+class MotionDetector {
+private:
+    LumaFrame _frames[2];
+    int _cur = 0;          // index of the newest committed image
+    uint32_t _seq = 0;
+    uint16_t _sad[MOTION_MAX_BLOCKS];
+
+    static uint16_t median(const uint16_t *v, int n) {
+        // Histogram of SAD / 16 (max 4080 -> 255): exact enough, no sort
+        uint16_t hist[256] = {};
+        for (int i = 0; i < n; i++) hist[v[i] >> 4]++;
+        int need = n / 2, seen = 0;
+        for (int i = 0; i < 256; i++) {
+            seen += hist[i];
+            if (seen > need) return (i << 4) + 8;
+        }
+        return 0;
+    }
+
+public:
+    MotionDetector() {
+        _frames[0].w = _frames[1].w = 0;
+    }
+
+    // Image to decode into; becomes current on commit()
+    LumaFrame &next() { return _frames[_cur ^ 1]; }
+    const LumaFrame &current() const { return _frames[_cur]; }
+    const LumaFrame &previous() const { return _frames[_cur ^ 1]; }
+    const uint16_t *sad() const { return _sad; }
+
+    // Difference next() against the current image. Returns false when there
+    // is no comparable previous image (size change, gap); out is untouched.
+    bool commit(MotionProfile &out) {
+        const LumaFrame &a = _frames[_cur];
+        const LumaFrame &b = _frames[_cur ^ 1];
+        bool comparable = a.w && a.w == b.w && a.h == b.h &&
+                          b.timestampMs - a.timestampMs <= MOTION_MAX_GAP_MS;
+        _cur ^= 1;
+        if (!comparable) return false;
+
+        int cols = b.w / MOTION_BLOCK, rows = b.h / MOTION_BLOCK, n = cols * rows;
+        motionSadSwar(a.px, b.px, b.w, b.h, _sad);
+
+        uint16_t med = median(_sad, n);
+        uint32_t threshold = med * MOTION_REL_GAIN;
+        if (threshold < MOTION_MIN_SAD) threshold = MOTION_MIN_SAD;
+
+        out.seq = ++_seq;
+        out.frameMs = b.timestampMs;
+        out.cols = cols;
+        out.rows = rows;
+        out.medianSad = med;
+        out.movingTotal = 0;
+        memset(out.moving, 0, sizeof(out.moving));
+        for (int y = 0; y < rows; y++) {
+            for (int x = 0; x < cols; x++) {
+                if (_sad[y * cols + x] >= threshold) { out.moving[x]++; out.movingTotal++; }
+            }
+        }
+        out.global = out.movingTotal * 100 > n * MOTION_GLOBAL_PCT || med > MOTION_GLOBAL_SAD;
+        return true;
+    }
+};
+
+// ---------------- loop() side ----------------
+
+struct MotionStats {
+    uint32_t checks;  // target verdicts from a fresh image
+    uint32_t seen;
+    uint32_t ghosts;  // targets that turned into MOTION_GHOST
+};
+
+// The merged target list is re-ordered every frame, so the miss count and
+// verdict follow each car by sensor, distance and angle (as VisionFeedback
+// does), not by slot.
+class MotionFilter {
+private:
+    struct Track {
+        uint8_t  sensor;
+        uint8_t  distance;
+        int8_t   angle;
+        uint8_t  speed;
+        uint32_t seenMs;
+        uint8_t  misses;
+        uint8_t  verdict;
+    };
+
+    Track _tracks[RADAR_MERGED_MAX];
+    int _trackCount = 0;
+    uint32_t _lastSeq = 0;
+    MotionStats _stats = {};
+
+    // Carries each track over to the nearest free target of its sensor; cars
+    // not followed are dropped, new ones start with no verdict
+    void follow(const RadarTarget *targets, int count, uint32_t now) {
+        Track next[RADAR_MERGED_MAX];
+        bool taken[RADAR_MERGED_MAX] = {};
+
+        for (int k = 0; k < _trackCount; k++) {
+            const Track &tr = _tracks[k];
+            int travel = (int)((uint32_t)tr.speed * (now - tr.seenMs) / 3600);
+            int best = -1, bestCost = 0;
+            for (int i = 0; i < count; i++) {
+                const RadarTarget &t = targets[i];
+                if (taken[i] || t.sensor != tr.sensor) continue;
+                int dd = abs((int)t.distance - tr.distance);
+                int da = abs((int)t.angle - tr.angle);
+                if (dd > MOTION_MATCH_M + travel || da > MOTION_MATCH_DEG) continue;
+                int cost = dd * 4 + da;
+                if (best < 0 || cost < bestCost) { best = i; bestCost = cost; }
+            }
+            if (best < 0) continue;
+            taken[best] = true;
+            next[best] = tr;
+        }
+        for (int i = 0; i < count; i++) {
+            if (!taken[i]) next[i] = { 0, 0, 0, 0, 0, 0, MOTION_UNKNOWN };
+            next[i].sensor = targets[i].sensor;
+            next[i].distance = targets[i].distance;
+            next[i].angle = targets[i].angle;
+            next[i].speed = targets[i].speed;
+            next[i].seenMs = now;
+        }
+        memcpy(_tracks, next, count * sizeof(Track));
+        _trackCount = count;
+    }
+
+public:
+    // Grid columns [c0, c1) a target at this angle and range covers.
+    // False when it is out of view or too far to judge.
+    static bool project(int angleDeg, int distanceM, int cols, int &c0, int &c1) {
+        if (distanceM <= 0 || distanceM > MOTION_MAX_RANGE_M) return false;
+        const float rad = 3.14159265f / 180.0f;
+        float half = atanf(MOTION_CAR_HALF_M / distanceM) / rad + MOTION_ANGLE_TOL;
+        float scale = 0.5f / tanf(MOTION_HFOV_DEG * 0.5f * rad);
+        float a = MOTION_MIRROR ? -angleDeg : angleDeg;
+
+        float lo = a - half, hi = a + half;
+        if (hi <= -MOTION_HFOV_DEG / 2.0f || lo >= MOTION_HFOV_DEG / 2.0f) return false;
+        if (lo < -89) lo = -89;
+        if (hi > 89) hi = 89;
+
+        float x0 = (0.5f + tanf(lo * rad) * scale) * cols;
+        float x1 = (0.5f + tanf(hi * rad) * scale) * cols;
+        c0 = x0 < 0 ? 0 : (int)x0;
+        c1 = x1 > cols ? cols : (int)ceilf(x1);
+        return c1 > c0;
+    }
+
+    // Called from loop() after every parsed frame, like VisionFeedback::apply.
+    // Verdicts only advance on a new image. Returns the index of a target that
+    // just became a likely ghost, -1 if none did.
+    int apply(RadarTarget *targets, int count, const MotionProfile &p, bool valid, uint32_t now) {
+        bool fresh = valid && p.seq != _lastSeq;
+        bool usable = valid && !p.global && now - p.frameMs <= MOTION_MAX_AGE_MS;
+        if (fresh) _lastSeq = p.seq;
+
+        if (count > RADAR_MERGED_MAX) count = RADAR_MERGED_MAX;
+        follow(targets, count, now);
+
+        int newGhost = -1;
+        for (int i = 0; i < count; i++) {
+            Track &tr = _tracks[i];
+            int c0, c1;
+            if (!usable || !project(targets[i].angle, targets[i].distance, p.cols, c0, c1)) {
+                tr.misses = 0;
+                tr.verdict = MOTION_UNKNOWN;
+            } else if (fresh) {
+                int moving = 0;
+                for (int c = c0; c < c1; c++) moving += p.moving[c];
+                _stats.checks++;
+
+                if (moving >= MOTION_MIN_BLOCKS) {
+                    tr.misses = 0;
+                    tr.verdict = MOTION_SEEN;
+                    _stats.seen++;
+                } else if (++tr.misses >= MOTION_GHOST_CHECKS) {
+                    tr.misses = MOTION_GHOST_CHECKS;
+                    if (tr.verdict != MOTION_GHOST) { _stats.ghosts++; if (newGhost < 0) newGhost = i; }
+                    tr.verdict = MOTION_GHOST;
+                }
+            }
+            targets[i].motion = tr.verdict;
+        }
+        return newGhost;
+    }
+
+    // Targets gone (persistence timeout): the next ones start from scratch
+    void reset() {
+        _trackCount = 0;
+    }
+
+    const MotionStats &stats() const { return _stats; }
+};
+
+#endif
@@ -6,15 +6,48 @@
 #include "esp_camera.h"
 #include "LD2451_Defines.h"
 #include "StreamServer.h"
+#include "VisionFeedback.h"
+#include "MotionFilter.h"
+#include "DisplayModule.h"
+#include "RadarSnapshot.h"
+#include "RadarMessage.h"
+#include "JsonWriter.h"
+#include "WsTopics.h"
+#include "RawTap.h"
+#include "RadarSensor.h"
+#include "PowerPolicy.h"
+#include "UdpTelemetry.h"
+#include "ClockSync.h"
+#include "EventLog.h"
+#include "ExclusionZones.h"
+#include "CommandMailbox.h"
+#include "WebAssets.h" // generated from web/ by tools/build_web.py
+#include <memory>
+#include <new>
+#include <vector>
+
+// loop()'s own stats for /stats, published by loop() every pass because
+// GET /stats is served on the async_tcp task
+struct LoopStats {
+    PowerState   powerState;
+    uint16_t     cpuMhz;
+    uint32_t     powerTimeIn[POWER_STATE_COUNT];
+    uint32_t     powerTransitions;
+    MotionStats  motion;
+    DisplayStats display;
+    LinkWindow   link[RADAR_SENSOR_COUNT];
+};
 
 // -------- EXTERNALS FROM MAIN --------
-extern bool yoloVetoActive;
-extern int globalTargetCount;
-extern RadarTarget activeTargets[];
-extern bool debugMode;
-extern int rawDebugLen;
-extern uint8_t rawDebugBuffer[];
-extern unsigned long lastValidRadarTime;
+extern VisionFeedback vision;
+extern MotionFilter motionFilter;
+extern DisplayModule ui;
+extern EventLog eventLog;
+extern ExclusionMap exclusions;
+extern SeqLock<RadarSnapshot> radarSnapshot; // consistent copy of the loop() targets
+extern SeqLock<LoopStats> loopStats;
+extern RadarSensor radars[];
+extern PowerPolicy power;
 extern uint32_t cameraTimerMs;
 
 // Radar Config
@@ -25,17 +58,338 @@ extern uint8_t cfg_delay_time;
 extern uint8_t cfg_trigger_acc;
 extern uint8_t cfg_snr_limit;
 extern uint8_t cfg_rapid_threshold;
-extern bool radarUpdatePending;
-extern void exitLowPowerMode();
+extern uint8_t cfg_display_fps;
+extern uint8_t cfg_clutter;
+extern uint32_t cfg_radar_baud[];
+extern CommandMailbox loopCommands; // applied by loop(), see CommandMailbox.h
 
 class NetworkManager {
 private:
     AsyncWebServer _server;
     AsyncWebSocket _ws;
+    WsSubscriptions _subs;
+    UdpTelemetry _udp;
+    ClockSync _clock;
+    unsigned long _lastSync = 0;
     unsigned long _lastHeartbeat = 0;
+    unsigned long _lastStats = 0;
     static const unsigned long HEARTBEAT_INTERVAL = 5000;
-    // Fixed JSON buffer (no heap fragmentation)
-    char radarJson[1024];
+    static const unsigned long STATS_INTERVAL = 1000;
+    // Fixed serialization buffer (no heap fragmentation), only used from loop()
+    static const size_t STATS_JSON_SIZE = 3072 * RADAR_SENSOR_COUNT;
+    char _scratch[STATS_JSON_SIZE];
+
+    // Raw tap binary layout: 'U', version, sensor, uint32 timestamp, uint32 dropped bytes, then UART bytes
+    static const uint8_t RAW_BIN_TYPE = 0x55;
+    static const uint8_t RAW_BIN_VERSION = 1;
+    static const size_t RAW_CHUNK = 512;
+
+    // Shared by GET /stats and the stats topic
+    void writeStats(JsonWriter &w) {
+        VisionStats vs = vision.stats();
+        CameraWakeStats cam = getCameraWakeStats();
+        StreamStats st = getStreamStats();
+        MotionKernelStats mk = getMotionKernelStats();
+        LoopStats lp;
+        loopStats.read(lp);
+        const MotionStats &ms = lp.motion;
+        const DisplayStats &ds = lp.display;
+        EventLogStats ls = eventLog.stats();
+        ExclusionZone zones[ZONE_MAX];
+        uint32_t zoneHits[ZONE_MAX];
+        int zoneCount = exclusions.copy(zones, zoneHits);
+        MailboxStats loopCmd = loopCommands.stats();
+        MailboxStats camCmd = getCameraCommandStats();
+
+        w.beginObject()
+            .fieldStr("type", "stats")
+            .fieldU("uptime", millis())
+            .fieldU("heap", ESP.getFreeHeap())
+            .fieldU("minHeap", ESP.getMinFreeHeap())
+            .fieldU("wsClients", _ws.count())
+            .fieldU("frame", radarSnapshot.version())
+            .beginObject("vision")
+                .fieldU("applied", vs.applied)
+                .fieldU("late", vs.late)
+                .fieldU("lastMs", vs.lastMs)
+                .fieldU("avgMs", vs.avgMs)
+            .endObject()
+            .beginObject("motion")
+                .fieldU("images", mk.images)
+                .fieldU("pairs", mk.pairs)
+                .fieldU("width", mk.width)
+                .fieldU("height", mk.height)
+                .fieldU("decodeUs", mk.decodeUs)
+                .fieldU("kernelUs", mk.kernelUs)
+                .fieldU("scalarUs", mk.scalarUs)
+                .fieldU("verified", mk.verified)
+                .fieldU("mismatches", mk.mismatches)
+                .fieldU("checks", ms.checks)
+                .fieldU("seen", ms.seen)
+                .fieldU("ghosts", ms.ghosts)
+            .endObject()
+            .beginObject("display")
+                .fieldU("fps", cfg_display_fps)
+                .fieldU("frames", ds.frames)
+                .fieldU("radarFrames", ds.radarFrames)
+                .fieldU("renderUs", ds.renderUs)
+                .fieldU("maxRenderUs", ds.maxRenderUs)
+                .fieldU("overruns", ds.overruns)
+            .endObject()
+            .beginObject("zones")
+                .fieldU("count", zoneCount)
+                .fieldU("suppressed", exclusions.suppressed())
+                .beginArray("hits");
+        for (int i = 0; i < zoneCount; i++) w.valueU(zoneHits[i]);
+        w.endArray()
+            .endObject()
+            .beginObject("log")
+                .fieldU("boot", ls.boot)
+                .fieldU("segments", eventLog.segments())
+                .fieldU("pending", eventLog.pending())
+                .fieldU("queued", ls.queued)
+                .fieldU("written", ls.written)
+                .fieldU("flushes", ls.flushes)
+                .fieldU("dropped", ls.dropped)
+                .fieldU("errors", ls.errors)
+                .fieldU("rotations", ls.rotations)
+            .endObject()
+            .beginObject("commands");
+        writeMailbox(w, "loop", loopCmd);
+        writeMailbox(w, "camera", camCmd);
+        w.endObject()
+            .beginObject("power")
+                .fieldStr("state", PowerPolicy::name(lp.powerState))
+                .fieldU("cpuMhz", lp.cpuMhz)
+                .fieldU("activeMs", lp.powerTimeIn[POWER_ACTIVE])
+                .fieldU("idleMs", lp.powerTimeIn[POWER_IDLE])
+                .fieldU("standbyMs", lp.powerTimeIn[POWER_STANDBY])
+                .fieldU("transitions", lp.powerTransitions)
+            .endObject()
+            .beginObject("camera")
+                .fieldBool("standby", isLowPower())
+                .fieldU("standbys", cam.standbys)
+                .fieldU("wakes", cam.wakes)
+                .fieldU("wakeLastMs", cam.lastMs)
+                .fieldU("wakeAvgMs", cam.avgMs)
+                .fieldU("wakeMaxMs", cam.maxMs)
+            .endObject()
+            .beginObject("stream")
+                .fieldU("clients", streamClientCount())
+                .fieldFixed("fps", st.fpsX10 / 10.0f, 1)
+                .fieldU("captured", st.framesCaptured)
+                .fieldU("sent", st.framesSent)
+                .fieldU("skipped", st.framesSkipped)
+                .fieldU("dropped", st.clientsDropped)
+                .fieldU("behind", st.clientsBehind)
+                .fieldU("copies", st.frameCopies)
+                .fieldU("sendUs", st.lastSendUs)
+                .fieldU("sendAvgUs", st.avgSendUs)
+                .fieldU("kbps", st.kbps)
+                .fieldU("level", st.rateLevel)
+                .fieldU("levelChanges", st.rateChanges)
+                .fieldU("quality", st.quality)
+                .fieldU("width", st.width)
+                .fieldU("height", st.height)
+            .endObject()
+            .beginObject("udp")
+                .field("clients", _udp.count(millis()))
+                .fieldU("seq", _udp.stats().seq)
+                .fieldU("packets", _udp.stats().packets)
+                .fieldU("errors", _udp.stats().errors)
+            .endObject()
+            .beginArray("tap");
+
+        for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+            w.beginObject()
+                .fieldBool("on", radars[i].tap.enabled())
+                .fieldU("bytes", radars[i].tap.teed())
+                .fieldU("dropped", radars[i].tap.dropped())
+            .endObject();
+        }
+
+        w.endArray().beginArray("link");
+
+        for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+            const LinkWindow &h = lp.link[i];
+            RadarLinkStats rs = radars[i].linkStats();
+            const LinkCounters &c = rs.counters;
+            w.beginObject()
+                .fieldBool("degraded", h.degraded)
+                .fieldStr("reason", h.reason)
+                .fieldFixed("fps", h.fpsX10 / 10.0f, 1)
+                .fieldU("errors", h.errors)
+                .fieldFixed("intervalMs", rs.intervalMs, 1)
+                .fieldFixed("jitterMs", rs.jitterMs, 1)
+                .fieldU("bytes", c.bytes)
+                .fieldU("frames", c.frames)
+                .fieldU("heartbeats", c.heartbeats)
+                .fieldU("resync", c.resyncBytes)
+                .fieldU("badLen", c.badLength)
+                .fieldU("footer", c.footerMismatch)
+                .fieldU("overruns", c.overruns)
+                .fieldU("lineErr", c.lineErrors)
+                .fieldU("baud", radars[i].baud())
+                .fieldU("wireUs", c.frames ? (uint32_t)((uint64_t)c.frameBytes * 10000000 / c.frames / radars[i].baud()) : 0)
+                .fieldFixed("cpuPct", h.cpuPermille / 10.0f, 1)
+                .beginArray("probes");
+            BaudProbe probes[RADAR_BAUD_RATES];
+            int probeCount = radars[i].baudProbes(probes);
+            for (int p = 0; p < probeCount; p++) {
+                w.beginObject()
+                    .fieldU("baud", probes[p].baud)
+                    .fieldBool("ok", probes[p].ok)
+                    .fieldU("readUs", probes[p].readUs)
+                .endObject();
+            }
+            w.endArray()
+            .endObject();
+        }
+
+        w.endArray().beginArray("clutter");
+
+        for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+            ClutterStats cs = radars[i].linkStats().clutter;
+            w.beginObject()
+                .fieldU("mode", cfg_clutter)
+                .fieldU("bins", cs.bins)
+                .fieldU("frames", cs.frames)
+                .fieldU("slow", cs.slow)
+                .fieldU("matched", cs.matched)
+                .fieldU("suppressed", cs.suppressed)
+            .endObject();
+        }
+
+        w.endArray().endObject();
+    }
+
+    // One serialization per distinct (format, fields), see WsSubscriptions::fanOut
+    template <typename Serializer>
+    void fanOut(uint8_t topic, bool perFormat, Serializer serialize) {
+        _subs.fanOut(topic, perFormat, (const uint8_t*)_scratch, serialize,
+                     [this](uint32_t clientId, const WsBuffer &buf, bool binary) {
+            AsyncWebSocketClient *c = _ws.client(clientId);
+            if (!c || c->status() != WS_CONNECTED || c->queueIsFull()) return;
+            if (binary) c->binary(buf);
+            else c->text(buf);
+        });
+    }
+
+    // GET /events reader: pulls EVENT_BATCH records at a time off flash as the
+    // client drains the response, so the log is never held in RAM
+    struct EventStream {
+        EventQuery query;
+        EventCursor cursor;
+        bool binary = false;
+        bool closed = false;
+        char text[EVENT_BATCH * 192 + 4];
+        size_t len = 0;
+        size_t pos = 0;
+    };
+
+    static void writeMailbox(JsonWriter &w, const char *name, const MailboxStats &s) {
+        w.beginObject(name)
+            .fieldU("posted", s.posted)
+            .fieldU("full", s.full)
+            .fieldU("pending", s.posted > s.drained ? s.posted - s.drained : 0) // counters of two tasks
+            .fieldU("applies", s.applies)
+            .fieldU("coalesced", s.drained > s.applies ? s.drained - s.applies : 0)
+        .endObject();
+    }
+
+    // 200 as before, the body now carries the ticket for GET /cmd;
+    // 503 when the owner's queue is full
+    static void sendTicket(AsyncWebServerRequest *request, uint32_t ticket) {
+        if (!ticket) {
+            request->send(503, "text/plain", "BUSY");
+            return;
+        }
+        char json[32];
+        JsonWriter w(json, sizeof(json));
+        w.beginObject().fieldU("ticket", ticket).endObject();
+        request->send(200, "application/json", json);
+    }
+
+    static void writeEvent(JsonWriter &w, const EventRecord &r) {
+        w.beginObject()
+            .fieldStr("kind", EventLog::kindName(r.kind))
+            .fieldU("boot", r.boot)
+            .fieldU("ms", r.startMs)
+            .field64("unix", r.unixMs)
+            .fieldU("durationMs", r.durationMs)
+            .fieldU("peakSpeed", r.peakSpeed)
+            .fieldU("minDist", r.minDist)
+            .field("angle", r.angle)
+            .fieldU("sensor", r.sensor)
+            .fieldU("flags", r.flags)
+        .endObject();
+    }
+
+    // Next piece of the response into s.text; false once everything was sent
+    static bool refillEvents(EventStream &s) {
+        s.len = s.pos = 0;
+        if (s.closed) return false;
+
+        EventRecord batch[EVENT_BATCH];
+        size_t n = eventLog.read(s.cursor, s.query, batch, EVENT_BATCH);
+        if (s.binary) {
+            if (!n) { s.closed = true; return false; }
+            memcpy(s.text, batch, n * sizeof(EventRecord));
+            s.len = n * sizeof(EventRecord);
+            return true;
+        }
+
+        bool first = s.cursor.matched == n;
+        if (first) s.text[s.len++] = '[';
+        for (size_t i = 0; i < n; i++) {
+            if (!first || i) s.text[s.len++] = ',';
+            JsonWriter w(s.text + s.len, sizeof(s.text) - s.len - 2);
+            writeEvent(w, batch[i]);
+            s.len += w.length();
+        }
+        if (s.cursor.done) {
+            s.text[s.len++] = ']';
+            s.closed = true;
+        }
+        return true;
+    }
+
+    // Estimate as sent to clients, see ClockSync::toClientUs():
+    //   client_us = device_us + offsetUs + driftPpm / 1e6 * (device_us - refUs)
+    static void writeClock(JsonWriter &w, const ClientClock &c) {
+        w.fieldU("id", c.clientId)
+            .field64("offsetUs", (int64_t)c.offsetUs)
+            .field64("refUs", c.refUs)
+            .fieldFixed("driftPpm", c.drift * 1e6f, 2)
+            .fieldU("rttUs", c.lastRttUs)
+            .fieldU("minRttUs", c.minRttUs)
+            .fieldU("exchanges", c.exchanges);
+    }
+
+    void sendUdp(const RadarSnapshot &snap) {
+        uint8_t record[RADAR_BIN_MAX];
+        size_t n = radarMessageBinary(snap, record);
+        _udp.send(record, n, millis());
+    }
+
+    // Gzipped asset straight from flash. The ETag is a hash of the content,
+    // so "no-cache" only costs a 304 round trip when nothing changed.
+    static void serveAsset(AsyncWebServerRequest *request, const WebAsset &asset) {
+        if (request->hasHeader("If-None-Match") &&
+            request->header("If-None-Match") == asset.etag) {
+            AsyncWebServerResponse *response = request->beginResponse(304);
+            response->addHeader("ETag", asset.etag);
+            request->send(response);
+            return;
+        }
+
+        AsyncWebServerResponse *response =
+            request->beginResponse_P(200, asset.type, asset.data, asset.len);
+        response->addHeader("Content-Encoding", "gzip");
+        response->addHeader("ETag", asset.etag);
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+    }
 
 public:
     NetworkManager() 
@@ -50,45 +404,89 @@ public:
             _ws.onEvent([this](AsyncWebSocket *server,AsyncWebSocketClient *client,AwsEventType type,void *arg,uint8_t *data,size_t len) {
                 if (type == WS_EVT_CONNECT) {
                     Serial.printf("WS client #%u connected\n", client->id());
+                    if (!_subs.add(client->id())) client->close(1013); // table full, try again later
+                    else _clock.add(client->id());
                 }
                 if (type == WS_EVT_DISCONNECT) {
                     Serial.printf("WS client #%u disconnected\n", client->id());
+                    _subs.remove(client->id());
+                    _clock.remove(client->id());
+                }
+                if (type == WS_EVT_DATA) {
+                    int64_t rxUs = esp_timer_get_time(); // t4 of a clock exchange
+                    AwsFrameInfo *info = (AwsFrameInfo*)arg;
+                    // Only single-frame messages (feedback and subscriptions are tiny)
+                    if (!info->final || info->index != 0 || info->len != len) return;
+
+                    if (info->opcode == WS_BINARY) {
+                        vision.ingest(data, len);
+                    }
+                    else if (info->opcode == WS_TEXT && ClockSync::isReply((const char*)data, len)) {
+                        // "sync=t1,t2,t3": answer with the updated estimate
+                        ClientClock c;
+                        if (_clock.reply(client->id(), (const char*)data, len, rxUs, c)) {
+                            char json[192];
+                            JsonWriter w(json, sizeof(json));
+                            writeClock(w.beginObject().fieldStr("type", "sync_result"), c);
+                            w.endObject();
+                            client->text(json);
+                        }
+                    }
+                    else if (info->opcode == WS_TEXT) {
+                        // "topics=radar,stats;fmt=json;fields=distance,speed"
+                        WsSubscription sub;
+                        if (_subs.configure(client->id(), (const char*)data, len, sub)) {
+                            char json[96];
+                            JsonWriter w(json, sizeof(json));
+                            w.beginObject()
+                                .fieldStr("type", "sub")
+                                .fieldU("topics", sub.topics)
+                                .fieldStr("fmt", sub.format == WS_FORMAT_BINARY ? "bin" : "json")
+                                .fieldU("fields", sub.fields)
+                            .endObject();
+                            client->text(json);
+                        }
+                    }
                 }
             }
         );
 
         _server.addHandler(&_ws);
 
-        // ------------------ ROOT ------------------
-        _server.on("/", HTTP_GET, [this](AsyncWebServerRequest *request){
-            request->send(200,"text/html",index_html);
-        });
+        // ------------------ WEB UI ------------------
+        for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+            const WebAsset *asset = &WEB_ASSETS[i];
+            _server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest *request){
+                serveAsset(request, *asset);
+            });
+        }
 
         // ------------------ CONFIG GET ------------------
         _server.on("/config", HTTP_GET, [](AsyncWebServerRequest *request){
 
-            char json[256];
-
-            snprintf(json, sizeof(json),
-                "{"
-                "\"dist\":%u,"
-                "\"dir\":%u,"
-                "\"speed\":%u,"
-                "\"delay\":%u,"
-                "\"acc\":%u,"
-                "\"snr\":%u,"
-                "\"rapid\":%u,"
-                "\"camTimer\":%lu"
-                "}",
-                cfg_max_dist,
-                cfg_direction,
-                cfg_min_speed,
-                cfg_delay_time,
-                cfg_trigger_acc,
-                cfg_snr_limit,
-                cfg_rapid_threshold,
-                cameraTimerMs
-            );
+            ExclusionZone zones[ZONE_MAX];
+            char spec[ZONE_SPEC_LEN];
+            ExclusionMap::format(zones, exclusions.copy(zones), spec, sizeof(spec));
+
+            char json[256 + ZONE_SPEC_LEN];
+            JsonWriter w(json, sizeof(json));
+
+            w.beginObject()
+                .fieldU("dist", cfg_max_dist)
+                .fieldU("dir", cfg_direction)
+                .fieldU("speed", cfg_min_speed)
+                .fieldU("delay", cfg_delay_time)
+                .fieldU("acc", cfg_trigger_acc)
+                .fieldU("snr", cfg_snr_limit)
+                .fieldU("rapid", cfg_rapid_threshold)
+                .fieldU("camTimer", cameraTimerMs)
+                .fieldU("displayFps", cfg_display_fps)
+                .fieldStr("zones", spec)
+                .fieldU("clutter", cfg_clutter)
+                .beginArray("baud");
+            for (int i = 0; i < RADAR_SENSOR_COUNT; i++) w.valueU(radars[i].baud());
+            w.endArray()
+            .endObject();
 
             request->send(200, "application/json", json);
         });
@@ -96,69 +494,326 @@ public:
         // ------------------ CAMERA COMMANDS ------------------
         _server.on("/cam", HTTP_GET, [](AsyncWebServerRequest *request){
 
-            if(request->hasParam("cmd")){
-                String cmd = request->getParam("cmd")->value();
-
-                if(cmd == "flip") {
-                    sensor_t * s = esp_camera_sensor_get();
-                    s->set_vflip(s, !s->status.vflip);
-                }
-                else if(cmd == "mirror") {
-                    sensor_t * s = esp_camera_sensor_get();
-                    s->set_hmirror(s, !s->status.hmirror);
-                }
-                else if(cmd == "wake") {
-                    exitLowPowerMode();
-                    lastValidRadarTime = millis();
-                }
-                else if(cmd == "reboot") {
-                    ESP.restart();
-                }
+            // The sensor belongs to the stream task, power and reboot to loop()
+            String cmd = request->hasParam("cmd") ? request->getParam("cmd")->value() : String();
+            uint32_t ticket;
+
+            if(cmd == "flip")
+                ticket = postCameraCommand(CMD_CAM_FLIP);
+            else if(cmd == "mirror")
+                ticket = postCameraCommand(CMD_CAM_MIRROR);
+            else if(cmd == "wake")
+                ticket = loopCommands.post(CMD_WAKE);
+            else if(cmd == "reboot")
+                ticket = loopCommands.post(CMD_REBOOT);
+            else {
+                request->send(200, "text/plain", "OK"); // unknown or missing cmd: nothing to do, as always
+                return;
             }
 
-            request->send(200,"text/plain","OK");
+            sendTicket(request, ticket);
         });
 
         // ------------------ CONFIG POST ------------------
+        // Validated and clamped here, written to the cfg_* globals by loop()
         _server.on("/config", HTTP_POST, [](AsyncWebServerRequest *request){
+            Command cmd;
+            cmd.type = CMD_CONFIG;
+            ConfigPatch &p = cmd.config;
+            p.set = 0;
+            p.zonesSet = false;
+
+            if(request->hasParam("zones", true)) {
+                int n = ExclusionMap::parse(request->getParam("zones", true)->value().c_str(), p.zones);
+                if (n < 0) {
+                    request->send(400, "text/plain", "BAD ZONES");
+                    return;
+                }
+                p.zonesSet = true;
+                p.zoneCount = n;
+            }
             if(request->hasParam("max_distance", true))
-                cfg_max_dist = constrain(request->getParam("max_distance", true)->value().toInt(),1,100);
+                p.put(CFG_MAX_DIST, constrain(request->getParam("max_distance", true)->value().toInt(),1,100));
             if(request->hasParam("direction_mode", true))
-                cfg_direction = constrain(request->getParam("direction_mode", true)->value().toInt(),0,2);
+                p.put(CFG_DIRECTION, constrain(request->getParam("direction_mode", true)->value().toInt(),0,2));
             if(request->hasParam("min_speed", true))
-                cfg_min_speed = constrain(request->getParam("min_speed", true)->value().toInt(),0,120);
+                p.put(CFG_MIN_SPEED, constrain(request->getParam("min_speed", true)->value().toInt(),0,120));
             if(request->hasParam("trigger_delay_ms", true))
-                cfg_delay_time = constrain(request->getParam("trigger_delay_ms", true)->value().toInt(),0,30);
+                p.put(CFG_DELAY_TIME, constrain(request->getParam("trigger_delay_ms", true)->value().toInt(),0,30));
             if(request->hasParam("trigger_acc", true))
-                cfg_trigger_acc = constrain(request->getParam("trigger_acc", true)->value().toInt(),1,10);
+                p.put(CFG_TRIGGER_ACC, constrain(request->getParam("trigger_acc", true)->value().toInt(),1,10));
             if(request->hasParam("snr_limit", true))
-                cfg_snr_limit = constrain(request->getParam("snr_limit", true)->value().toInt(),0,255);
+                p.put(CFG_SNR_LIMIT, constrain(request->getParam("snr_limit", true)->value().toInt(),0,255));
             if(request->hasParam("rapid_threshold", true))
-                cfg_rapid_threshold = constrain(request->getParam("rapid_threshold", true)->value().toInt(),5,150);
+                p.put(CFG_RAPID_THRESHOLD, constrain(request->getParam("rapid_threshold", true)->value().toInt(),5,150));
             if(request->hasParam("camera_timer_ms", true))
-                cameraTimerMs = constrain(
+                p.put(CFG_CAMERA_TIMER, constrain(
                     request->getParam("camera_timer_ms", true)->value().toInt(),
                     3000,
                     60000
-                );
+                ));
+            if(request->hasParam("display_fps", true))
+                p.put(CFG_DISPLAY_FPS, constrain(request->getParam("display_fps", true)->value().toInt(),5,60));
+            if(request->hasParam("clutter", true))
+                p.put(CFG_CLUTTER, constrain(request->getParam("clutter", true)->value().toInt(),0,2));
+            if(request->hasParam("radar_baud", true) && request->getParam("radar_baud", true)->value().toInt() == 0)
+                p.put(CFG_RADAR_BAUD, 0); // loop() negotiates every link again from 115200
+
+            sendTicket(request, loopCommands.post(cmd));
+        });
+
+        // ------------------ COMMAND STATUS ------------------
+        // ?ticket=n from a /config or /cam answer: applied yet?
+        _server.on("/cmd", HTTP_GET, [](AsyncWebServerRequest *request){
+
+            uint32_t ticket = request->hasParam("ticket")
+                ? strtoul(request->getParam("ticket")->value().c_str(), nullptr, 10)
+                : 0;
+            if (!ticket) {
+                request->send(400, "text/plain", "BAD TICKET");
+                return;
+            }
+            bool applied = loopCommands.owns(ticket)
+                ? loopCommands.applied(ticket)
+                : cameraCommandApplied(ticket);
 
-            radarUpdatePending = true;
+            char json[64];
+            JsonWriter w(json, sizeof(json));
+            w.beginObject()
+                .fieldU("ticket", ticket)
+                .fieldBool("applied", applied)
+            .endObject();
 
-            request->send(200, "text/plain", "CONFIG UPDATED");
+            request->send(200, "application/json", json);
+        });
+
+        // ------------------ VISION FEEDBACK STATS ------------------
+        _server.on("/vision", HTTP_GET, [](AsyncWebServerRequest *request){
+
+            VisionStats st = vision.stats();
+            RadarSnapshot snap;
+            radarSnapshot.read(snap);
+            char json[192];
+            JsonWriter w(json, sizeof(json));
+
+            w.beginObject()
+                .fieldBool("veto", snap.veto)
+                .fieldU("received", st.received)
+                .fieldU("malformed", st.malformed)
+                .fieldU("late", st.late)
+                .fieldU("applied", st.applied)
+                .fieldU("lost", st.lost)
+                .fieldU("lastMs", st.lastMs)
+                .fieldU("avgMs", st.avgMs)
+                .fieldU("maxMs", st.maxMs)
+            .endObject();
+
+            request->send(200, "application/json", json);
+        });
+
+        // ------------------ BURST CAPTURE ------------------
+        // Without parameters: metadata of the last burst, ?frame=n: the JPEG itself
+        _server.on("/burst", HTTP_GET, [](AsyncWebServerRequest *request){
+
+            if (request->hasParam("frame")) {
+                size_t len = 0;
+                const uint8_t *jpeg = acquireBurstFrame(request->getParam("frame")->value().toInt(), &len);
+                if (!jpeg) {
+                    request->send(404, "text/plain", "NO FRAME");
+                    return;
+                }
+
+                // The lease keeps the frame pinned until the response is gone
+                std::shared_ptr<BurstLease> lease = std::make_shared<BurstLease>();
+                AsyncWebServerResponse *response = request->beginResponse("image/jpeg", len,
+                    [jpeg, len, lease](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                        size_t n = len - index;
+                        if (n > maxLen) n = maxLen;
+                        memcpy(buf, jpeg + index, n);
+                        return n;
+                    });
+                response->addHeader("Cache-Control", "no-cache");
+                request->send(response);
+                return;
+            }
+
+            BurstInfo b = getBurstInfo();
+            char json[320];
+            JsonWriter w(json, sizeof(json));
+
+            w.beginObject()
+                .fieldU("id", b.id)
+                .fieldU("age", b.id ? millis() - b.triggerMs : 0)
+                .fieldU("frames", b.frames)
+                .fieldU("width", b.width)
+                .fieldU("height", b.height)
+                .fieldU("firstStillMs", b.firstStillMs)
+                .fieldU("durationMs", b.durationMs)
+                .fieldU("streamGapMs", b.streamGapMs)
+                .beginArray("sizes");
+            for (int i = 0; i < b.frames; i++) w.valueU(b.sizes[i]);
+            w.endArray()
+                .fieldU("requested", b.requested)
+                .fieldU("completed", b.completed)
+                .fieldU("missed", b.missed)
+            .endObject();
+
+            request->send(200, "application/json", json);
+        });
+
+        // ------------------ UDP TELEMETRY ------------------
+        // POST port=<udp port> [broadcast=1] [stop=1], renew within UDP_LEASE_MS
+        _server.on("/udp", HTTP_POST, [this](AsyncWebServerRequest *request){
+            if (!request->hasParam("port", true)) {
+                request->send(400, "text/plain", "MISSING PORT");
+                return;
+            }
+            long port = request->getParam("port", true)->value().toInt();
+            if (port <= 0 || port > 65535) {
+                request->send(400, "text/plain", "BAD PORT");
+                return;
+            }
+
+            IPAddress ip = request->client()->remoteIP();
+            if (request->hasParam("broadcast", true) && request->getParam("broadcast", true)->value() == "1")
+                ip = WiFi.softAPBroadcastIP();
+
+            if (request->hasParam("stop", true) && request->getParam("stop", true)->value() == "1") {
+                _udp.remove(ip, port);
+                request->send(200, "text/plain", "UDP STOPPED");
+                return;
+            }
+
+            if (!_udp.add(ip, port, millis())) {
+                request->send(503, "text/plain", "UDP CLIENTS FULL");
+                return;
+            }
+
+            char json[96];
+            JsonWriter w(json, sizeof(json));
+            w.beginObject()
+                .fieldStr("ip", ip.toString().c_str())
+                .fieldU("port", port)
+                .fieldU("leaseMs", UDP_LEASE_MS)
+                .fieldU("refreshMs", UDP_REFRESH_MS)
+            .endObject();
+            request->send(200, "application/json", json);
+        });
+
+        _server.on("/udp", HTTP_GET, [this](AsyncWebServerRequest *request){
+            UdpClient clients[UDP_MAX_CLIENTS];
+            uint32_t now = millis();
+            int n = _udp.copy(clients, now);
+
+            char json[384];
+            JsonWriter w(json, sizeof(json));
+            w.beginObject()
+                .fieldU("seq", _udp.stats().seq)
+                .fieldU("packets", _udp.stats().packets)
+                .fieldU("errors", _udp.stats().errors)
+                .beginArray("clients");
+            for (int i = 0; i < n; i++) {
+                w.beginObject()
+                    .fieldStr("ip", clients[i].ip.toString().c_str())
+                    .fieldU("port", clients[i].port)
+                    .fieldU("expiresMs", clients[i].expires - now)
+                .endObject();
+            }
+            w.endArray().endObject();
+            request->send(200, "application/json", json);
+        });
+
+        // ------------------ CLOCK SYNC ------------------
+        _server.on("/sync", HTTP_GET, [this](AsyncWebServerRequest *request){
+            ClientClock clocks[WS_MAX_CLIENTS];
+            int n = _clock.copy(clocks);
+
+            char json[160 * WS_MAX_CLIENTS];
+            JsonWriter w(json, sizeof(json));
+            w.beginObject()
+                .field64("deviceUs", esp_timer_get_time())
+                .beginArray("clients");
+            for (int i = 0; i < n; i++) {
+                if (!clocks[i].exchanges) continue;
+                w.beginObject();
+                writeClock(w, clocks[i]);
+                w.endObject();
+            }
+            w.endArray().endObject();
+            request->send(200, "application/json", json);
+        });
+
+        // ------------------ EVENT LOG ------------------
+        // ?from=&to= unix ms (or uptime ms with &boot=n), &limit=, &fmt=bin for raw 32 byte records
+        _server.on("/events", HTTP_GET, [](AsyncWebServerRequest *request){
+            std::shared_ptr<EventStream> s = std::make_shared<EventStream>();
+            if (request->hasParam("boot")) s->query.boot = request->getParam("boot")->value().toInt();
+            if (request->hasParam("from")) s->query.from = atoll(request->getParam("from")->value().c_str());
+            if (request->hasParam("to")) s->query.to = atoll(request->getParam("to")->value().c_str());
+            if (request->hasParam("limit")) s->query.limit = request->getParam("limit")->value().toInt();
+            s->binary = request->hasParam("fmt") && request->getParam("fmt")->value() == "bin";
+
+            AsyncWebServerResponse *response = request->beginChunkedResponse(
+                s->binary ? "application/octet-stream" : "application/json",
+                [s](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                    if (s->pos >= s->len && !refillEvents(*s)) return 0;
+                    size_t n = s->len - s->pos;
+                    if (n > maxLen) n = maxLen;
+                    memcpy(buf, s->text + s->pos, n);
+                    s->pos += n;
+                    return n;
+                });
+            response->addHeader("Cache-Control", "no-cache");
+            request->send(response);
+        });
+
+        // ------------------ SYSTEM STATS ------------------
+        _server.on("/stats", HTTP_GET, [this](AsyncWebServerRequest *request){
+
+            // Too big for the async_tcp stack
+            std::unique_ptr<char[]> json(new (std::nothrow) char[STATS_JSON_SIZE]);
+            if (!json) {
+                request->send(503, "text/plain", "OUT OF MEMORY");
+                return;
+            }
+            JsonWriter w(json.get(), STATS_JSON_SIZE);
+            writeStats(w);
+
+            if (!w.ok()) {
+                request->send(500, "text/plain", "JSON OVERFLOW");
+                return;
+            }
+            request->send(200, "application/json", json.get());
         });
 
         // ------------------ JSON DATA (legacy polling) ------------------
         _server.on("/data", HTTP_GET, [](AsyncWebServerRequest *request){
 
-            char json[512];
-            int offset = snprintf(json, sizeof(json),"{\"count\":%d,\"targets\":[",globalTargetCount);
+            RadarSnapshot snap;
+            radarSnapshot.read(snap);
+
+            char json[512 * RADAR_SENSOR_COUNT];
+            JsonWriter w(json, sizeof(json));
 
-            for(int i=0;i<globalTargetCount;i++){
-                offset += snprintf(json+offset,sizeof(json)-offset,"{\"d\":%d,\"s\":%d,\"app\":%d}%s",activeTargets[i].distance,
-                activeTargets[i].speed,activeTargets[i].approaching ? 1 : 0,(i < globalTargetCount-1) ? "," : "");
+            w.beginObject()
+                .field("count", snap.count)
+                .beginArray("targets");
+
+            for(int i=0;i<snap.count;i++){
+                w.beginObject()
+                    .field("d", snap.targets[i].distance)
+                    .field("s", snap.targets[i].speed)
+                    .fieldBool("app", snap.targets[i].approaching)
+                    .field("src", snap.targets[i].sensor)
+                .endObject();
             }
 
-            snprintf(json+offset,sizeof(json)-offset,"]}");
+            w.endArray().endObject();
+
+            if (!w.ok()) {
+                request->send(500, "text/plain", "JSON OVERFLOW");
+                return;
+            }
             request->send(200,"application/json",json);
         });
 
@@ -175,274 +830,150 @@ public:
         }
     }
 
-    // --------------------------------------------------------
-    // ONLY call when radar data changes
-    // --------------------------------------------------------
-
-    void sendRadarUpdate() {
-        if(!_ws.count()) return;
-        int offset = snprintf(
-            radarJson,
-            sizeof(radarJson),
-            "{\"type\":\"radar\",\"timestamp\":%lu,\"count\":%d,\"targets\":[",
-            millis(),
-            globalTargetCount
-        );
-        for(int i = 0; i < globalTargetCount; i++) {
-            // Prevent overflow
-            if(offset >= sizeof(radarJson)) break;
-
-            offset += snprintf(
-                radarJson + offset,
-                sizeof(radarJson) - offset,
-                "{"
-                "\"id\":%d,"
-                "\"distance\":%d,"
-                "\"speed\":%d,"
-                "\"approaching\":%d,"
-                "\"angle\":%d,"
-                "\"snr\":%d"
-                "\"smoothdis\":%d"
-                "}%s",
-                i,
-                activeTargets[i].distance,
-                activeTargets[i].speed,
-                activeTargets[i].approaching ? 1 : 0,
-                activeTargets[i].angle,      
-                activeTargets[i].snr,  
-                activeTargets[i].smoothedDist,    
-                (i < globalTargetCount - 1) ? "," : ""
-            );
+    // Clock exchange request to every client subscribed to "sync"
+    void handleSync() {
+        unsigned long now = millis();
+        if (now - _lastSync < SYNC_INTERVAL_MS) return;
+        _lastSync = now;
+        if (!(_subs.activeTopics() & WS_TOPIC_SYNC)) return;
+
+        WsSubscription subs[WS_MAX_CLIENTS];
+        int n = _subs.copy(subs);
+        for (int i = 0; i < n; i++) {
+            if (!(subs[i].topics & WS_TOPIC_SYNC)) continue;
+            AsyncWebSocketClient *c = _ws.client(subs[i].clientId);
+            if (!c || c->status() != WS_CONNECTED || c->queueIsFull()) continue;
+
+            char json[48];
+            JsonWriter w(json, sizeof(json));
+            w.beginObject()
+                .fieldStr("type", "sync")
+                .field64("t1", _clock.request(subs[i].clientId))
+            .endObject();
+            c->text(json);
         }
+    }
 
-        if(offset < sizeof(radarJson)) {
-            snprintf(radarJson + offset, sizeof(radarJson) - offset, "]}");
-        }
+    // Device -> client time for cross-device latency (false before the first exchange)
+    ClockSync &clock() { return _clock; }
+
+    // Repeats the current radar state on the UDP channel when it has been quiet
+    void handleUdp() {
+        unsigned long now = millis();
+        if (!_udp.refreshDue(now) || !_udp.count(now)) return;
 
-        _ws.textAll(radarJson);
+        RadarSnapshot snap;
+        radarSnapshot.read(snap);
+        sendUdp(snap);
     }
 
-    void cleanupWS() {
-        _ws.cleanupClients();
+    int wsClientCount() {
+        return _ws.count();
     }
 
-    const char* index_html = R"rawliteral(
-    <!DOCTYPE html>
-    <html>
-    <head>
-    <title>SafeBaige Pro</title>
-    <meta name="viewport" content="width=device-width, initial-scale=1">
-    <style>
-    body { font-family:-apple-system,sans-serif;background:#121212;color:#eee;margin:0;padding:20px;}
-    .container{max-width:520px;margin:auto;}
-    .card{background:#1e1e1e;padding:15px;border-radius:12px;margin-bottom:20px;border:1px solid #333;}
-    .group-title{color:#00cfcf;font-size:0.85em;font-weight:bold;margin-bottom:15px;text-transform:uppercase;border-bottom:1px solid #333;padding-bottom:5px;}
-    .row{display:flex;align-items:center;justify-content:space-between;margin-bottom:12px;gap:10px;}
-    .row label{flex:1;font-size:0.9em;}
-    input,select{flex:1.2;background:#333;color:white;border:1px solid #444;padding:6px;border-radius:6px;}
-    button{background:#333;color:white;border:1px solid #444;padding:10px;border-radius:6px;cursor:pointer;flex:1;}
-    button.primary{background:#00cfcf;color:black;border:none;font-weight:bold;margin-top:10px;}
-    .btn-group{display:flex;gap:10px;margin-bottom:10px;}
-    .stream-box{width:100%;border-radius:8px;margin-bottom:15px;border:2px solid #333;overflow:hidden;background:#000;}
-    .stream-box img{width:100%;display:block;}
-    </style>
-    </head>
-
-    <body>
-    <div class="container">
-
-    <div class="stream-box">
-    <img src="http://safebaige.local:81/stream">
-    </div>
-
-    <div class="card">
-    <div class="group-title">Camera</div>
-    <div class="btn-group">
-    <button onclick="cmd('flip')">Vertical Flip</button>
-    <button onclick="cmd('mirror')">Horizontal Mirror</button>
-    </div>
-
-    <div class="btn-group">
-    <button style="background:#00cfcf;color:black;font-weight:bold;"
-            onclick="cmd('wake')">Wake Camera</button>
-    </div>
-    </div>
-    </div>
-
-    <div class="card">
-    <div class="group-title">Radar Hardware (LD2451)</div>
-    
-    <div class="row">
-        <label>Load Profile</label>
-        <select id="profile" onchange="applyProfile(this.value)">
-            <option value="">Select Profile</option>
-            <option value="city">City Riding</option>
-            <option value="highway">Highway/Open</option>
-            <option value="rain">Rain / Bad Weather</option>
-            <option value="commuter">Commuter</option>
-            <option value="performance">Performance</option>
-        </select>
-    </div>
-
-    <div class="row">
-    <label>Max Distance (1-100m)</label>
-    <input type="number" id="dist" min="1" max="100">
-    </div>
-
-    <div class="row">
-    <label>Direction</label>
-    <select id="dir">
-    <option value="2">Both</option>
-    <option value="1">Approaching Only</option>
-    <option value="0">Moving Away Only</option>
-    </select>
-    </div>
-
-    <div class="row">
-    <label>Min Speed (0-120km/h)</label>
-    <input type="number" id="speed" min="0" max="120">
-    </div>
-
-    <div class="row">
-    <label>Delay Time (0-30s)</label>
-    <input type="number" id="delay" min="0" max="30">
-    </div>
-
-    <div class="row">
-    <label>Trigger Accuracy (1-10)</label>
-    <input type="number" id="acc" min="1" max="10">
-    </div>
-
-    <div class="row">
-    <label>SNR Limit (0-255 (4 is default))</label>
-    <input type="number" id="snr" min="0" max="255">
-    </div>
-    </div>
-
-
-    <div class="card">
-    <div class="group-title">System Alert Logic</div>
-
-    <div class="row">
-    <label>Approaching Speed to turn cars RED (km/h)</label>
-    <input type="number" id="rapid" min="5" max="150">
-    </div>
-
-    <div class="row">
-    <label>Camera Sleep Timeout (ms)</label>
-    <input type="number" id="camTimer" min="3000" max="60000" step="1000">
-    </div>
-
-    <button class="primary" onclick="save()">SAVE ALL CONFIGS</button>
-    <button style="margin-top:10px;font-size:0.8em;" onclick="cmd('reboot')">Reboot Device</button>
-    </div>
-
-    </div>
-    <div class="card">
-    <div class="group-title">Live Radar (WebSocket)</div>
-    <pre id="wslog" style="font-size:0.8em;height:120px;overflow:auto;background:#000;padding:10px;border-radius:6px;"></pre>
-    </div>
-    <script>
-function g(id){ return document.getElementById(id).value; }
-function s(id,val){ document.getElementById(id).value = val; }
-// ---------------- WS Check ----------------
-let ws;
-
-function connectWS(){
-    ws = new WebSocket(`ws://${location.host}/ws`);
-
-    ws.onopen = () => {
-        log("WS Connected");
-    };
+    bool hasSubscribers(uint8_t topic) {
+        return _subs.activeTopics() & topic;
+    }
 
-    ws.onmessage = (event) => {
-        log("RX: " + event.data);
-    };
+    // Drain one chunk of a sensor's raw UART tap to the raw topic subscribers
+    void sendRawTap(uint8_t sensor, ByteRing &tap) {
+        if (!tap.available()) return;
 
-    ws.onclose = () => {
-        log("WS Disconnected - retrying...");
-        setTimeout(connectWS, 2000);
-    };
+        fanOut(WS_TOPIC_RAW, false, [&](uint8_t, uint8_t, bool &binary) -> size_t {
+            binary = true;
+            uint8_t *p = (uint8_t*)_scratch;
+            uint32_t now = millis();
+            uint32_t dropped = tap.dropped();
 
-    ws.onerror = (err) => {
-        log("WS Error");
-    };
-}
-
-function log(msg){
-    const el = document.getElementById("wslog");
-    el.textContent += msg + "\n";
-    el.scrollTop = el.scrollHeight;
-}
-// ---------------- CAMERA COMMAND ----------------
-function cmd(type){
-    fetch(`/cam?cmd=${type}`);
-}
-
-// ---------------- SAVE CONFIG ----------------
-function save(){
-    const params = new URLSearchParams({
-        max_distance: g('dist'),
-        direction_mode: g('dir'),
-        min_speed: g('speed'),
-        trigger_delay_ms: g('delay'),
-        trigger_acc: g('acc'),
-        snr_limit: g('snr'),
-        rapid_threshold: g('rapid'),
-        camera_timer_ms: g('camTimer')
-    });
-
-    fetch('/config', {
-        method: 'POST',
-        headers: {'Content-Type':'application/x-www-form-urlencoded'},
-        body: params.toString()
-    })
-    .then(()=> {
-        alert("Configuration Saved");
-    });
-}
-
-// ---------------- LOAD CONFIG ON PAGE LOAD ----------------
-window.onload = function(){
-    
-    connectWS();
-
-    fetch('/config')
-    .then(r => r.json())
-    .then(cfg => {
-        s('dist', cfg.dist);
-        s('dir', cfg.dir);
-        s('speed', cfg.speed);
-        s('delay', cfg.delay);
-        s('acc', cfg.acc);
-        s('snr', cfg.snr);
-        s('rapid', cfg.rapid);
-        s('camTimer', cfg.camTimer);
-    });
-}
-
-// ---------------- PROFILE PRESETS ----------------
-const presets = {
-    city:      {dist:40, speed:0, delay:0, acc:5, snr:6, rapid:15},
-    highway:   {dist:100, speed:10, delay:0, acc:3, snr:4, rapid:20},
-    rain:      {dist:60, speed:5, delay:1, acc:6, snr:10, rapid:15},
-    commuter:  {dist:70, speed:5, delay:0, acc:4, snr:4, rapid:15},
-    performance:{dist:100, speed:0, delay:0, acc:2, snr:4, rapid:25}
-};
+            p[0] = RAW_BIN_TYPE;
+            p[1] = RAW_BIN_VERSION;
+            p[2] = sensor;
+            memcpy(p + 3, &now, 4);
+            memcpy(p + 7, &dropped, 4);
+
+            size_t room = sizeof(_scratch) - 11;
+            return 11 + tap.read(p + 11, room < RAW_CHUNK ? room : RAW_CHUNK);
+        });
+    }
+
+    // Periodic stats topic, skipped entirely when nobody subscribed
+    void handleStats() {
+        unsigned long now = millis();
+        if (now - _lastStats < STATS_INTERVAL) return;
+        _lastStats = now;
+        if (!(_subs.activeTopics() & WS_TOPIC_STATS)) return;
+
+        fanOut(WS_TOPIC_STATS, false, [this](uint8_t, uint8_t, bool &binary) -> size_t {
+            binary = false;
+            JsonWriter w(_scratch, sizeof(_scratch));
+            writeStats(w);
+            return w.ok() ? w.length() : 0;
+        });
+    }
 
-function applyProfile(p) {
-    if (!presets[p]) return;
-    const cfg = presets[p];
-    for (const key in cfg) {
-        document.getElementById(key).value = cfg[key];
+    // Alert edges (rapid approach, vision veto...) for the events topic
+    void sendEvent(const char *event, int id, const RadarTarget &t, unsigned long timestamp) {
+        if (!(_subs.activeTopics() & WS_TOPIC_EVENTS)) return;
+
+        fanOut(WS_TOPIC_EVENTS, false, [&](uint8_t, uint8_t, bool &binary) -> size_t {
+            binary = false;
+            JsonWriter w(_scratch, sizeof(_scratch));
+            w.beginObject()
+                .fieldStr("type", "event")
+                .fieldStr("event", event)
+                .fieldU("timestamp", timestamp)
+                .field("id", id)
+                .field("distance", t.distance)
+                .field("speed", t.speed)
+                .field("angle", t.angle)
+                .fieldU("sensor", t.sensor)
+            .endObject();
+            return w.ok() ? w.length() : 0;
+        });
     }
-    alert(`Profile "${p}" applied - press SAVE`);
-}
-</script>
 
-    </body>
-    </html>
-    )rawliteral";
+    // Radar UART link degraded / recovered
+    void sendLinkEvent(uint8_t sensor, LinkEvent event, LinkHealth &h) {
+        if (!(_subs.activeTopics() & WS_TOPIC_EVENTS)) return;
+
+        fanOut(WS_TOPIC_EVENTS, false, [&](uint8_t, uint8_t, bool &binary) -> size_t {
+            binary = false;
+            JsonWriter w(_scratch, sizeof(_scratch));
+            w.beginObject()
+                .fieldStr("type", "event")
+                .fieldStr("event", event == LINK_EVENT_DEGRADED ? "link_degraded" : "link_ok")
+                .fieldU("timestamp", millis())
+                .fieldU("sensor", sensor)
+                .fieldStr("reason", h.reason())
+                .fieldFixed("fps", h.fpsX10() / 10.0f, 1)
+                .fieldU("errors", h.errorsPerWindow())
+            .endObject();
+            return w.ok() ? w.length() : 0;
+        });
+    }
+
+    // --------------------------------------------------------
+    // ONLY call when radar data changes
+    // --------------------------------------------------------
+
+    void sendRadarUpdate() {
+        RadarSnapshot snap;
+        radarSnapshot.read(snap);
+
+        sendUdp(snap);
+        if(!(_subs.activeTopics() & WS_TOPIC_RADAR)) return;
+
+        // One serialization per distinct format/field mask, not per client
+        fanOut(WS_TOPIC_RADAR, true, [&](uint8_t format, uint8_t fields, bool &binary) -> size_t {
+            binary = (format == WS_FORMAT_BINARY);
+            return binary ? radarMessageBinary(snap, (uint8_t*)_scratch)
+                          : radarMessageJson(_scratch, sizeof(_scratch), snap, fields);
+        });
+    }
+
+    void cleanupWS() {
+        _ws.cleanupClients();
+    }
 };
 
 #endif
\ No newline at end of file
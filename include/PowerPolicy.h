@@ -0,0 +1,119 @@
+#ifndef POWER_POLICY_H
+#define POWER_POLICY_H
+
+#include <stdint.h>
+
+// Pure activity -> power state machine (no hardware access, so it can be
+// driven by recorded radar traces). main.cpp applies the outputs.
+//
+//   ACTIVE  : target on radar or seen in the last ACTIVE_HOLD_MS
+//   IDLE    : quiet, but camera still awake or clients connected
+//   STANDBY : quiet longer than the camera timer and nobody watching the stream
+//
+// Any target jumps straight to ACTIVE (fast ramp-up), going down is one state
+// per update, so ACTIVE -> STANDBY always passes through IDLE (even with the
+// camera timer at its ACTIVE_HOLD_MS minimum).
+
+enum PowerState : uint8_t {
+    POWER_ACTIVE = 0,
+    POWER_IDLE,
+    POWER_STANDBY,
+    POWER_STATE_COUNT
+};
+
+enum WifiSaveMode : uint8_t {
+    WIFI_SAVE_NONE = 0, // radio always on
+    WIFI_SAVE_MIN,      // modem sleep, wake every DTIM
+    WIFI_SAVE_MAX       // modem sleep, listen interval
+};
+
+struct PowerInputs {
+    uint32_t now;
+    uint32_t lastTargetMs;  // last frame with targets (millis)
+    int      targetCount;
+    int      wsClients;
+    int      streamClients;
+    uint32_t cameraTimerMs;
+};
+
+struct PowerProfile {
+    uint16_t cpuMhz;
+    uint8_t  wifiSave;
+    uint8_t  loopDelayMs;
+};
+
+class PowerPolicy {
+private:
+    static const uint32_t ACTIVE_HOLD_MS = 3000;
+
+    PowerState _state = POWER_ACTIVE;
+    uint32_t _lastUpdate = 0;
+    uint32_t _enteredAt = 0;
+    uint32_t _timeIn[POWER_STATE_COUNT] = {};
+    uint32_t _transitions = 0;
+    bool _started = false;
+    bool _wsClients = false;
+
+    // Loop delay stays below what the UART RX buffer can absorb at 115200 baud
+    static PowerProfile profileFor(PowerState s) {
+        switch (s) {
+            case POWER_ACTIVE: return {240, WIFI_SAVE_NONE, 5};
+            case POWER_IDLE:   return {160, WIFI_SAVE_MIN, 10};
+            default:           return {80,  WIFI_SAVE_MAX, 15};
+        }
+    }
+
+    PowerState target(const PowerInputs &in) const {
+        if (in.targetCount > 0) return POWER_ACTIVE;
+
+        uint32_t quiet = in.now - in.lastTargetMs;
+        if (quiet < ACTIVE_HOLD_MS) return POWER_ACTIVE;
+        if (quiet < in.cameraTimerMs || in.streamClients > 0) return POWER_IDLE;
+        // WS clients only soften the radio setting, see profile()
+        return POWER_STANDBY;
+    }
+
+public:
+    // Returns true when the profile changed and must be re-applied
+    bool update(const PowerInputs &in) {
+        if (!_started) {
+            _started = true;
+            _lastUpdate = _enteredAt = in.now;
+        }
+
+        PowerProfile before = profile();
+        _timeIn[_state] += in.now - _lastUpdate;
+        _lastUpdate = in.now;
+        _wsClients = in.wsClients > 0;
+
+        PowerState next = target(in);
+        if (next > _state + 1) next = (PowerState)(_state + 1);
+        if (next != _state) {
+            _state = next;
+            _enteredAt = in.now;
+            _transitions++;
+        }
+
+        PowerProfile p = profile();
+        return p.cpuMhz != before.cpuMhz || p.wifiSave != before.wifiSave ||
+               p.loopDelayMs != before.loopDelayMs;
+    }
+
+    PowerState state() const { return _state; }
+    PowerProfile profile() const {
+        PowerProfile p = profileFor(_state);
+        // Keep WS push latency reasonable while a phone is connected
+        if (_wsClients && p.wifiSave == WIFI_SAVE_MAX) p.wifiSave = WIFI_SAVE_MIN;
+        return p;
+    }
+    uint32_t timeIn(PowerState s) const { return _timeIn[s]; }
+    uint32_t transitions() const { return _transitions; }
+    uint32_t inStateSince() const { return _enteredAt; }
+
+    static const char *name(PowerState s) {
+        static const char *NAMES[] = {"active", "idle", "standby"};
+        return s < POWER_STATE_COUNT ? NAMES[s] : "?";
+    }
+};
+
+#endif
@@ -3,8 +3,72 @@
 
 #include <HardwareSerial.h>
 
+// Fastest UART rate negotiated with the radar (see RadarSensor::negotiateBaud)
+#ifndef RADAR_BAUD_MAX
+#define RADAR_BAUD_MAX 460800
+#endif
+#define RADAR_BAUD_DEFAULT 115200 // factory rate of the LD2451
+#define RADAR_ACK_TIMEOUT_MS 100
+
 class RadarConfig {
 public:
+    // Command word 0x00A1 takes an index, not the rate itself
+    static int baudIndex(uint32_t baud) {
+        static const uint32_t RATES[] = { 9600, 19200, 38400, 57600, 115200, 230400, 256000, 460800 };
+        for (int i = 0; i < (int)(sizeof(RATES) / sizeof(RATES[0])); i++) {
+            if (RATES[i] == baud) return i + 1;
+        }
+        return -1;
+    }
+
+    static void sendCommand(HardwareSerial &ser, uint16_t cmd, const uint8_t *value = nullptr, uint8_t len = 0) {
+        uint8_t frame[4 + 2 + 2 + 8 + 4] = { 0xFD, 0xFC, 0xFB, 0xFA };
+        size_t n = 4;
+        frame[n++] = 2 + len;
+        frame[n++] = 0;
+        frame[n++] = cmd & 0xFF;
+        frame[n++] = cmd >> 8;
+        for (uint8_t i = 0; i < len && i < 8; i++) frame[n++] = value[i];
+        frame[n++] = 0x04; frame[n++] = 0x03; frame[n++] = 0x02; frame[n++] = 0x01;
+        ser.write(frame, n);
+        ser.flush();
+    }
+
+    // Wait for the ACK of cmd (command word | 0x0100, status 0), skipping data
+    // frames and noise. Returns the length of the data after the status that
+    // was copied into out, -1 on timeout or a failure status.
+    static int readAck(HardwareSerial &ser, uint16_t cmd, uint8_t *out, size_t max, uint32_t timeoutMs = RADAR_ACK_TIMEOUT_MS) {
+        static const uint8_t HEADER[4] = { 0xFD, 0xFC, 0xFB, 0xFA };
+        uint8_t buf[64];
+        size_t len = 0;
+        unsigned long start = millis();
+
+        while (millis() - start < timeoutMs) {
+            int c = ser.read();
+            if (c < 0) { delay(1); continue; }
+
+            // Resync on the header, then collect up to the declared length + footer
+            if (len < 4 && c != HEADER[len]) { len = (c == HEADER[0]) ? 1 : 0; continue; }
+            buf[len++] = c;
+            if (len < 6) continue;
+
+            size_t body = buf[4] | (buf[5] << 8);
+            if (body < 4 || 6 + body + 4 > sizeof(buf)) { len = 0; continue; }
+            if (len < 6 + body + 4) continue;
+
+            len = 0;
+            uint16_t word = buf[6] | (buf[7] << 8);
+            if (word != (cmd | 0x0100)) continue;
+            if (buf[8] | buf[9]) return -1;
+
+            size_t data = body - 4;
+            if (data > max) data = max;
+            if (out) memcpy(out, buf + 10, data);
+            return data;
+        }
+        return -1;
+    }
+
     static void sendDefaults(HardwareSerial &ser, uint8_t maxDist, uint8_t direction, uint8_t minSpeed, uint8_t delayTime, uint8_t triggerTimes, uint8_t snrLimit) {
         
         // 1. Enable Configuration
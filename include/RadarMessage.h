@@ -0,0 +1,78 @@
+#ifndef RADAR_MESSAGE_H
+#define RADAR_MESSAGE_H
+
+#include <Arduino.h>
+#include "RadarSnapshot.h"
+#include "JsonWriter.h"
+#include "WsTopics.h"
+
+// Payloads of the WS radar topic, also used for UDP telemetry. Kept out of
+// NetworkManager so the host tests serialize exactly what the device sends.
+
+// Radar topic binary layout (little endian):
+// 'R', version, uint32 timestamp, veto, count, then per target
+// id, distance, speed, flags (bit0 approaching, bit1-2 vision, bit3-4 motion), int8 angle (deg), snr, sensor, uint16 smoothdis (dm)
+#define RADAR_BIN_TYPE    0x52
+#define RADAR_BIN_VERSION 1
+#define RADAR_BIN_MAX     (8 + 9 * RADAR_MERGED_MAX)
+
+// JSON with the WS_FIELD_* selection of a client. Returns 0 rather than a
+// truncated document when buf is too small.
+inline size_t radarMessageJson(char *buf, size_t size, const RadarSnapshot &snap, uint8_t fields) {
+    JsonWriter w(buf, size);
+
+    w.beginObject()
+        .fieldStr("type", "radar")
+        .fieldU("timestamp", snap.timestamp) // frame time, echoed back by the vision client
+        .fieldBool("veto", snap.veto)
+        .field("count", snap.count)
+        .beginArray("targets");
+
+    for(int i = 0; i < snap.count; i++) {
+        const RadarTarget &t = snap.targets[i];
+        w.beginObject().field("id", i);
+        if (fields & WS_FIELD_DISTANCE)    w.field("distance", t.distance);
+        if (fields & WS_FIELD_SPEED)       w.field("speed", t.speed);
+        if (fields & WS_FIELD_APPROACHING) w.fieldBool("approaching", t.approaching);
+        if (fields & WS_FIELD_ANGLE)       w.field("angle", t.angle);
+        if (fields & WS_FIELD_SNR)         w.field("snr", t.snr);
+        if (fields & WS_FIELD_SMOOTHDIS)   w.fieldFixed("smoothdis", t.smoothedDist, 1);
+        if (fields & WS_FIELD_VISION)      w.fieldU("vision", t.vision).fieldU("motion", t.motion);
+        if (fields & WS_FIELD_SENSOR)      w.fieldU("sensor", t.sensor);
+        w.endObject();
+    }
+
+    w.endArray().endObject();
+
+    // Never push a truncated document
+    return w.ok() ? w.length() : 0;
+}
+
+// p must hold RADAR_BIN_MAX bytes
+inline size_t radarMessageBinary(const RadarSnapshot &snap, uint8_t *p) {
+    size_t n = 0;
+
+    p[n++] = RADAR_BIN_TYPE;
+    p[n++] = RADAR_BIN_VERSION;
+    uint32_t ts = snap.timestamp;
+    memcpy(p + n, &ts, 4); n += 4;
+    p[n++] = snap.veto ? 1 : 0;
+    p[n++] = snap.count;
+
+    for (int i = 0; i < snap.count; i++) {
+        const RadarTarget &t = snap.targets[i];
+        uint16_t dm = (uint16_t)(t.smoothedDist * 10.0f + 0.5f);
+        p[n++] = i;
+        p[n++] = t.distance;
+        p[n++] = t.speed;
+        p[n++] = (t.approaching ? 0x01 : 0x00) | ((t.vision & 0x03) << 1) | ((t.motion & 0x03) << 3);
+        p[n++] = (uint8_t)t.angle;
+        p[n++] = t.snr;
+        p[n++] = t.sensor;
+        p[n++] = dm & 0xFF;
+        p[n++] = dm >> 8;
+    }
+    return n;
+}
+
+#endif
@@ -1,101 +1,127 @@
 #ifndef RADAR_PARSER_H
 #define RADAR_PARSER_H
 
-#include <HardwareSerial.h>
+#include <Arduino.h>
 #include "LD2451_Defines.h"
-#include "FilterModule.h"
+#include "LinkHealth.h"
 
-extern SignalFilter distFilter;
+#define RADAR_PARSE_NEED_MORE -1 // no complete frame buffered yet
+#define RADAR_RX_BUFFER 256      // > largest frame (4 + 2 + 100 + 4)
+#define RADAR_MAX_PAYLOAD 100
 
+// One parser per radar UART. Bytes are pushed in by the ingest layer (which
+// owns the UART reads, so it can tee them elsewhere) and frames are cut out of
+// the local buffer without ever blocking on the serial port. Smoothing is left
+// to RadarSensor, which knows when a frame arrived. Every byte and frame
+// outcome is counted in the link counters of the sensor.
 class RadarParser {
+private:
+    LinkCounters &_counters;
+
+    uint8_t _buf[RADAR_RX_BUFFER];
+    size_t  _len = 0;
+
+    void consume(size_t n) {
+        if (n >= _len) { _len = 0; return; }
+        memmove(_buf, _buf + n, _len - n);
+        _len -= n;
+    }
+
 public:
-    static int parse(HardwareSerial &ser, RadarTarget *targets, int maxTargets, uint8_t* debugBuf = nullptr, int* debugLen = nullptr) {
+    RadarParser(LinkCounters &counters) : _counters(counters) {}
+
+    // Space left in the receive buffer
+    size_t space() const { return sizeof(_buf) - _len; }
+
+    // Append raw UART bytes. Returns how many were accepted.
+    size_t push(const uint8_t *data, size_t len) {
+        if (len > space()) len = space();
+        memcpy(_buf + _len, data, len);
+        _len += len;
+        _counters.bytes += len;
+        return len;
+    }
+
+    // Cut the next frame out of the buffer.
+    // Returns the number of targets (> 0), 0 when bytes were consumed without
+    // targets (heartbeat, garbage, bad frame) or RADAR_PARSE_NEED_MORE.
+    int next(RadarTarget *targets, int maxTargets) {
         // Minimum frame is 10 bytes (Header 4 + Len 2 + Footer 4)
-        if (ser.available() < 10) return 0;
-
-        if (ser.peek() == 0xF4) {
-            uint8_t header[4];
-            ser.readBytes(header, 4);
-            
-            if (header[1] == 0xF3 && header[2] == 0xF2 && header[3] == 0xF1) {
-                uint16_t dataLen = 0;
-                ser.readBytes((uint8_t*)&dataLen, 2);
-
-                // Update debug buffer for webhook
-                if (debugBuf && debugLen) {
-                    memcpy(debugBuf, header, 4);
-                    memcpy(debugBuf + 4, &dataLen, 2);
-                    *debugLen = 6;
-                }
-
-                // Handle Empty/Heartbeat frames (F4 F3 F2 F1 00 00 ...)
-                if (dataLen == 0) {
-                    uint8_t footer[4];
-                    ser.readBytes(footer, 4);
-                    if (debugBuf && debugLen) {
-                        memcpy(debugBuf + 6, footer, 4);
-                        *debugLen = 10;
-                    }
-                    return 0; 
-                }
-
-                // Process Payload
-                if (dataLen > 100) return 0; // protect stack
-                uint8_t payload[dataLen];
-                ser.readBytes(payload, dataLen);
-                
-                if (debugBuf && debugLen) {
-                    int toCopy = (dataLen < 50) ? dataLen : 50; 
-                    memcpy(debugBuf + *debugLen, payload, toCopy); 
-                    *debugLen += toCopy; 
-                }
-
-                uint8_t footer[4];
-                ser.readBytes(footer, 4);
-                if (debugBuf && debugLen && *debugLen < 60) {
-                    memcpy(debugBuf + *debugLen, footer, 4);
-                    *debugLen += 4;
-                }
-
-                int countDetected = payload[0];
-                uint8_t alarmInfo = payload[1];
-
-                int actualToRead = (countDetected > maxTargets) ? maxTargets : countDetected;
-
-                for (int i = 0; i < actualToRead; i++) {
-
-                    int base = 2 + (i * 5); 
-
-                    if (base + 4 < dataLen) {
-
-                        uint8_t rawAngle = payload[base + 0];
-                        targets[i].angle = (int)rawAngle - 0x80;  // convert to signed degrees
-
-                        targets[i].distance = payload[base + 1];
-
-                        uint8_t dirByte = payload[base + 2];
-                        targets[i].approaching = (dirByte == 0x00);  // 00 = approaching
-
-                        targets[i].speed = payload[base + 3];
-                        targets[i].snr   = payload[base + 4];
-
-                        targets[i].smoothedDist =
-                            distFilter.smooth(i, (float)targets[i].distance);
-                    }
-                }
-
-                // Reset unused slots
-                for (int i = actualToRead; i < maxTargets; i++) {
-                    distFilter.reset(i);
-                }
-
-                return actualToRead;
+        if (_len < 10) return RADAR_PARSE_NEED_MORE;
+
+        if (_buf[0] != DATA_FRAME_HEADER[0]) {
+            // Discard everything up to the next possible header byte
+            const uint8_t *hit = (const uint8_t*)memchr(_buf + 1, DATA_FRAME_HEADER[0], _len - 1);
+            size_t skip = hit ? hit - _buf : _len;
+            _counters.resyncBytes += skip;
+            consume(skip);
+            return 0;
+        }
+
+        if (memcmp(_buf, DATA_FRAME_HEADER, 4) != 0) {
+            _counters.resyncBytes++;
+            consume(1);
+            return 0;
+        }
+
+        uint16_t dataLen = _buf[4] | (_buf[5] << 8);
+
+        // protect buffer, resync on the next header
+        if (dataLen > RADAR_MAX_PAYLOAD) {
+            _counters.badLength++;
+            consume(1);
+            return 0;
+        }
+
+        size_t frameLen = 6 + dataLen + 4;
+        if (_len < frameLen) return RADAR_PARSE_NEED_MORE;
+
+        if (memcmp(_buf + 6 + dataLen, DATA_FRAME_FOOTER, 4) != 0) {
+            _counters.footerMismatch++;
+            consume(1);
+            return 0;
+        }
+
+        // Handle Empty/Heartbeat frames (F4 F3 F2 F1 00 00 ...)
+        if (dataLen == 0) {
+            _counters.heartbeats++;
+            consume(frameLen);
+            return 0;
+        }
+
+        _counters.frames++;
+        _counters.frameBytes += frameLen;
+        const uint8_t *payload = _buf + 6;
+
+        int countDetected = payload[0];
+        int actualToRead = (countDetected > maxTargets) ? maxTargets : countDetected;
+        int decoded = 0;
+
+        for (int i = 0; i < actualToRead; i++) {
+
+            int base = 2 + (i * 5);
+
+            if (base + 4 < dataLen) {
+
+                uint8_t rawAngle = payload[base + 0];
+                targets[i].angle = (int)rawAngle - 0x80;  // convert to signed degrees
+
+                targets[i].distance = payload[base + 1];
+
+                uint8_t dirByte = payload[base + 2];
+                targets[i].approaching = (dirByte == 0x00);  // 00 = approaching
+
+                targets[i].speed = payload[base + 3];
+                targets[i].snr   = payload[base + 4];
+
+                targets[i].smoothedDist = targets[i].distance;
+                decoded++;
             }
-        } else {
-            ser.read(); // Discard non-header byte to find next alignment
         }
-        return 0;
+
+        consume(frameLen);
+        return decoded;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
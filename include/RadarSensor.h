@@ -0,0 +1,451 @@
+#ifndef RADAR_SENSOR_H
+#define RADAR_SENSOR_H
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include "LD2451_Defines.h"
+#include "FilterModule.h"
+#include "RadarParser.h"
+#include "RadarConfig.h"
+#include "RawTap.h"
+#include "LinkHealth.h"
+#include "ExclusionZones.h"
+#include "ClutterMap.h"
+
+// Core the UART ingest runs on: -1 = polled from loop(), 0/1 = dedicated pinned task
+#ifndef RADAR_INGEST_CORE
+#define RADAR_INGEST_CORE -1
+#endif
+
+struct RadarSettings {
+    uint8_t maxDist;
+    uint8_t direction;
+    uint8_t minSpeed;
+    uint8_t delayTime;
+    uint8_t triggerAcc;
+    uint8_t snrLimit;
+    uint8_t clutter;  // ClutterMode, applied on the device only
+};
+
+#define RADAR_BAUD_RATES    4    // rates tried by negotiateBaud()
+#define RADAR_RESTART_MS    2000 // radar reboot after a rate change, until it answers
+#define RADAR_VERIFY_READS  8    // parameter reads in a row that must succeed at a new rate
+
+// One rate tried during the last negotiation
+struct BaudProbe {
+    uint32_t baud;
+    bool     ok;
+    uint32_t readUs;  // parameter read round trip (command out, ACK in)
+};
+
+// Ingest side stats of one radar, published under the sensor lock after
+// every ingest pass for loop() and /stats
+struct RadarLinkStats {
+    LinkCounters counters;
+    float        intervalMs;
+    float        jitterMs;
+    ClutterStats clutter;
+};
+
+// One complete radar pipeline: UART, parser, filter, target store and config
+class RadarSensor {
+private:
+    uint8_t _id;
+    HardwareSerial &_ser;
+    int _txPin;
+    int _rxPin;
+
+    SignalFilter _filter;
+    LinkHealth _health;
+    RadarParser _parser;
+    ClutterMap _clutter; // only touched by ingest()
+
+    // Target store, written by ingest() and read by collect() (possibly on another core)
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    RadarTarget _targets[RADAR_MAX_TARGETS];
+    int _count = 0;
+    bool _fresh = false;
+    bool _resetFilter = false;
+    unsigned long _lastValidTime = 0;
+    RadarLinkStats _linkStats = {};
+
+    TaskHandle_t _task = nullptr;
+    // Held by the task while it ingests, by loop() between pause() and resume()
+    SemaphoreHandle_t _uartLock = nullptr;
+
+    uint32_t _baud = RADAR_BAUD_DEFAULT;
+    BaudProbe _probes[RADAR_BAUD_RATES]; // under _mux, /stats reads them on async_tcp
+    uint8_t _probeCount = 0;
+
+    void setBaud(uint32_t baud) {
+        _ser.updateBaudRate(baud);
+        while (_ser.available() > 0) _ser.read();
+        _baud = baud;
+    }
+
+    // Waits up to waitMs for the radar to answer at the current rate (it may
+    // be rebooting), then RADAR_VERIFY_READS parameter reads that must all
+    // succeed, then back to reporting. readUs gets the mean read round trip.
+    bool verify(uint32_t waitMs, uint32_t &readUs) {
+        static const uint8_t ENABLE[2] = { 0x01, 0x00 };
+        unsigned long start = millis();
+        for (;;) {
+            RadarConfig::sendCommand(_ser, 0x00FF, ENABLE, 2);
+            if (RadarConfig::readAck(_ser, 0x00FF, nullptr, 0) >= 0) break;
+            if (millis() - start >= waitMs) return false;
+        }
+
+        uint32_t total = 0;
+        bool ok = true;
+        for (int i = 0; i < RADAR_VERIFY_READS && ok; i++) {
+            uint8_t params[4];
+            uint32_t t0 = micros();
+            RadarConfig::sendCommand(_ser, 0x0012); // read detection parameters
+            ok = RadarConfig::readAck(_ser, 0x0012, params, sizeof(params)) == sizeof(params);
+            total += micros() - t0;
+        }
+        RadarConfig::sendCommand(_ser, 0x00FE);
+        RadarConfig::readAck(_ser, 0x00FE, nullptr, 0);
+        readUs = total / RADAR_VERIFY_READS;
+        return ok;
+    }
+
+    // Ask the radar (talking at the current rate) to move to baud and reboot.
+    // Each command is repeated until acknowledged; false if one never was.
+    bool requestBaud(uint32_t baud) {
+        static const uint8_t ENABLE[2] = { 0x01, 0x00 };
+        int index = RadarConfig::baudIndex(baud);
+        if (index < 0) return false;
+        uint8_t value[2] = { (uint8_t)index, 0x00 };
+
+        bool ok = false;
+        for (int i = 0; i < 3 && !ok; i++) {
+            RadarConfig::sendCommand(_ser, 0x00FF, ENABLE, 2);
+            ok = RadarConfig::readAck(_ser, 0x00FF, nullptr, 0) >= 0;
+        }
+        for (int i = 0; i < 3 && ok; i++) {
+            RadarConfig::sendCommand(_ser, 0x00A1, value, 2);
+            if (RadarConfig::readAck(_ser, 0x00A1, nullptr, 0) >= 0) break;
+            if (i == 2) ok = false;
+        }
+        if (!ok) return false;
+        RadarConfig::sendCommand(_ser, 0x00A3); // the new rate applies after a restart
+        delay(50);
+        return true;
+    }
+
+    // Get the radar back to baud after it was asked to move to other. It may
+    // have ignored the request or switched to a rate that does not work on
+    // this wiring; commands get lost on a bad link, so a few rounds.
+    bool recover(uint32_t baud, uint32_t other, uint32_t &readUs) {
+        for (int attempt = 0; attempt < 3; attempt++) {
+            setBaud(baud);
+            if (verify(attempt ? RADAR_RESTART_MS : RADAR_RESTART_MS / 4, readUs)) return true;
+            setBaud(other);
+            requestBaud(baud);
+        }
+        setBaud(baud);
+        return verify(RADAR_RESTART_MS, readUs);
+    }
+
+    void recordProbe(uint32_t baud, bool ok, uint32_t readUs) {
+        portENTER_CRITICAL(&_mux);
+        if (_probeCount < RADAR_BAUD_RATES) _probes[_probeCount++] = { baud, ok, readUs };
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    void publishStats() {
+        RadarLinkStats st = { _health.counters, _health.intervalMs(), _health.jitterMs(), _clutter.stats() };
+        portENTER_CRITICAL(&_mux);
+        _linkStats = st;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    static void ingestTask(void *arg) {
+        RadarSensor *self = (RadarSensor*)arg;
+        for (;;) {
+            // Drain everything buffered, then yield until more bytes arrive
+            xSemaphoreTake(self->_uartLock, portMAX_DELAY);
+            self->ingest();
+            xSemaphoreGive(self->_uartLock);
+            vTaskDelay(pdMS_TO_TICKS(2));
+        }
+    }
+
+public:
+    RadarSettings settings = {};
+    ByteRing tap; // raw UART bytes for the WS "raw" topic
+    ExclusionMap *exclusions = nullptr; // detections dropped before smoothing
+
+    RadarSensor(uint8_t id, HardwareSerial &ser, int txPin, int rxPin)
+        : _id(id), _ser(ser), _txPin(txPin), _rxPin(rxPin), _parser(_health.counters) {}
+
+    uint8_t id() const { return _id; }
+    HardwareSerial &serial() { return _ser; }
+
+    void begin(uint32_t baud = 115200) {
+        // Room for the slowest loop cadence (PowerPolicy standby) between reads
+        _ser.setRxBufferSize(1024);
+        _ser.begin(baud, SERIAL_8N1, _txPin, _rxPin);
+
+        // Runs on the UART event task; it is the only writer of these two counters
+        _ser.onReceiveError([this](hardwareSerial_error_t err) {
+            if (err == UART_BUFFER_FULL_ERROR || err == UART_FIFO_OVF_ERROR)
+                _health.counters.overruns++;
+            else
+                _health.counters.lineErrors++;
+        });
+    }
+
+    LinkHealth &health() { return _health; }
+
+    // Consistent copy of the ingest side counters, from any task
+    RadarLinkStats linkStats() {
+        portENTER_CRITICAL(&_mux);
+        RadarLinkStats st = _linkStats;
+        portEXIT_CRITICAL(&_mux);
+        return st;
+    }
+    uint32_t baud() const { return _baud; }
+
+    // Copies the rates tried by the last negotiation, returns their count
+    int baudProbes(BaudProbe out[RADAR_BAUD_RATES]) {
+        portENTER_CRITICAL(&_mux);
+        int n = _probeCount;
+        memcpy(out, _probes, n * sizeof(BaudProbe));
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    // loop() only: keeps the ingest task off the UART so loop() can talk to
+    // the radar (negotiateBaud at runtime). False if the task did not let go
+    // in time. Without a task loop() simply does not call ingest() meanwhile.
+    bool pause() {
+        return !_task || xSemaphoreTake(_uartLock, pdMS_TO_TICKS(100)) == pdTRUE;
+    }
+
+    void resume() {
+        if (_task) xSemaphoreGive(_uartLock);
+    }
+
+    // At setup, or between pause() and resume(): ingest must not run. Finds
+    // the radar at the stored rate (or the factory rate), then steps the
+    // link up one rate at a time up to RADAR_BAUD_MAX, each verified with
+    // parameter reads after the radar rebooted. The first rate that fails
+    // is abandoned: the radar is asked back to the last good rate, else to
+    // 115200. Returns the rate in use, to be stored; 0 forces a new
+    // negotiation from 115200.
+    uint32_t negotiateBaud(uint32_t stored) {
+        static const uint32_t RATES[RADAR_BAUD_RATES] = { 115200, 230400, 256000, 460800 };
+        uint32_t readUs = 0;
+        portENTER_CRITICAL(&_mux);
+        _probeCount = 0;
+        portEXIT_CRITICAL(&_mux);
+
+        // Stored rate: trust it, no stepping (one verify, fast boot)
+        if (stored) {
+            setBaud(stored);
+            if (verify(RADAR_ACK_TIMEOUT_MS * 3, readUs)) {
+                recordProbe(stored, true, readUs);
+                _health.counters = {};
+                publishStats();
+                return stored;
+            }
+        }
+
+        // Where is it? Factory rate first, then the others
+        uint32_t current = 0;
+        for (int i = 0; i < RADAR_BAUD_RATES && !current; i++) {
+            setBaud(RATES[i]);
+            if (verify(RADAR_ACK_TIMEOUT_MS * 3, readUs)) current = RATES[i];
+        }
+        if (!current) {
+            // Nothing answers (no radar, or it is still booting): keep the factory rate
+            setBaud(RADAR_BAUD_DEFAULT);
+            _health.counters = {};
+            publishStats();
+            return 0;
+        }
+        recordProbe(current, true, readUs);
+
+        for (int i = 0; i < RADAR_BAUD_RATES; i++) {
+            uint32_t next = RATES[i];
+            if (next <= current || next > RADAR_BAUD_MAX) continue;
+
+            requestBaud(next);
+            setBaud(next);
+            bool ok = verify(RADAR_RESTART_MS, readUs);
+            recordProbe(next, ok, readUs);
+            if (ok) { current = next; continue; }
+
+            // Back to the last good rate, else the factory one
+            if (!recover(current, next, readUs)) {
+                // Lost it: factory rate, negotiated again on the next boot
+                current = recover(RADAR_BAUD_DEFAULT, next, readUs) ? RADAR_BAUD_DEFAULT : 0;
+                if (!current) setBaud(RADAR_BAUD_DEFAULT);
+            }
+            break;
+        }
+
+        _health.counters = {}; // line errors from probing the wrong rates
+        publishStats();
+        return current;
+    }
+
+    void applySettings() {
+        // 1. Send configuration block (Enable -> Set Params -> End)
+        RadarConfig::sendDefaults(
+            _ser,
+            settings.maxDist,
+            settings.direction,
+            settings.minSpeed,
+            settings.delayTime,
+            settings.triggerAcc,
+            settings.snrLimit
+        );
+        delay(100);
+        // 2. Explicit "Start Reporting" command to ensure data flow
+        uint8_t startCmd[] = {
+            0xFD,0xFC,0xFB,0xFA,
+            0x04,0x00,
+            0x62,0x00,
+            0x04,0x03,0x02,0x01
+        };
+
+        _ser.write(startCmd, sizeof(startCmd));
+        _ser.flush();
+    }
+
+    // Start a pinned ingest task; without it ingest() must be called from loop()
+    void startTask(BaseType_t core) {
+        if (_task) return;
+        _uartLock = xSemaphoreCreateMutex();
+        char name[12];
+        snprintf(name, sizeof(name), "radar%u", _id);
+        xTaskCreatePinnedToCore(ingestTask, name, 4096, this, 3, &_task, core);
+    }
+
+    bool hasTask() const { return _task != nullptr; }
+
+    // Read everything the UART has buffered and parse all complete frames.
+    // Returns the target count of the newest frame with targets (0 otherwise).
+    int ingest() {
+        uint32_t t0 = micros();
+        // Filter state belongs to the ingest side, clear() only requests the reset
+        portENTER_CRITICAL(&_mux);
+        bool reset = _resetFilter;
+        _resetFilter = false;
+        portEXIT_CRITICAL(&_mux);
+        if (reset) {
+            for (int i = 0; i < RADAR_MAX_TARGETS; i++)
+                _filter.reset(i);
+        }
+
+        RadarTarget parsed[RADAR_MAX_TARGETS];
+        RadarTarget latest[RADAR_MAX_TARGETS];
+        int latestCount = 0;
+
+        for (;;) {
+            // Pull bytes into the parser; the tap gets an identical copy
+            int avail = _ser.available();
+            while (avail > 0 && _parser.space() > 0) {
+                uint8_t chunk[64];
+                size_t want = avail;
+                if (want > sizeof(chunk)) want = sizeof(chunk);
+                if (want > _parser.space()) want = _parser.space();
+
+                size_t got = _ser.read(chunk, want);
+                if (!got) break;
+                _parser.push(chunk, got);
+                tap.write(chunk, got);
+                avail -= got;
+            }
+
+            const LinkCounters &c = _health.counters;
+            uint32_t valid = c.frames + c.heartbeats;
+
+            int n = _parser.next(parsed, RADAR_MAX_TARGETS);
+            if (c.frames + c.heartbeats != valid) _health.onFrame(millis());
+            if (n == RADAR_PARSE_NEED_MORE) {
+                if (_ser.available() > 0 && _parser.space() > 0) continue;
+                break;
+            }
+            // A frame with only excluded detections counts as empty
+            if (n > 0 && exclusions) n = exclusions->apply(_id, parsed, n);
+            if (n > 0) n = _clutter.apply(settings.clutter, parsed, n, millis());
+            if (n > 0) {
+                memcpy(latest, parsed, n * sizeof(RadarTarget));
+                latestCount = n;
+            }
+        }
+
+        if (latestCount == 0) {
+            _health.counters.ingestUs += micros() - t0;
+            publishStats();
+            return 0;
+        }
+
+        // Smoothed once per delivered frame, with the real time since the last one
+        unsigned long now = millis();
+        for (int i = 0; i < latestCount; i++) {
+            latest[i].sensor = _id;
+            latest[i].vision = 0;
+            latest[i].motion = 0;
+            float speed = latest[i].speed / 3.6f;
+            latest[i].smoothedDist = _filter.smooth(i, (float)latest[i].distance,
+                                                    latest[i].approaching ? -speed : speed, now);
+        }
+        for (int i = latestCount; i < RADAR_MAX_TARGETS; i++)
+            _filter.reset(i);
+
+        portENTER_CRITICAL(&_mux);
+        memcpy(_targets, latest, latestCount * sizeof(RadarTarget));
+        _count = latestCount;
+        _fresh = true;
+        _lastValidTime = now;
+        portEXIT_CRITICAL(&_mux);
+
+        _health.counters.ingestUs += micros() - t0;
+        publishStats();
+        return latestCount;
+    }
+
+    // Returns true once per fresh frame delivered by ingest()
+    bool takeFresh() {
+        portENTER_CRITICAL(&_mux);
+        bool fresh = _fresh;
+        _fresh = false;
+        portEXIT_CRITICAL(&_mux);
+        return fresh;
+    }
+
+    // Copy the live targets (those seen within persistMs) into out. Returns the count copied.
+    int collect(RadarTarget *out, int maxOut, unsigned long now, unsigned long persistMs) {
+        portENTER_CRITICAL(&_mux);
+        int n = (now - _lastValidTime > persistMs) ? 0 : _count;
+        if (n > maxOut) n = maxOut;
+        memcpy(out, _targets, n * sizeof(RadarTarget));
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    // Drop the store and smoothing state once the persistence timeout expired
+    void clear() {
+        portENTER_CRITICAL(&_mux);
+        _count = 0;
+        _fresh = false;
+        _resetFilter = true;
+        portEXIT_CRITICAL(&_mux);
+    }
+};
+
+// Merge the targets of every sensor into one list tagged with the sensor index
+inline int mergeRadarTargets(RadarSensor *sensors, int sensorCount, RadarTarget *out, unsigned long now, unsigned long persistMs) {
+    int total = 0;
+    for (int s = 0; s < sensorCount; s++) {
+        total += sensors[s].collect(out + total, RADAR_MERGED_MAX - total, now, persistMs);
+    }
+    return total;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef RADAR_SNAPSHOT_H
+#define RADAR_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "LD2451_Defines.h"
+
+// Immutable view of one merged radar frame, published by loop()
+struct RadarSnapshot {
+    unsigned long timestamp; // frame time (millis), echoed by the vision client
+    int count;
+    bool veto;
+    RadarTarget targets[RADAR_MERGED_MAX];
+};
+
+// Single writer / many reader double-buffered seqlock.
+// Version v lives in _buf[v & 1], so a writer preempted in the middle of
+// publishing v+1 never blocks readers of v (important when the reader is
+// a higher priority task on the same core). Readers only retry if the
+// writer started overwriting their buffer while they were copying it.
+template <typename T>
+class SeqLock {
+private:
+    std::atomic<uint32_t> _begin{0};   // last version the writer started
+    std::atomic<uint32_t> _seq{0};     // last version fully published
+    T _buf[2];
+
+public:
+    SeqLock() { memset((void*)_buf, 0, sizeof(_buf)); }
+
+    // Writer side (one task only)
+    void publish(const T &value) {
+        uint32_t v = _seq.load(std::memory_order_relaxed) + 1;
+        _begin.store(v, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy((void*)&_buf[v & 1], &value, sizeof(T));
+        _seq.store(v, std::memory_order_release);
+    }
+
+    // Reader side (any task). Returns the version of the copy.
+    uint32_t read(T &out) const {
+        for (;;) {
+            uint32_t v = _seq.load(std::memory_order_acquire);
+
+            memcpy(&out, (const void*)&_buf[v & 1], sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Buffer v & 1 is rewritten by version v + 2
+            if (_begin.load(std::memory_order_relaxed) - v < 2)
+                return v;
+        }
+    }
+
+    uint32_t version() const {
+        return _seq.load(std::memory_order_acquire);
+    }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include <stdint.h>
+
+// Stream bitrate controller. Pure logic (no camera / socket access) so it can
+// be driven by recorded or simulated send timings; StreamServer applies the
+// chosen level to the sensor.
+//
+// Every frame reports its size, how long it took to hand to all viewers and
+// how many viewers took or skipped it. Once per window the controller looks at
+// the average send time, the skip ratio and the bitrate delivered to all
+// viewers together (they share the same radio):
+//
+//   congested : send time over budget, >10 % skipped, or bitrate over budget
+//   clear     : send time under half the budget, nothing skipped, bitrate < 70 %
+//
+// It steps down the ladder (JPEG quality first, then frame size) after
+// RATE_DOWN_WINDOWS congested windows and back up after RATE_UP_WINDOWS clear
+// ones. A level that got congested right after stepping up doubles the wait
+// before it is tried again, so a marginal link does not oscillate.
+
+#define RATE_WINDOW_MS      1000
+#define RATE_TARGET_SEND_MS 60     // per-frame send time budget
+#define RATE_MAX_KBPS       8000   // total stream bitrate budget
+#define RATE_DOWN_WINDOWS   2
+#define RATE_UP_WINDOWS     5
+#define RATE_MAX_BACKOFF    20     // longest wait before retrying a level (windows)
+#define RATE_STABLE_WINDOWS 30     // windows without a step up that reset the backoff
+
+struct RateLevel {
+    uint8_t framesize; // framesize_t
+    uint8_t quality;   // esp32-camera JPEG quality, lower = better
+};
+
+class RateController {
+public:
+    static const int LEVELS = 7;
+
+private:
+    // framesize_t values: FRAMESIZE_QVGA = 5, FRAMESIZE_HVGA = 7, FRAMESIZE_VGA = 8
+    static const RateLevel &ladder(int i) {
+        static const RateLevel LADDER[LEVELS] = {
+            {8, 10}, {8, 15}, {8, 22}, {8, 30},
+            {7, 22}, {5, 22}, {5, 30},
+        };
+        return LADDER[i];
+    }
+
+    int _level = 0;
+    uint8_t _bad = 0;
+    uint8_t _good = 0;
+    uint8_t _upWindows = RATE_UP_WINDOWS; // grows with backoff
+    uint8_t _sinceUp = 255;               // windows since the last step up
+
+    // Current window
+    uint32_t _windowStart = 0;
+    uint32_t _frames = 0;
+    uint64_t _bytes = 0;      // delivered bytes, summed over viewers
+    uint64_t _sendUs = 0;
+    uint32_t _delivered = 0;  // frame deliveries (frames x viewers)
+    uint32_t _skipped = 0;
+
+    // Last window results
+    uint32_t _kbps = 0;
+    uint32_t _avgSendMs = 0;
+    uint8_t _skipPct = 0;
+    uint32_t _changes = 0;
+
+public:
+    void onFrame(uint32_t bytes, uint32_t sendUs, uint8_t sent, uint8_t skipped) {
+        _frames++;
+        _bytes += (uint64_t)bytes * sent;
+        _sendUs += sendUs;
+        _delivered += sent;
+        _skipped += skipped;
+    }
+
+    // Close the window when due. Returns true when the level changed.
+    bool update(uint32_t now, int viewers) {
+        if (!_windowStart) { _windowStart = now; return false; }
+        uint32_t elapsed = now - _windowStart;
+        if (elapsed < RATE_WINDOW_MS) return false;
+
+        uint32_t offers = _delivered + _skipped;
+        _kbps = (uint32_t)(_bytes * 8 / elapsed); // bytes*8/ms = kbit/s
+        _avgSendMs = _frames ? (uint32_t)(_sendUs / _frames / 1000) : 0;
+        _skipPct = offers ? _skipped * 100 / offers : 0;
+
+        _windowStart = now;
+        _frames = _delivered = _skipped = 0;
+        _bytes = _sendUs = 0;
+
+        if (viewers <= 0 || !offers) return false;
+        if (_sinceUp < 255) _sinceUp++;
+
+        bool congested = _avgSendMs > RATE_TARGET_SEND_MS || _skipPct > 10 || _kbps > RATE_MAX_KBPS;
+        bool clear = _avgSendMs < RATE_TARGET_SEND_MS / 2 && _skipPct == 0 && _kbps < RATE_MAX_KBPS * 7 / 10;
+
+        if (congested) {
+            _good = 0;
+            if (++_bad >= RATE_DOWN_WINDOWS && _level < LEVELS - 1) {
+                // Failed right after a step up: wait longer before the next try
+                if (_sinceUp <= RATE_DOWN_WINDOWS + 1) {
+                    _upWindows = _upWindows * 2 > RATE_MAX_BACKOFF ? RATE_MAX_BACKOFF : _upWindows * 2;
+                }
+                _level++;
+                _bad = 0;
+                _changes++;
+                return true;
+            }
+        } else if (clear) {
+            _bad = 0;
+            if (++_good >= _upWindows && _level > 0) {
+                _level--;
+                _good = 0;
+                _sinceUp = 0;
+                _changes++;
+                return true;
+            }
+        } else {
+            _bad = 0;
+            _good = 0;
+        }
+
+        // A long stable stretch earns the fast step-up back
+        if (_sinceUp == RATE_STABLE_WINDOWS) _upWindows = RATE_UP_WINDOWS;
+        return false;
+    }
+
+    int level() const { return _level; }
+    RateLevel current() const { return ladder(_level); }
+    uint32_t kbps() const { return _kbps; }
+    uint32_t avgSendMs() const { return _avgSendMs; }
+    uint8_t skipPct() const { return _skipPct; }
+    uint32_t changes() const { return _changes; }
+};
+
+#endif
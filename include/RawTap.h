@@ -0,0 +1,76 @@
+#ifndef RAW_TAP_H
+#define RAW_TAP_H
+
+#include <Arduino.h>
+#include <atomic>
+
+#ifndef RAW_TAP_SIZE
+#define RAW_TAP_SIZE 2048 // power of two
+#endif
+
+// Bounded single producer / single consumer byte ring used to tee raw radar
+// UART bytes to the WS "raw" topic. The ingest path copies into it only while
+// enabled (someone subscribed), otherwise it costs one flag check per read.
+// When full, new bytes are dropped and counted, the parser is never affected.
+class ByteRing {
+private:
+    uint8_t _data[RAW_TAP_SIZE];
+    std::atomic<uint32_t> _head{0}; // written by producer
+    std::atomic<uint32_t> _tail{0}; // written by consumer
+    std::atomic<bool> _enabled{false};
+
+    uint32_t _teed = 0;    // bytes accepted (producer only)
+    uint32_t _dropped = 0; // bytes lost to overflow (producer only)
+
+public:
+    void setEnabled(bool on) {
+        if (on == _enabled.load(std::memory_order_relaxed)) return;
+        if (!on) _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+        _enabled.store(on, std::memory_order_release);
+    }
+
+    bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+    // Producer (radar ingest)
+    void write(const uint8_t *src, size_t len) {
+        if (!enabled()) return;
+
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        size_t space = RAW_TAP_SIZE - (head - tail);
+
+        if (len > space) {
+            _dropped += len - space;
+            len = space;
+        }
+
+        for (size_t i = 0; i < len; i++)
+            _data[(head + i) & (RAW_TAP_SIZE - 1)] = src[i];
+
+        _teed += len;
+        _head.store(head + len, std::memory_order_release);
+    }
+
+    // Consumer (network pump). Returns the number of bytes copied.
+    size_t read(uint8_t *dst, size_t maxLen) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        size_t len = head - tail;
+        if (len > maxLen) len = maxLen;
+
+        for (size_t i = 0; i < len; i++)
+            dst[i] = _data[(tail + i) & (RAW_TAP_SIZE - 1)];
+
+        _tail.store(tail + len, std::memory_order_release);
+        return len;
+    }
+
+    size_t available() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    }
+
+    uint32_t teed() const { return _teed; }
+    uint32_t dropped() const { return _dropped; }
+};
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef STREAM_FANOUT_H
+#define STREAM_FANOUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+
+// MJPEG fan-out to the /stream sockets that never blocks on a client.
+//
+// Every client sends one frame at a time from its own offset, with a single
+// writev() per attempt on a non-blocking socket. A frame is shared by all
+// clients still sending it (refcount). It borrows the camera buffer while
+// send() waits up to STREAM_PUMP_MS for the clients that started it, and is
+// only copied to the heap (PSRAM above 4 KB) if one of them is still behind
+// when the camera needs the buffer back. A client that is behind skips new
+// frames and is resumed on every pass until it has drained: a slow phone
+// costs neither the capture rate nor its connection.
+
+#ifndef STREAM_MAX_CLIENTS
+#define STREAM_MAX_CLIENTS 4
+#endif
+#define STREAM_PUMP_MS 40
+
+#define PART_BOUNDARY "123456789000000000000987654321"
+static const char* _STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
+// X-Timestamp: capture time in device ms (millis() clock), mappable to client time via /ws sync
+static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %u\r\n\r\n";
+
+struct StreamFrame {
+    uint8_t refs;         // clients sending it, 0 = free
+    bool    owned;        // jpeg is a heap copy
+    const uint8_t *jpeg;
+    size_t  len;
+    size_t  hlen;
+    size_t  total;        // part header + JPEG + boundary
+    char    header[96];
+};
+
+struct StreamSendResult {
+    uint8_t  sent;     // frames finished during the call (this one or an older one)
+    uint8_t  skipped;  // clients that did not start this frame
+    uint8_t  dropped;  // clients closed because their frame could not be copied
+    bool     copied;   // frame copied for a client that is behind
+    uint32_t us;       // time spent in send()
+};
+
+class StreamFanout {
+private:
+    struct Client {
+        int fd;
+        StreamFrame *frame; // being sent, nullptr = idle
+        size_t offset;      // bytes of frame already sent
+    };
+
+    enum Progress { DONE, PARTIAL, BLOCKED, FAILED };
+
+    Client _clients[STREAM_MAX_CLIENTS];
+    // Every client holds at most one frame, plus the one being offered
+    StreamFrame _frames[STREAM_MAX_CLIENTS + 1] = {};
+    int _count = 0;
+
+    StreamFrame *freeFrame() {
+        for (StreamFrame &f : _frames) {
+            if (!f.refs) return &f;
+        }
+        return nullptr; // not reached: one more frame than clients
+    }
+
+    void release(Client &c) {
+        StreamFrame *f = c.frame;
+        c.frame = nullptr;
+        c.offset = 0;
+        if (--f->refs == 0 && f->owned) {
+            free((void*)f->jpeg);
+            f->owned = false;
+        }
+    }
+
+    void closeClient(Client &c) {
+        if (c.frame) release(c);
+        close(c.fd);
+        c.fd = -1;
+        _count--;
+    }
+
+    Progress push(Client &c) {
+        const StreamFrame &f = *c.frame;
+        struct iovec iov[3] = {
+            { (void*)f.header, f.hlen },
+            { (void*)f.jpeg, f.len },
+            { (void*)_STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY) },
+        };
+
+        int first = 0;
+        size_t skip = c.offset;
+        while (skip >= iov[first].iov_len) skip -= iov[first++].iov_len;
+        iov[first].iov_base = (uint8_t*)iov[first].iov_base + skip;
+        iov[first].iov_len -= skip;
+
+        ssize_t sent = writev(c.fd, iov + first, 3 - first);
+        if (sent < 0)
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? BLOCKED : FAILED;
+
+        c.offset += sent;
+        return c.offset < f.total ? PARTIAL : DONE;
+    }
+
+    // Returns true while the client is still in the middle of its frame
+    bool resume(Client &c, StreamSendResult &r) {
+        switch (push(c)) {
+            case DONE:   release(c); r.sent++; return false;
+            case FAILED: closeClient(c); return false;
+            default:     return true;
+        }
+    }
+
+    // The camera wants its buffer back: clients still on f go on from a copy
+    void detach(StreamFrame *f, StreamSendResult &r) {
+        uint8_t *copy = (uint8_t*)malloc(f->len);
+        if (copy) {
+            memcpy(copy, f->jpeg, f->len);
+            f->jpeg = copy;
+            f->owned = true;
+            r.copied = true;
+            return;
+        }
+        // Out of memory: a part cannot be cut short, so its clients go
+        for (Client &c : _clients) {
+            if (c.fd >= 0 && c.frame == f) { closeClient(c); r.dropped++; }
+        }
+    }
+
+public:
+    StreamFanout() {
+        for (Client &c : _clients) c = { -1, nullptr, 0 };
+    }
+
+    // fd: non-blocking socket that already got the response headers
+    bool add(int fd) {
+        for (Client &c : _clients) {
+            if (c.fd >= 0) continue;
+            c = { fd, nullptr, 0 };
+            _count++;
+            return true;
+        }
+        return false;
+    }
+
+    int count() const { return _count; }
+    bool full() const { return _count >= STREAM_MAX_CLIENTS; }
+
+    // Clients in the middle of an older frame
+    int behind() const {
+        int n = 0;
+        for (const Client &c : _clients) n += c.fd >= 0 && c.frame;
+        return n;
+    }
+
+    // Offers a frame to every client: idle ones start it, the ones still on
+    // an older frame are resumed and skip it. Then waits up to STREAM_PUMP_MS
+    // for the clients that started it. jpeg only has to live until this returns.
+    StreamSendResult send(const uint8_t *jpeg, size_t len, uint32_t timestampMs) {
+        StreamSendResult r = {};
+        int64_t start = esp_timer_get_time();
+
+        StreamFrame *f = freeFrame();
+        f->jpeg = jpeg;
+        f->len = len;
+        f->owned = false;
+        f->hlen = snprintf(f->header, sizeof(f->header), _STREAM_PART, (unsigned)len, (unsigned)timestampMs);
+        f->total = f->hlen + len + strlen(_STREAM_BOUNDARY);
+
+        // 1. One writev per client
+        bool started[STREAM_MAX_CLIENTS] = {};
+        for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+            Client &c = _clients[i];
+            if (c.fd < 0) continue;
+
+            if (c.frame) {
+                r.skipped++;
+                resume(c, r);
+                continue;
+            }
+
+            c.frame = f;
+            f->refs++;
+            switch (push(c)) {
+                case DONE:    release(c); r.sent++; break;
+                case BLOCKED: release(c); r.skipped++; break; // send buffer full, not started
+                case PARTIAL: started[i] = true; break;
+                case FAILED:  closeClient(c); break;
+            }
+        }
+
+        // 2. Wait for the clients that started it; the ones behind move along too
+        int64_t deadline = start + STREAM_PUMP_MS * 1000LL;
+        for (;;) {
+            fd_set wfds;
+            FD_ZERO(&wfds);
+            int maxFd = -1;
+            bool waiting = false;
+            for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+                const Client &c = _clients[i];
+                if (c.fd < 0 || !c.frame) continue;
+                FD_SET(c.fd, &wfds);
+                if (c.fd > maxFd) maxFd = c.fd;
+                waiting |= started[i];
+            }
+            if (!waiting) break;
+
+            int64_t left = deadline - esp_timer_get_time();
+            if (left <= 0) break;
+
+            struct timeval tv = { (long)(left / 1000000), (long)(left % 1000000) };
+            if (select(maxFd + 1, NULL, &wfds, NULL, &tv) <= 0) continue;
+
+            for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+                Client &c = _clients[i];
+                if (c.fd < 0 || !c.frame || !FD_ISSET(c.fd, &wfds)) continue;
+                if (!resume(c, r)) started[i] = false;
+            }
+        }
+
+        // 3. Still behind: keep the frame past the camera buffer
+        if (f->refs) detach(f, r);
+
+        r.us = esp_timer_get_time() - start;
+        return r;
+    }
+
+    // Moves the clients that are behind along without waiting (passes
+    // without a frame). Returns the frames they finished.
+    uint8_t pump() {
+        StreamSendResult r = {};
+        for (Client &c : _clients) {
+            if (c.fd >= 0 && c.frame) resume(c, r);
+        }
+        return r.sent;
+    }
+};
+
+#endif
@@ -1,9 +1,98 @@
 #ifndef STREAM_SERVER_H
 #define STREAM_SERVER_H
 
+#include <stdint.h>
+
+struct CameraWakeStats {
+    uint32_t standbys; // sensor put in standby
+    uint32_t wakes;    // measured wake -> first good frame
+    uint32_t lastMs;
+    uint32_t avgMs;
+    uint32_t maxMs;
+};
+
+struct StreamStats {
+    uint32_t framesCaptured;
+    uint32_t framesSent;     // summed over clients
+    uint32_t framesSkipped;  // client still on an older frame or send buffer full
+    uint32_t clientsDropped; // frame could not be kept for a client behind (out of memory)
+    uint32_t frameCopies;    // frames copied out of the camera buffer for a client behind
+    uint32_t clientsBehind;  // clients in the middle of an older frame
+    uint32_t fpsX10;         // captured frames/s * 10
+    uint32_t lastSendUs;     // time spent offering the last frame to all clients
+    uint32_t avgSendUs;
+    // Rate controller
+    uint32_t kbps;           // delivered bitrate, all viewers, last window
+    uint8_t  rateLevel;      // 0 = best quality
+    uint32_t rateChanges;
+    uint8_t  quality;        // JPEG quality in use (lower = better)
+    uint16_t width;
+    uint16_t height;
+};
+
+struct MotionProfile;
+
+// On-device motion pre-filter (see MotionFilter.h), run by the stream task
+struct MotionKernelStats {
+    uint32_t images;      // luma images decoded
+    uint32_t pairs;       // image pairs differenced
+    uint32_t decodeUs;    // last JPEG -> luma decode
+    uint32_t kernelUs;    // last SWAR block SAD pass
+    uint32_t scalarUs;    // last scalar reference pass (every MOTION_VERIFY_EVERY pairs)
+    uint32_t verified;
+    uint32_t mismatches;  // SWAR and scalar disagreed
+    uint16_t width;
+    uint16_t height;
+};
+
+#define BURST_MAX_FRAMES 3
+
+struct BurstInfo {
+    uint32_t id;            // completed bursts, 0 = none captured yet
+    uint32_t triggerMs;     // millis() of the radar frame that triggered it
+    uint8_t  frames;
+    uint16_t width;
+    uint16_t height;
+    uint32_t firstStillMs;  // trigger -> first full resolution frame in hand
+    uint32_t durationMs;    // trigger -> sensor back at stream resolution
+    uint32_t streamGapMs;   // last stream frame before -> first after (0 = nobody watching)
+    uint32_t sizes[BURST_MAX_FRAMES];
+    uint32_t requested;
+    uint32_t completed;
+    uint32_t missed;        // camera asleep, busy or out of memory until the request expired
+};
+
 void startCameraServer();
 void enterLowPowerMode();
 void exitLowPowerMode();
 bool isLowPower();
+int streamClientCount();
+CameraWakeStats getCameraWakeStats();
+StreamStats getStreamStats();
+
+// Luma images are only taken while loop() wants motion verdicts
+void setMotionWanted(bool wanted);
+// Latest image pair profile; false until one was differenced
+bool getMotionProfile(MotionProfile &out);
+MotionKernelStats getMotionKernelStats();
+
+// /cam flip / mirror, applied by the stream task (see CommandMailbox.h).
+// Returns the ticket, 0 when the queue is full.
+struct MailboxStats;
+uint32_t postCameraCommand(uint8_t type);
+bool cameraCommandApplied(uint32_t ticket);
+MailboxStats getCameraCommandStats();
+
+// Full resolution burst, captured by the stream task (the camera owner)
+void requestBurst(uint32_t triggerMs);
+BurstInfo getBurstInfo();
+// Pins the burst in memory until releaseBurst(). nullptr if there is no such frame.
+const uint8_t *acquireBurstFrame(int n, size_t *len);
+void releaseBurst();
+
+// Releases an acquired burst frame when a response that outlives its handler is destroyed
+struct BurstLease {
+    ~BurstLease() { releaseBurst(); }
+};
 
 #endif
\ No newline at end of file
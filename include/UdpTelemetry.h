@@ -0,0 +1,120 @@
+#ifndef UDP_TELEMETRY_H
+#define UDP_TELEMETRY_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+// Optional UDP radar channel next to /ws. A lost datagram is simply gone, so
+// one bad packet never holds back the newer ones behind it (no head-of-line
+// blocking); clients use the sequence number to spot and skip gaps. The
+// current state is repeated every UDP_REFRESH_MS so a lost "all clear" heals.
+//
+// Datagram (little endian): 'T', version, uint32 seq, uint32 send time (ms),
+// then the radar record exactly as on the WS binary format ('R' ...).
+#define UDP_MAX_CLIENTS 4
+#define UDP_LEASE_MS    30000 // registrations expire unless renewed
+#define UDP_REFRESH_MS  500
+
+struct UdpClient {
+    IPAddress ip;
+    uint16_t  port;
+    uint32_t  expires;
+    bool      used;
+};
+
+struct UdpStats {
+    uint32_t seq;     // last sequence number sent
+    uint32_t packets; // datagrams sent, summed over clients
+    uint32_t errors;  // failed sends
+};
+
+class UdpTelemetry {
+private:
+    static const uint8_t UDP_TYPE = 0x54;
+    static const uint8_t UDP_VERSION = 1;
+
+    WiFiUDP _udp;
+    // Registrations come from the async HTTP task, sends happen in loop()
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    UdpClient _clients[UDP_MAX_CLIENTS];
+    UdpStats _stats = {};
+    uint32_t _lastSend = 0;
+
+public:
+    UdpTelemetry() {
+        for (int i = 0; i < UDP_MAX_CLIENTS; i++) _clients[i].used = false;
+    }
+
+    // Register or renew. Returns false when the table is full.
+    bool add(IPAddress ip, uint16_t port, uint32_t now) {
+        bool ok = false;
+        portENTER_CRITICAL(&_mux);
+        int slot = -1;
+        for (int i = 0; i < UDP_MAX_CLIENTS; i++) {
+            if (_clients[i].used && _clients[i].ip == ip && _clients[i].port == port) { slot = i; break; }
+            if (slot < 0 && (!_clients[i].used || (int32_t)(now - _clients[i].expires) > 0)) slot = i;
+        }
+        if (slot >= 0) {
+            _clients[slot] = { ip, port, now + UDP_LEASE_MS, true };
+            ok = true;
+        }
+        portEXIT_CRITICAL(&_mux);
+        return ok;
+    }
+
+    void remove(IPAddress ip, uint16_t port) {
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < UDP_MAX_CLIENTS; i++) {
+            if (_clients[i].used && _clients[i].ip == ip && _clients[i].port == port) _clients[i].used = false;
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // Live registrations copied into out. Returns the count.
+    int copy(UdpClient *out, uint32_t now) {
+        int n = 0;
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < UDP_MAX_CLIENTS; i++) {
+            if (_clients[i].used && (int32_t)(now - _clients[i].expires) > 0) _clients[i].used = false;
+            if (_clients[i].used) out[n++] = _clients[i];
+        }
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    int count(uint32_t now) {
+        UdpClient c[UDP_MAX_CLIENTS];
+        return copy(c, now);
+    }
+
+    // Nothing sent for UDP_REFRESH_MS: time to repeat the current state
+    bool refreshDue(uint32_t now) const { return now - _lastSend >= UDP_REFRESH_MS; }
+
+    // Send one radar record to every registered client under a new sequence number
+    void send(const uint8_t *record, size_t len, uint32_t now) {
+        UdpClient c[UDP_MAX_CLIENTS];
+        int n = copy(c, now);
+        _lastSend = now;
+        if (!n) return;
+
+        uint8_t header[10];
+        uint32_t seq = ++_stats.seq;
+        header[0] = UDP_TYPE;
+        header[1] = UDP_VERSION;
+        memcpy(header + 2, &seq, 4);
+        memcpy(header + 6, &now, 4);
+
+        for (int i = 0; i < n; i++) {
+            if (!_udp.beginPacket(c[i].ip, c[i].port)) { _stats.errors++; continue; }
+            _udp.write(header, sizeof(header));
+            _udp.write(record, len);
+            if (_udp.endPacket()) _stats.packets++;
+            else _stats.errors++;
+        }
+    }
+
+    const UdpStats &stats() const { return _stats; }
+};
+
+#endif
@@ -0,0 +1,283 @@
+#ifndef VISION_FEEDBACK_H
+#define VISION_FEEDBACK_H
+
+#include <Arduino.h>
+#include "LD2451_Defines.h"
+
+// Binary WS message sent back by the vision (YOLO) client.
+// Little endian, keyed to the "timestamp" of the radar message it answers:
+//   [0]    'V' message type
+//   [1]    version (1)
+//   [2..5] uint32 radar frame timestamp (ms)
+//   [6]    entry count (max 5)
+//   then per entry (10 bytes): id, verdict, x, y, w, h (uint16 bbox in camera pixels)
+#define VISION_MSG_TYPE     0x56
+#define VISION_MSG_VERSION  1
+#define VISION_HEADER_LEN   7
+#define VISION_ENTRY_LEN    10
+#define VISION_MAX_ENTRIES  5
+
+#define VISION_MAX_AGE_MS   400  // verdicts older than this are dropped (a late veto is useless)
+#define VISION_HOLD_MS      1000 // how long an applied verdict keeps following its car
+#define VISION_HISTORY      8    // published frames remembered to resolve verdict ids
+#define VISION_MATCH_M      3    // distance tolerance when following a car, plus its travel
+#define VISION_MATCH_DEG    8    // angle tolerance when following a car
+
+enum VisionVerdict : uint8_t {
+    VISION_UNKNOWN = 0,
+    VISION_CONFIRM = 1,
+    VISION_VETO    = 2
+};
+
+struct VisionBox {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+struct VisionStats {
+    uint32_t received;   // well formed messages
+    uint32_t malformed;  // wrong type/version/length
+    uint32_t late;       // dropped because frame was older than VISION_MAX_AGE_MS (or no longer known)
+    uint32_t applied;    // messages applied to the target list
+    uint32_t lost;       // verdicts whose car could not be followed to the current frame
+    uint32_t lastMs;     // radar frame -> applied latency of the last message
+    uint32_t avgMs;      // EMA of the latency
+    uint32_t maxMs;
+};
+
+// The "id" of an entry is the index of the target in the radar message it
+// answers, and the target list is re-ordered every frame (sensors merged,
+// targets coming and going). So ids are resolved against the published frame
+// they refer to, and the verdict then follows that car by sensor, distance and
+// angle, not by slot.
+class VisionFeedback {
+private:
+    struct Entry {
+        uint8_t   id;
+        uint8_t   verdict;
+        VisionBox box;
+    };
+
+    // One car a verdict sticks to, moved along with it every frame
+    struct Track {
+        uint8_t   verdict;
+        VisionBox box;
+        uint8_t   sensor;
+        uint8_t   distance;
+        int8_t    angle;
+        uint8_t   speed;
+        uint32_t  seenMs;
+    };
+
+    struct Frame {
+        uint32_t    ts;
+        uint8_t     count;
+        RadarTarget targets[RADAR_MERGED_MAX];
+    };
+
+    // Guards the pending message and the stats (read by the HTTP / stats writer)
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Written by the async TCP task, consumed by loop()
+    Entry    _pending[VISION_MAX_ENTRIES];
+    uint8_t  _pendingCount = 0;
+    uint32_t _pendingFrameTs = 0;
+    bool     _hasPending = false;
+
+    // Owned by loop()
+    Frame    _history[VISION_HISTORY];
+    uint8_t  _historyNext = 0;
+    Track    _tracks[VISION_MAX_ENTRIES];
+    uint8_t  _trackCount = 0;
+    uint32_t _activeFrameTs = 0;
+    int8_t   _trackOf[RADAR_MERGED_MAX]; // current target -> track, -1 = none
+
+    VisionStats _stats = {};
+
+    static uint16_t rd16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+    static uint32_t rd32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+    void countMalformed() {
+        portENTER_CRITICAL(&_mux);
+        _stats.malformed++;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    const Frame *findFrame(uint32_t ts) const {
+        // Newest first, a timestamp can repeat within one millisecond
+        for (int k = 1; k <= VISION_HISTORY; k++) {
+            const Frame &f = _history[(_historyNext + VISION_HISTORY - k) % VISION_HISTORY];
+            if (f.count && f.ts == ts) return &f;
+        }
+        return nullptr;
+    }
+
+    // Pins each track to the closest current target of its sensor (one target
+    // per track), allowing for the distance covered since it was last seen
+    void follow(const RadarTarget *targets, int count, unsigned long now) {
+        memset(_trackOf, -1, sizeof(_trackOf));
+
+        for (int k = 0; k < _trackCount; k++) {
+            Track &tr = _tracks[k];
+            int travel = (int)((uint32_t)tr.speed * (now - tr.seenMs) / 3600);
+            int best = -1, bestCost = 0;
+            for (int i = 0; i < count; i++) {
+                const RadarTarget &t = targets[i];
+                if (_trackOf[i] >= 0 || t.sensor != tr.sensor) continue;
+                int dd = abs((int)t.distance - tr.distance);
+                int da = abs((int)t.angle - tr.angle);
+                if (dd > VISION_MATCH_M + travel || da > VISION_MATCH_DEG) continue;
+                int cost = dd * 4 + da;
+                if (best < 0 || cost < bestCost) { best = i; bestCost = cost; }
+            }
+            if (best < 0) continue;
+
+            _trackOf[best] = k;
+            tr.distance = targets[best].distance;
+            tr.angle = targets[best].angle;
+            tr.speed = targets[best].speed;
+            tr.seenMs = now;
+        }
+    }
+
+public:
+    VisionFeedback() {
+        memset(_pending, 0, sizeof(_pending));
+        memset(_history, 0, sizeof(_history));
+        memset(_trackOf, -1, sizeof(_trackOf));
+    }
+
+    // Called from the WS event handler (async TCP task)
+    bool ingest(const uint8_t *data, size_t len) {
+        if (len < VISION_HEADER_LEN || data[0] != VISION_MSG_TYPE || data[1] != VISION_MSG_VERSION) {
+            countMalformed();
+            return false;
+        }
+
+        uint8_t count = data[6];
+        if (count > VISION_MAX_ENTRIES || len != VISION_HEADER_LEN + count * VISION_ENTRY_LEN) {
+            countMalformed();
+            return false;
+        }
+
+        Entry entries[VISION_MAX_ENTRIES];
+        uint8_t n = 0;
+
+        for (int i = 0; i < count; i++) {
+            const uint8_t *e = data + VISION_HEADER_LEN + i * VISION_ENTRY_LEN;
+            if (e[0] >= RADAR_MERGED_MAX || e[1] == VISION_UNKNOWN || e[1] > VISION_VETO) continue;
+
+            entries[n++] = { e[0], e[1], { rd16(e + 2), rd16(e + 4), rd16(e + 6), rd16(e + 8) } };
+        }
+
+        portENTER_CRITICAL(&_mux);
+        memcpy(_pending, entries, n * sizeof(Entry));
+        _pendingCount = n;
+        _pendingFrameTs = rd32(data + 2);
+        _hasPending = true;
+        _stats.received++;
+        portEXIT_CRITICAL(&_mux);
+
+        return true;
+    }
+
+    // Called from loop() with every published radar frame, so the ids of a
+    // verdict can be resolved to the cars they meant
+    void record(uint32_t frameTs, const RadarTarget *targets, int count) {
+        Frame &f = _history[_historyNext];
+        _historyNext = (_historyNext + 1) % VISION_HISTORY;
+        f.ts = frameTs;
+        f.count = count;
+        memcpy(f.targets, targets, count * sizeof(RadarTarget));
+    }
+
+    // Called from loop() after every parsed frame. Tags targets with the
+    // latest verdict and returns true if any current target is vetoed.
+    bool apply(RadarTarget *targets, int count, unsigned long now) {
+
+        Entry entries[VISION_MAX_ENTRIES];
+        uint8_t n = 0;
+        uint32_t frameTs = 0;
+        bool fresh = false, resolved = false;
+
+        portENTER_CRITICAL(&_mux);
+        if (_hasPending) {
+            n = _pendingCount;
+            memcpy(entries, _pending, n * sizeof(Entry));
+            frameTs = _pendingFrameTs;
+            _hasPending = false;
+            fresh = true;
+        }
+        portEXIT_CRITICAL(&_mux);
+
+        if (fresh) {
+            uint32_t latency = now - frameTs;
+            const Frame *frame = latency > VISION_MAX_AGE_MS ? nullptr : findFrame(frameTs);
+
+            if (!frame) {
+                portENTER_CRITICAL(&_mux);
+                _stats.late++;
+                portEXIT_CRITICAL(&_mux);
+            } else {
+                // A new message replaces all verdicts of the previous one
+                _trackCount = 0;
+                for (int e = 0; e < n; e++) {
+                    if (entries[e].id >= frame->count) continue;
+                    const RadarTarget &t = frame->targets[entries[e].id];
+                    _tracks[_trackCount++] = {
+                        entries[e].verdict, entries[e].box,
+                        t.sensor, t.distance, t.angle, t.speed, frameTs
+                    };
+                }
+                _activeFrameTs = frameTs;
+                resolved = true;
+
+                portENTER_CRITICAL(&_mux);
+                _stats.applied++;
+                _stats.lastMs = latency;
+                _stats.avgMs = _stats.applied == 1 ? latency : (_stats.avgMs * 7 + latency) / 8;
+                if (latency > _stats.maxMs) _stats.maxMs = latency;
+                portEXIT_CRITICAL(&_mux);
+            }
+        }
+
+        if (_trackCount && now - _activeFrameTs > VISION_HOLD_MS)
+            _trackCount = 0;
+
+        follow(targets, count, now);
+
+        bool vetoed = false;
+        uint32_t lost = 0;
+        for (int k = 0; k < _trackCount; k++) {
+            if (_tracks[k].seenMs != now) lost++;
+        }
+        for (int i = 0; i < count; i++) {
+            targets[i].vision = _trackOf[i] >= 0 ? _tracks[_trackOf[i]].verdict : VISION_UNKNOWN;
+            if (targets[i].vision == VISION_VETO) vetoed = true;
+        }
+        if (resolved && lost) {
+            portENTER_CRITICAL(&_mux);
+            _stats.lost += lost;
+            portEXIT_CRITICAL(&_mux);
+        }
+        return vetoed;
+    }
+
+    // Box of the current target (index into the list last passed to apply())
+    bool box(int target, VisionBox &out) const {
+        if (target < 0 || target >= RADAR_MERGED_MAX || _trackOf[target] < 0) return false;
+        out = _tracks[_trackOf[target]].box;
+        return true;
+    }
+
+    VisionStats stats() {
+        portENTER_CRITICAL(&_mux);
+        VisionStats s = _stats;
+        portEXIT_CRITICAL(&_mux);
+        return s;
+    }
+};
+
+#endif
@@ -0,0 +1,203 @@
+#ifndef WS_TOPICS_H
+#define WS_TOPICS_H
+
+#include <Arduino.h>
+#include <memory>
+#include <vector>
+
+// WebSocket topics a client can subscribe to (bit mask)
+#define WS_TOPIC_RADAR   0x01
+#define WS_TOPIC_STATS   0x02
+#define WS_TOPIC_RAW     0x04
+#define WS_TOPIC_EVENTS  0x08
+#define WS_TOPIC_SYNC    0x10 // clock exchange requests, see ClockSync.h
+
+// Payload format of the radar topic (stats/events are always JSON, raw is always binary)
+#define WS_FORMAT_JSON   0
+#define WS_FORMAT_BINARY 1
+
+// Radar target fields selectable for the JSON format ("id" is always sent)
+#define WS_FIELD_DISTANCE    0x01
+#define WS_FIELD_SPEED       0x02
+#define WS_FIELD_APPROACHING 0x04
+#define WS_FIELD_ANGLE       0x08
+#define WS_FIELD_SNR         0x10
+#define WS_FIELD_SMOOTHDIS   0x20
+#define WS_FIELD_VISION      0x40
+#define WS_FIELD_SENSOR      0x80
+#define WS_FIELD_ALL         0xFF
+
+#define WS_MAX_CLIENTS 8
+
+// One serialized message, shared by every client queue it is put on
+typedef std::shared_ptr<std::vector<uint8_t>> WsBuffer;
+
+struct WsSubscription {
+    uint32_t clientId;
+    uint8_t  topics;
+    uint8_t  format;
+    uint8_t  fields;
+    bool     used;
+};
+
+// Per client subscription table. Written from the async TCP task (WS events),
+// copied out by loop() when it fans updates out.
+class WsSubscriptions {
+private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    WsSubscription _subs[WS_MAX_CLIENTS];
+
+    struct Name {
+        const char *name;
+        uint8_t bit;
+    };
+
+    static uint8_t lookup(const Name *names, int count, const char *list) {
+        char buf[96];
+        strncpy(buf, list, sizeof(buf) - 1);
+        buf[sizeof(buf) - 1] = '\0';
+
+        uint8_t mask = 0;
+        char *save = nullptr;
+        for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(nullptr, ",", &save)) {
+            for (int i = 0; i < count; i++) {
+                if (!strcmp(tok, names[i].name)) mask |= names[i].bit;
+            }
+        }
+        return mask;
+    }
+
+public:
+    WsSubscriptions() { memset(_subs, 0, sizeof(_subs)); }
+
+    // New clients get what every client got before topics existed: full radar JSON
+    bool add(uint32_t clientId) {
+        portENTER_CRITICAL(&_mux);
+        bool added = false;
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (!_subs[i].used) {
+                _subs[i] = { clientId, WS_TOPIC_RADAR, WS_FORMAT_JSON, WS_FIELD_ALL, true };
+                added = true;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&_mux);
+        return added;
+    }
+
+    void remove(uint32_t clientId) {
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (_subs[i].used && _subs[i].clientId == clientId) _subs[i].used = false;
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // Parse "topics=radar,stats;fmt=json;fields=distance,speed" and apply it.
+    // Keys that are left out keep their current value.
+    bool configure(uint32_t clientId, const char *msg, size_t len, WsSubscription &out) {
+        static const Name TOPICS[] = {
+            {"radar", WS_TOPIC_RADAR}, {"stats", WS_TOPIC_STATS},
+            {"raw", WS_TOPIC_RAW},     {"events", WS_TOPIC_EVENTS},
+            {"sync", WS_TOPIC_SYNC},
+        };
+        static const Name FIELDS[] = {
+            {"distance", WS_FIELD_DISTANCE}, {"speed", WS_FIELD_SPEED},
+            {"approaching", WS_FIELD_APPROACHING}, {"angle", WS_FIELD_ANGLE},
+            {"snr", WS_FIELD_SNR}, {"smoothdis", WS_FIELD_SMOOTHDIS},
+            {"vision", WS_FIELD_VISION}, {"sensor", WS_FIELD_SENSOR},
+            {"all", WS_FIELD_ALL},
+        };
+
+        char buf[128];
+        if (len >= sizeof(buf)) return false;
+        memcpy(buf, msg, len);
+        buf[len] = '\0';
+
+        int topics = -1, format = -1, fields = -1;
+
+        char *save = nullptr;
+        for (char *kv = strtok_r(buf, ";", &save); kv; kv = strtok_r(nullptr, ";", &save)) {
+            char *eq = strchr(kv, '=');
+            if (!eq) continue;
+            *eq = '\0';
+            const char *val = eq + 1;
+
+            if (!strcmp(kv, "topics"))
+                topics = lookup(TOPICS, sizeof(TOPICS) / sizeof(TOPICS[0]), val);
+            else if (!strcmp(kv, "fmt"))
+                format = !strcmp(val, "bin") ? WS_FORMAT_BINARY : WS_FORMAT_JSON;
+            else if (!strcmp(kv, "fields"))
+                fields = lookup(FIELDS, sizeof(FIELDS) / sizeof(FIELDS[0]), val);
+        }
+
+        if (topics < 0 && format < 0 && fields < 0) return false;
+
+        bool found = false;
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (_subs[i].used && _subs[i].clientId == clientId) {
+                if (topics >= 0) _subs[i].topics = topics;
+                if (format >= 0) _subs[i].format = format;
+                if (fields >= 0) _subs[i].fields = fields;
+                out = _subs[i];
+                found = true;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&_mux);
+        return found;
+    }
+
+    // Consistent copy of the table for one fan-out pass. Returns the entry count.
+    int copy(WsSubscription *out) {
+        int n = 0;
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (_subs[i].used) out[n++] = _subs[i];
+        }
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    // Serialize a topic once per distinct (format, fields) among its subscribers
+    // into scratch and hand that one shared buffer to every matching client:
+    // deliver(clientId, buffer, binary). Topics whose payload does not depend
+    // on format/fields are serialized exactly once.
+    template <typename Serializer, typename Deliver>
+    void fanOut(uint8_t topic, bool perFormat, const uint8_t *scratch, Serializer serialize, Deliver deliver) {
+        WsSubscription subs[WS_MAX_CLIENTS];
+        int n = copy(subs);
+        bool done[WS_MAX_CLIENTS] = {};
+
+        for (int i = 0; i < n; i++) {
+            if (done[i] || !(subs[i].topics & topic)) continue;
+
+            bool binary = false;
+            size_t len = serialize(subs[i].format, subs[i].fields, binary);
+
+            WsBuffer shared;
+            if (len) shared = std::make_shared<std::vector<uint8_t>>(scratch, scratch + len);
+
+            for (int j = i; j < n; j++) {
+                if (done[j] || !(subs[j].topics & topic)) continue;
+                if (perFormat && (subs[j].format != subs[i].format || subs[j].fields != subs[i].fields)) continue;
+                done[j] = true;
+                if (shared) deliver(subs[j].clientId, shared, binary);
+            }
+        }
+    }
+
+    // Topics anyone is subscribed to (lets producers skip work nobody reads)
+    uint8_t activeTopics() {
+        uint8_t mask = 0;
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (_subs[i].used) mask |= _subs[i].topics;
+        }
+        portEXIT_CRITICAL(&_mux);
+        return mask;
+    }
+};
+
+#endif
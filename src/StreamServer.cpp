@@ -1,28 +1,430 @@
 #include "StreamServer.h"
-#include "esp_http_server.h"
 #include "esp_camera.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include <fcntl.h>
+#include <errno.h>
+#include "Camera.h"
+#include "RateController.h"
+#include "MotionFilter.h"
+#include "CommandMailbox.h"
+#include "StreamFanout.h"
+#include "esp_jpg_decode.h"
 #include <Arduino.h>
 
-// ===== MJPEG headers =====
-#define PART_BOUNDARY "123456789000000000000987654321"
-static const char* _STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
-static const char* _STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
-static const char* _STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n";
+static volatile bool streamLowPower = false;
+static volatile int streamClients = 0;
+// Held by standby / resume and by every sensor access of the stream task
+// (captures, burst, rate and camera commands): XCLK never stops mid-capture
+static SemaphoreHandle_t powerLock = NULL;
 
-static bool streamLowPower = false;
+// Frames discarded after a resume while AEC/AWB settle
+#define CAMERA_SETTLE_FRAMES 3
+// A wake is only measured if a frame is grabbed within this window
+#define CAMERA_WAKE_MEASURE_MS 3000
+
+// Wake stats are written by loop() (standby) and the stream task (wake),
+// stream stats by the stream task; /stats copies them on the async_tcp task
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+static CameraWakeStats wakeStats = {};
+static unsigned long wakeStartedMs = 0;
+static int settleFramesLeft = 0;
 
 void enterLowPowerMode() {
-    streamLowPower = true;
+    if (!powerLock) powerLock = xSemaphoreCreateMutex();
+    xSemaphoreTake(powerLock, portMAX_DELAY);
+
+    if (!streamLowPower) {
+        streamLowPower = true;
+        Camera::standby();
+        portENTER_CRITICAL(&statsMux);
+        wakeStats.standbys++;
+        portEXIT_CRITICAL(&statsMux);
+    }
+
+    xSemaphoreGive(powerLock);
 }
 
 void exitLowPowerMode() {
-    streamLowPower = false;
+    if (!powerLock) powerLock = xSemaphoreCreateMutex();
+    xSemaphoreTake(powerLock, portMAX_DELAY);
+
+    if (streamLowPower) {
+        Camera::resume();
+        wakeStartedMs = millis();
+        settleFramesLeft = CAMERA_SETTLE_FRAMES;
+        streamLowPower = false;
+    }
+
+    xSemaphoreGive(powerLock);
 }
 
 bool isLowPower() {
     return streamLowPower;
 }
 
+int streamClientCount() {
+    return streamClients;
+}
+
+CameraWakeStats getCameraWakeStats() {
+    portENTER_CRITICAL(&statsMux);
+    CameraWakeStats st = wakeStats;
+    portEXIT_CRITICAL(&statsMux);
+    return st;
+}
+
+// Grab a frame that is usable after a wake: the first frames out of standby
+// are stale or badly exposed and get dropped. Records wake -> good frame time.
+// nullptr while the camera is in standby or changing state.
+static camera_fb_t *captureGoodFrame() {
+    if (streamLowPower || xSemaphoreTake(powerLock, 0) != pdTRUE) return nullptr;
+    if (streamLowPower) { xSemaphoreGive(powerLock); return nullptr; }
+    camera_fb_t *fb = esp_camera_fb_get();
+
+    while (fb && settleFramesLeft > 0) {
+        settleFramesLeft--;
+        esp_camera_fb_return(fb);
+        fb = esp_camera_fb_get();
+    }
+
+    if (fb && wakeStartedMs) {
+        uint32_t latency = millis() - wakeStartedMs;
+        wakeStartedMs = 0;
+
+        if (latency <= CAMERA_WAKE_MEASURE_MS) {
+            portENTER_CRITICAL(&statsMux);
+            wakeStats.wakes++;
+            wakeStats.lastMs = latency;
+            wakeStats.avgMs = wakeStats.wakes == 1 ? latency : (wakeStats.avgMs * 7 + latency) / 8;
+            if (latency > wakeStats.maxMs) wakeStats.maxMs = latency;
+            portEXIT_CRITICAL(&statsMux);
+        }
+    }
+
+    xSemaphoreGive(powerLock);
+    return fb;
+}
+
+// ===== Burst capture =====
+// A rapid approach switches the sensor to UXGA for a few frames (the frame
+// buffers are allocated for UXGA at init, so no re-init is needed), copies
+// them to PSRAM and switches back. Frames already queued at the old size are
+// skipped on both sides of the switch. The burst stays readable over HTTP
+// until the next one replaces it; a new burst waits while a download runs.
+
+#define BURST_FRAMES      BURST_MAX_FRAMES
+#define BURST_MAX_STALE   4     // queued frames of the wrong size tolerated per switch
+#define BURST_PENDING_MS  2000  // a request not served by then is dropped
+#define BURST_COOLDOWN_MS 5000
+
+struct BurstFrame {
+    uint8_t *buf;
+    size_t   len;
+};
+
+static portMUX_TYPE burstMux = portMUX_INITIALIZER_UNLOCKED;
+static BurstFrame burstFrames[BURST_FRAMES] = {};
+static BurstInfo burstInfo = {};
+static int burstReaders = 0;
+static bool burstWriting = false;
+static bool burstPending = false;
+static uint32_t burstRequestMs = 0;
+static uint32_t lastBurstMs = 0;
+
+// Stream gap bookkeeping (stream task only)
+static unsigned long lastStreamFrameMs = 0;
+static unsigned long burstGapFrom = 0;
+static uint16_t streamWidth = 0;
+
+void requestBurst(uint32_t triggerMs) {
+    portENTER_CRITICAL(&burstMux);
+    if (!burstPending && (burstInfo.requested == 0 || triggerMs - lastBurstMs >= BURST_COOLDOWN_MS)) {
+        burstPending = true;
+        burstRequestMs = triggerMs;
+        lastBurstMs = triggerMs;
+        burstInfo.requested++;
+    }
+    portEXIT_CRITICAL(&burstMux);
+}
+
+BurstInfo getBurstInfo() {
+    portENTER_CRITICAL(&burstMux);
+    BurstInfo info = burstInfo;
+    portEXIT_CRITICAL(&burstMux);
+    return info;
+}
+
+const uint8_t *acquireBurstFrame(int n, size_t *len) {
+    const uint8_t *buf = nullptr;
+    portENTER_CRITICAL(&burstMux);
+    if (!burstWriting && n >= 0 && n < burstInfo.frames && burstFrames[n].buf) {
+        buf = burstFrames[n].buf;
+        *len = burstFrames[n].len;
+        burstReaders++;
+    }
+    portEXIT_CRITICAL(&burstMux);
+    return buf;
+}
+
+void releaseBurst() {
+    portENTER_CRITICAL(&burstMux);
+    if (burstReaders > 0) burstReaders--;
+    portEXIT_CRITICAL(&burstMux);
+}
+
+// Returns true when the pending request was handled (captured or given up)
+static bool captureBurst() {
+    uint32_t triggerMs = burstRequestMs;
+
+    if (millis() - triggerMs > BURST_PENDING_MS) {
+        portENTER_CRITICAL(&burstMux);
+        burstInfo.missed++;
+        portEXIT_CRITICAL(&burstMux);
+        return true;
+    }
+
+    // Camera asleep (a rapid approach normally wakes it) or changing state
+    if (streamLowPower || xSemaphoreTake(powerLock, 0) != pdTRUE) return false;
+    if (streamLowPower) { xSemaphoreGive(powerLock); return false; }
+
+    portENTER_CRITICAL(&burstMux);
+    bool idle = burstReaders == 0;
+    if (idle) burstWriting = true;
+    portEXIT_CRITICAL(&burstMux);
+    if (!idle) { xSemaphoreGive(powerLock); return false; }
+
+    for (int i = 0; i < BURST_FRAMES; i++) {
+        free(burstFrames[i].buf);
+        burstFrames[i] = { nullptr, 0 };
+    }
+
+    sensor_t *s = esp_camera_sensor_get();
+    framesize_t streamSize = s->status.framesize;
+    uint16_t width = resolution[FRAMESIZE_UXGA].width;
+
+    s->set_framesize(s, FRAMESIZE_UXGA);
+
+    int got = 0;
+    uint32_t firstStillMs = 0;
+    for (int tries = 0; got < BURST_FRAMES && tries < BURST_FRAMES + BURST_MAX_STALE; tries++) {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (!fb) break;
+
+        if (fb->width == width) {
+            uint8_t *copy = (uint8_t*)ps_malloc(fb->len);
+            if (copy) {
+                memcpy(copy, fb->buf, fb->len);
+                burstFrames[got] = { copy, fb->len };
+                if (!got) firstStillMs = millis() - triggerMs;
+                got++;
+            }
+        }
+        esp_camera_fb_return(fb);
+    }
+
+    s->set_framesize(s, streamSize);
+    xSemaphoreGive(powerLock);
+
+    streamWidth = resolution[streamSize].width;
+    if (streamClients > 0 && lastStreamFrameMs) burstGapFrom = lastStreamFrameMs;
+
+    portENTER_CRITICAL(&burstMux);
+    if (got) {
+        burstInfo.id++;
+        burstInfo.completed++;
+        burstInfo.triggerMs = triggerMs;
+        burstInfo.frames = got;
+        burstInfo.width = width;
+        burstInfo.height = resolution[FRAMESIZE_UXGA].height;
+        burstInfo.firstStillMs = firstStillMs;
+        burstInfo.durationMs = millis() - triggerMs;
+        burstInfo.streamGapMs = 0;
+        for (int i = 0; i < BURST_FRAMES; i++) burstInfo.sizes[i] = burstFrames[i].len;
+    } else {
+        burstInfo.frames = 0;
+        burstInfo.missed++;
+    }
+    burstWriting = false;
+    portEXIT_CRITICAL(&burstMux);
+    return true;
+}
+
+// ===== Rate control =====
+// The controller picks a JPEG quality / frame size from the measured send
+// times; the sensor is only touched here, under powerLock, so a standby or a
+// burst in progress just delays the change to the next pass.
+static RateController rate;
+static bool rateApplyPending = false;
+
+static void applyRateLevel() {
+    if (streamLowPower || xSemaphoreTake(powerLock, 0) != pdTRUE) return;
+
+    sensor_t *s = esp_camera_sensor_get();
+    RateLevel lv = rate.current();
+    if (s->status.quality != lv.quality) s->set_quality(s, lv.quality);
+    if (s->status.framesize != (framesize_t)lv.framesize) s->set_framesize(s, (framesize_t)lv.framesize);
+    xSemaphoreGive(powerLock);
+
+    streamWidth = resolution[lv.framesize].width;
+    rateApplyPending = false;
+}
+
+// ===== Camera commands =====
+// /cam flip / mirror from the HTTP task. Toggles are counted and only the
+// parity is written to the sensor, under powerLock and while awake (XCLK
+// stopped in standby), so they wait for the next pass like a rate change.
+static CommandMailbox cameraCommands(CMD_BOX_CAMERA);
+static bool flipPending = false;
+static bool mirrorPending = false;
+static uint32_t cameraTicket = 0; // last ticket taken, acknowledged once applied
+
+uint32_t postCameraCommand(uint8_t type) {
+    return cameraCommands.post(type);
+}
+
+bool cameraCommandApplied(uint32_t ticket) {
+    return cameraCommands.applied(ticket);
+}
+
+MailboxStats getCameraCommandStats() {
+    return cameraCommands.stats();
+}
+
+static void applyCameraCommands() {
+    Command cmd;
+    while (cameraCommands.take(cmd)) {
+        if (cmd.type == CMD_CAM_FLIP) flipPending = !flipPending;
+        else if (cmd.type == CMD_CAM_MIRROR) mirrorPending = !mirrorPending;
+        cameraTicket = cmd.ticket;
+    }
+    if (!cameraTicket || cameraCommands.applied(cameraTicket)) return;
+    if (streamLowPower || xSemaphoreTake(powerLock, 0) != pdTRUE) return;
+
+    sensor_t *s = esp_camera_sensor_get();
+    if (flipPending) s->set_vflip(s, !s->status.vflip);
+    if (mirrorPending) s->set_hmirror(s, !s->status.hmirror);
+    xSemaphoreGive(powerLock);
+
+    flipPending = mirrorPending = false;
+    cameraCommands.done(cameraTicket);
+}
+
+// ===== Motion pre-filter =====
+// While loop() has radar targets, the stream task decodes a small luma image
+// every MOTION_INTERVAL_MS (also with nobody watching) and hands the block
+// motion profile of the last pair to loop(), see MotionFilter.h.
+
+static MotionDetector motion; // two luma images, stream task only
+static portMUX_TYPE motionMux = portMUX_INITIALIZER_UNLOCKED;
+static MotionProfile motionProfile = {};
+static bool motionValid = false;
+static MotionKernelStats motionStats = {};
+static volatile bool motionWanted = false;
+static unsigned long lastMotionMs = 0;
+
+void setMotionWanted(bool wanted) {
+    motionWanted = wanted;
+}
+
+bool getMotionProfile(MotionProfile &out) {
+    portENTER_CRITICAL(&motionMux);
+    bool valid = motionValid;
+    if (valid) out = motionProfile;
+    portEXIT_CRITICAL(&motionMux);
+    return valid;
+}
+
+MotionKernelStats getMotionKernelStats() {
+    portENTER_CRITICAL(&motionMux);
+    MotionKernelStats st = motionStats;
+    portEXIT_CRITICAL(&motionMux);
+    return st;
+}
+
+struct LumaDecode {
+    const uint8_t *jpeg;
+    size_t len;
+    LumaFrame *out;
+};
+
+static size_t lumaRead(void *arg, size_t index, uint8_t *buf, size_t len) {
+    LumaDecode *d = (LumaDecode*)arg;
+    if (index + len > d->len) len = d->len - index;
+    if (buf) memcpy(buf, d->jpeg + index, len);
+    return len;
+}
+
+// Decoded RGB888 blocks -> 8 bit luma. R and B weigh the same, so the
+// channel order of the decoder does not matter.
+static bool lumaWrite(void *arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data) {
+    if (!data) return true; // start / end of image
+    LumaFrame *f = ((LumaDecode*)arg)->out;
+
+    for (int j = 0; j < h && y + j < f->h; j++) {
+        const uint8_t *src = data + j * w * 3;
+        uint8_t *dst = f->px + (y + j) * f->w + x;
+        for (int i = 0; i < w && x + i < f->w; i++) {
+            dst[i] = (src[0] + 2 * src[1] + src[2]) >> 2;
+            src += 3;
+        }
+    }
+    return true;
+}
+
+static void runMotion(camera_fb_t *fb) {
+    // Smallest decoder scale (1/1 .. 1/8) that fits the luma image
+    int shift = 0;
+    while (shift < 3 && (fb->width >> shift) > MOTION_MAX_W) shift++;
+    if ((fb->width >> shift) > MOTION_MAX_W || (fb->height >> shift) > MOTION_MAX_H) return;
+
+    LumaFrame &f = motion.next();
+    f.w = (fb->width >> shift) & ~(MOTION_BLOCK - 1);
+    f.h = (fb->height >> shift) & ~(MOTION_BLOCK - 1);
+    f.timestampMs = fb->timestamp.tv_sec * 1000 + fb->timestamp.tv_usec / 1000;
+
+    LumaDecode d = { fb->buf, fb->len, &f };
+    int64_t t0 = esp_timer_get_time();
+    if (esp_jpg_decode(fb->len, (jpg_scale_t)shift, lumaRead, lumaWrite, &d) != ESP_OK) return;
+    int64_t t1 = esp_timer_get_time();
+
+    MotionProfile p;
+    bool paired = motion.commit(p);
+    int64_t t2 = esp_timer_get_time();
+
+    // Only this task writes motionStats, the copy is published with the profile
+    MotionKernelStats st = motionStats;
+    st.images++;
+    st.decodeUs = t1 - t0;
+    st.width = f.w;
+    st.height = f.h;
+
+    if (paired) {
+        st.pairs++;
+        st.kernelUs = t2 - t1;
+
+        // Scalar reference on the same pair: correctness check and benchmark
+        if (st.pairs % MOTION_VERIFY_EVERY == 1) {
+            static uint16_t ref[MOTION_MAX_BLOCKS];
+            const LumaFrame &a = motion.previous(), &b = motion.current();
+            int64_t t3 = esp_timer_get_time();
+            motionSadScalar(a.px, b.px, b.w, b.h, ref);
+            st.scalarUs = esp_timer_get_time() - t3;
+            st.verified++;
+            int blocks = (b.w / MOTION_BLOCK) * (b.h / MOTION_BLOCK);
+            if (memcmp(ref, motion.sad(), blocks * sizeof(uint16_t)) != 0) st.mismatches++;
+        }
+    }
+
+    portENTER_CRITICAL(&motionMux);
+    motionStats = st;
+    if (paired) {
+        motionProfile = p;
+        motionValid = true;
+    }
+    portEXIT_CRITICAL(&motionMux);
+}
+
 // ===== 1x1 black JPEG =====
 static const uint8_t black_jpeg[] = {
   0xFF,0xD8,0xFF,0xDB,0x00,0x43,0x00,
@@ -36,92 +438,247 @@ static const uint8_t black_jpeg[] = {
   0xFF,0xD9
 };
 
-static esp_err_t stream_handler(httpd_req_t *req)
-{
-    esp_err_t res = ESP_OK;
+// ===== Raw socket MJPEG server =====
+// One task owns the camera and every stream socket, see StreamFanout.h for
+// how frames reach the clients. The request line of a new connection is
+// read without blocking too, over as many passes as it takes.
+
+#define STREAM_PORT        81
+#define STREAM_REQUEST_MS  2000 // a connection has this long to send its request line
+
+static const char* _STREAM_REQUEST = "GET /stream";
+
+static const char* _STREAM_RESPONSE =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: multipart/x-mixed-replace;boundary=" PART_BOUNDARY "\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+
+static const char* _NOT_FOUND_RESPONSE =
+    "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+struct PendingRequest {
+    int      fd;
+    uint32_t since;
+    size_t   len;
+    char     buf[32];
+};
+
+static StreamFanout fanout;
+static PendingRequest pending[STREAM_MAX_CLIENTS];
+static int listenFd = -1;
+static StreamStats streamStats = {};
+
+StreamStats getStreamStats() {
+    portENTER_CRITICAL(&statsMux);
+    StreamStats st = streamStats;
+    portEXIT_CRITICAL(&statsMux);
+    return st;
+}
 
-    res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
-    if (res != ESP_OK) return res;
+// Rate controller state as of the last pass (the controller is stream task only)
+static void publishRateStats() {
+    RateLevel lv = rate.current();
+    portENTER_CRITICAL(&statsMux);
+    streamStats.kbps = rate.kbps();
+    streamStats.rateLevel = rate.level();
+    streamStats.rateChanges = rate.changes();
+    streamStats.quality = lv.quality;
+    streamStats.width = resolution[lv.framesize].width;
+    streamStats.height = resolution[lv.framesize].height;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+static void recordSend(const StreamSendResult &r, bool captured) {
+    portENTER_CRITICAL(&statsMux);
+    if (captured) streamStats.framesCaptured++;
+    streamStats.framesSent += r.sent;
+    streamStats.framesSkipped += r.skipped;
+    streamStats.clientsDropped += r.dropped;
+    if (r.copied) streamStats.frameCopies++;
+    streamStats.clientsBehind = fanout.behind();
+    streamStats.lastSendUs = r.us;
+    streamStats.avgSendUs = streamStats.avgSendUs ? (streamStats.avgSendUs * 15 + r.us) / 16 : r.us;
+    portEXIT_CRITICAL(&statsMux);
+    streamClients = fanout.count();
+}
+
+static void pumpClients() {
+    uint8_t sent = fanout.pump();
+    portENTER_CRITICAL(&statsMux);
+    streamStats.framesSent += sent;
+    streamStats.clientsBehind = fanout.behind();
+    portEXIT_CRITICAL(&statsMux);
+    streamClients = fanout.count();
+}
+
+static void acceptClients() {
+    for (;;) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) break;
+
+        int slot = -1;
+        for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+            if (pending[i].fd < 0) { slot = i; break; }
+        }
+        if (slot < 0) { close(fd); continue; }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        pending[slot] = { fd, (uint32_t)millis(), 0 };
+    }
 
-    res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
-    if (res != ESP_OK) return res;
+    // Only the start of the request line matters, the rest is never read
+    const size_t need = strlen(_STREAM_REQUEST);
+    uint32_t now = millis();
+    for (PendingRequest &p : pending) {
+        if (p.fd < 0) continue;
 
+        int n = recv(p.fd, p.buf + p.len, need - p.len, 0);
+        if (n > 0) p.len += n;
+        bool gone = n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+        if (!gone && p.len < need && now - p.since < STREAM_REQUEST_MS) continue;
+
+        int fd = p.fd;
+        p.fd = -1;
+        if (gone || p.len < need || strncmp(p.buf, _STREAM_REQUEST, need) != 0 || fanout.full()) {
+            if (!gone) send(fd, _NOT_FOUND_RESPONSE, strlen(_NOT_FOUND_RESPONSE), 0);
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        // Headers + first boundary fit in an empty send buffer
+        send(fd, _STREAM_RESPONSE, strlen(_STREAM_RESPONSE), 0);
+        send(fd, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY), 0);
+
+        fanout.add(fd);
+        streamClients = fanout.count();
+    }
+}
+
+// Nobody watching: sleep until a connection or request bytes arrive
+static void waitForRequests() {
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    FD_SET(listenFd, &rfds);
+    int maxFd = listenFd;
+    for (const PendingRequest &p : pending) {
+        if (p.fd < 0) continue;
+        FD_SET(p.fd, &rfds);
+        if (p.fd > maxFd) maxFd = p.fd;
+    }
+    struct timeval tv = {0, 200000};
+    select(maxFd + 1, &rfds, NULL, NULL, &tv);
+}
+
+static void streamTask(void *arg) {
     unsigned long lastLowPowerFrame = 0;
+    unsigned long fpsWindow = millis();
+    uint32_t fpsFrames = 0;
+
+    for (;;) {
+        acceptClients();
+        applyCameraCommands();
+
+        if (burstPending && captureBurst()) {
+            portENTER_CRITICAL(&burstMux);
+            burstPending = false;
+            portEXIT_CRITICAL(&burstMux);
+        }
 
-    while (true)
-    {
-        if (!streamLowPower)
-        {
+        if (streamClients <= 0 && (!motionWanted || streamLowPower)) {
+            // Nobody watching: wait for a connection instead of capturing
+            waitForRequests();
+            continue;
+        }
+        pumpClients();
+
+        if (!streamLowPower) {
             // ===== NORMAL MODE =====
-            camera_fb_t *fb = esp_camera_fb_get();
+            camera_fb_t *fb = captureGoodFrame();
 
-            if (!fb)
-            {
-                res = ESP_FAIL;
+            // Skip full resolution frames still queued from a burst
+            if (fb && burstGapFrom && fb->width != streamWidth) {
+                esp_camera_fb_return(fb);
+                fb = nullptr;
             }
-            else
-            {
-                char part_buf[64];
-                size_t hlen = snprintf(part_buf, sizeof(part_buf),_STREAM_PART, fb->len);
 
-                res = httpd_resp_send_chunk(req, part_buf, hlen);
-                if (res == ESP_OK)
-                    res = httpd_resp_send_chunk(req,(const char*)fb->buf,fb->len);
-                if (res == ESP_OK)
-                    res = httpd_resp_send_chunk(req,_STREAM_BOUNDARY,strlen(_STREAM_BOUNDARY));
+            if (fb) {
+                lastStreamFrameMs = millis();
+                if (burstGapFrom) {
+                    portENTER_CRITICAL(&burstMux);
+                    burstInfo.streamGapMs = lastStreamFrameMs - burstGapFrom;
+                    portEXIT_CRITICAL(&burstMux);
+                    burstGapFrom = 0;
+                }
+
+                if (motionWanted && lastStreamFrameMs - lastMotionMs >= MOTION_INTERVAL_MS) {
+                    lastMotionMs = lastStreamFrameMs;
+                    runMotion(fb);
+                }
 
+                if (streamClients > 0) {
+                    fpsFrames++;
+                    StreamSendResult r = fanout.send(fb->buf, fb->len, fb->timestamp.tv_sec * 1000 + fb->timestamp.tv_usec / 1000);
+                    recordSend(r, true);
+                    rate.onFrame(fb->len, r.us, r.sent, r.skipped);
+                }
                 esp_camera_fb_return(fb);
             }
-
-            vTaskDelay(1);
+            // Motion only: no need to grab frames faster than they are differenced
+            vTaskDelay(streamClients > 0 ? 1 : pdMS_TO_TICKS(MOTION_INTERVAL_MS));
         }
-        else
-        {
+        else {
             // ===== LOW POWER MODE =====
             unsigned long now = millis();
-
-            if (now - lastLowPowerFrame >= 2000)
-            {
-                char part_buf[64];
-                size_t hlen = snprintf(part_buf, sizeof(part_buf),_STREAM_PART,sizeof(black_jpeg));
-
-                res = httpd_resp_send_chunk(req, part_buf, hlen);
-                if (res == ESP_OK)
-                    res = httpd_resp_send_chunk(req,(const char*)black_jpeg,sizeof(black_jpeg));
-                if (res == ESP_OK)
-                    res = httpd_resp_send_chunk(req,_STREAM_BOUNDARY,strlen(_STREAM_BOUNDARY));
-
+            if (now - lastLowPowerFrame >= 2000) {
+                recordSend(fanout.send(black_jpeg, sizeof(black_jpeg), now), false);
                 lastLowPowerFrame = now;
             }
+            vTaskDelay(pdMS_TO_TICKS(50));
+        }
 
-            vTaskDelay(50); 
+        unsigned long now = millis();
+        if (now - fpsWindow >= 1000) {
+            portENTER_CRITICAL(&statsMux);
+            streamStats.fpsX10 = fpsFrames * 10000 / (now - fpsWindow);
+            portEXIT_CRITICAL(&statsMux);
+            fpsFrames = 0;
+            fpsWindow = now;
         }
 
-        if (res != ESP_OK)
-            break;
+        if (rate.update(now, streamClients)) rateApplyPending = true;
+        if (rateApplyPending) applyRateLevel();
+        publishRateStats();
     }
-
-    return res;
 }
 
 void startCameraServer()
 {
-    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.server_port = 81;
-    config.ctrl_port = 32769;
-    config.stack_size = 8192;
+    if (!powerLock) powerLock = xSemaphoreCreateMutex();
+    for (int i = 0; i < STREAM_MAX_CLIENTS; i++) pending[i].fd = -1;
+
+    listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenFd < 0) return;
 
-    httpd_uri_t stream_uri = {
-        .uri       = "/stream",
-        .method    = HTTP_GET,
-        .handler   = stream_handler,
-        .user_ctx  = NULL
-    };
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
 
-    httpd_handle_t stream_httpd = NULL;
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(STREAM_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
 
-    if (httpd_start(&stream_httpd, &config) == ESP_OK)
-    {
-        httpd_register_uri_handler(stream_httpd, &stream_uri);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 2) < 0) {
+        close(listenFd);
+        listenFd = -1;
+        return;
     }
-}
\ No newline at end of file
+    fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
+
+    xTaskCreatePinnedToCore(streamTask, "stream", 8192, NULL, 5, NULL, 0);
+}
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <ESPmDNS.h>
+#include "esp_wifi.h"
 #include "Camera.h"
 #include "StreamServer.h"
 #include "DisplayModule.h"
@@ -9,7 +10,16 @@
 #include "FilterModule.h"
 #include "RadarParser.h"
 #include "RadarConfig.h"
+#include "RadarSensor.h"
+#include "RadarSnapshot.h"
+#include "PowerPolicy.h"
 #include "ConfigManager.h"
+#include "ExclusionZones.h"
+#include "ClutterMap.h"
+#include "VisionFeedback.h"
+#include "MotionFilter.h"
+#include "EventLog.h"
+#include "CommandMailbox.h"
 
 // --- Radar Default Settings ---
 uint8_t cfg_max_dist    = 40;//  1-100 (10 as min is recommended) meters
@@ -19,101 +29,313 @@ uint8_t cfg_delay_time  = 0;  // 0 or 1 since safebaige has persistence timeout
 uint8_t cfg_trigger_acc = 1;  // 3/4 Required consecutive detections before reporting
 uint8_t cfg_snr_limit   = 0;   //0 - 255 4 is the default / use 6–10: If radar is giving "ghost" detections
 uint8_t cfg_rapid_threshold = 15; // speed that cars need to be approaching at to be considered BAD and rendered red
+uint8_t cfg_display_fps = 30; // display render rate, cars are extrapolated between radar frames
+uint8_t cfg_clutter = CLUTTER_SUPPRESS; // learned clutter map: 0 off, 1 learn/count only, 2 suppress
+uint32_t cfg_radar_baud[RADAR_SENSOR_COUNT] = {}; // negotiated UART rate per radar, 0 = negotiate at boot
 
 uint32_t cameraTimerMs = 15000;  // ammount of seconds to keep camera alive 
 // --- Hardware & System Configuration ---
 
 const int RADAR_TX_PIN = 1;
 const int RADAR_RX_PIN = 2;
+#if RADAR_SENSOR_COUNT > 1
+const int RADAR2_TX_PIN = 47; // second (side) radar on UART2
+const int RADAR2_RX_PIN = 48;
+#endif
 const int DATA_PERSIST_MS = 800;// Time to hold target on screen after motion stops
 // --- Global Variables (Accessed by NetworkManager/Webhooks) ---
 
-uint8_t rawDebugBuffer[64];
-int rawDebugLen = 0;
-bool debugMode = true;
-
 int globalTargetCount = 0;
 bool yoloVetoActive = false;
 
 unsigned long carFirstDetectedTime = 0;
-bool radarUpdatePending = false;
 
-RadarTarget activeTargets[5];
+RadarTarget activeTargets[RADAR_MERGED_MAX]; // merged targets of all sensors (loop() only)
 unsigned long lastValidRadarTime = 0;
-struct RadarSnapshot {
+
+// What the network and display read. Published by loop() only.
+SeqLock<RadarSnapshot> radarSnapshot;
+SeqLock<LoopStats> loopStats;
+
+struct SentSnapshot {
     int count;
-    int distance[5];
-    int speed[5];
-    bool approaching[5];
+    int distance[RADAR_MERGED_MAX];
+    int speed[RADAR_MERGED_MAX];
+    bool approaching[RADAR_MERGED_MAX];
+    uint8_t vision[RADAR_MERGED_MAX];
+    uint8_t motion[RADAR_MERGED_MAX];
+    uint8_t sensor[RADAR_MERGED_MAX];
 };
 // --- Module Instances ---
 
 NetworkManager network;
 DisplayModule ui;
 Camera myCam;
-SignalFilter distFilter;
 ConfigManager configManager;
+ExclusionMap exclusions; // user exclusion zones, applied by every radar ingest
+VisionFeedback vision;
+MotionFilter motionFilter;
+EventLog eventLog;
+CommandMailbox loopCommands(CMD_BOX_LOOP); // /config and /cam power requests, drained by loop()
+PowerPolicy power;
+
+RadarSensor radars[RADAR_SENSOR_COUNT] = {
+    RadarSensor(0, Serial1, RADAR_TX_PIN, RADAR_RX_PIN),
+#if RADAR_SENSOR_COUNT > 1
+    RadarSensor(1, Serial2, RADAR2_TX_PIN, RADAR2_RX_PIN),
+#endif
+};
 
 void applyRadarSettings() {
-    // 1. Send configuration block (Enable -> Set Params -> End)
-
-    RadarConfig::sendDefaults(
-        Serial1,
-        cfg_max_dist,
-        cfg_direction,
-        cfg_min_speed,
-        cfg_delay_time,
-        cfg_trigger_acc,
-        cfg_snr_limit
-    );
-    delay(100);
-    // 2. Explicit "Start Reporting" command to ensure data flow
-
-    uint8_t startCmd[] = {
-        0xFD,0xFC,0xFB,0xFA,
-        0x04,0x00,
-        0x62,0x00,
-        0x04,0x03,0x02,0x01
-    };
+    // The web UI edits one config, every sensor gets its own copy of it
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+        radars[i].settings = {
+            cfg_max_dist,
+            cfg_direction,
+            cfg_min_speed,
+            cfg_delay_time,
+            cfg_trigger_acc,
+            cfg_snr_limit,
+            cfg_clutter
+        };
+        radars[i].applySettings();
+    }
+}
 
-    Serial1.write(startCmd, sizeof(startCmd));
-    Serial1.flush();
+// Moves each radar link to the fastest verified rate. At boot the stored rate
+// is only verified. With fresh (POST /config radar_baud=0) every link starts
+// again from 115200 with its ingest paused; the radars reboot at each rate,
+// so loop() stalls for a few seconds without targets.
+void negotiateRadarBaud(bool fresh) {
+    bool changed = false;
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+        if (!radars[i].pause()) continue; // busy ingest task: keep the current rate
+        uint32_t baud = radars[i].negotiateBaud(fresh ? 0 : cfg_radar_baud[i]);
+        radars[i].resume();
+        if (baud != cfg_radar_baud[i]) {
+            cfg_radar_baud[i] = baud;
+            changed = true;
+        }
+    }
+    if (changed) configManager.save();
 }
 
-void updateCameraPower() {
+void publishLoopStats() {
+    static LoopStats st;
+    st.powerState = power.state();
+    st.cpuMhz = power.profile().cpuMhz;
+    for (int s = 0; s < POWER_STATE_COUNT; s++) st.powerTimeIn[s] = power.timeIn((PowerState)s);
+    st.powerTransitions = power.transitions();
+    st.motion = motionFilter.stats();
+    st.display = ui.stats();
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++) st.link[i] = radars[i].health().window();
+    loopStats.publish(st);
+}
 
-    static bool cameraSleeping = false;
-    unsigned long now = millis();
+void publishRadarSnapshot() {
+    static RadarSnapshot snap;
+    snap.timestamp = lastValidRadarTime;
+    snap.count = globalTargetCount;
+    snap.veto = yoloVetoActive;
+    memcpy(snap.targets, activeTargets, globalTargetCount * sizeof(RadarTarget));
+    radarSnapshot.publish(snap);
+    vision.record(snap.timestamp, snap.targets, snap.count); // ids of the vision client's answer refer to this list
+}
 
-    if (now - lastValidRadarTime > cameraTimerMs) {
+// Rising edges of the rapid-approach and vision-veto alerts go to the WS events topic
+bool rapidAlertActive = false;
+bool vetoAlertActive = false;
 
-        if (!cameraSleeping) {
-            enterLowPowerMode();
-            cameraSleeping = true;
+// Fastest approaching target over the rapid threshold (not vetoed), -1 if none
+int findRapidTarget(int count) {
+    int rapid = -1;
+    for (int i = 0; i < count; i++) {
+        const RadarTarget &t = activeTargets[i];
+        if (t.approaching && t.speed > cfg_rapid_threshold && t.vision != VISION_VETO) {
+            if (rapid < 0 || t.speed > activeTargets[rapid].speed) rapid = i;
         }
     }
-    else {
+    return rapid;
+}
+
+void publishAlertEvents(int count) {
+    int rapid = findRapidTarget(count);
+
+    if (rapid >= 0 && !rapidAlertActive) {
+        network.sendEvent("rapid", rapid, activeTargets[rapid], lastValidRadarTime);
+        requestBurst(lastValidRadarTime); // full resolution stills of the approaching car
+    }
+    rapidAlertActive = rapid >= 0;
+
+    if (yoloVetoActive && !vetoAlertActive) {
+        for (int i = 0; i < count; i++) {
+            if (activeTargets[i].vision == VISION_VETO) {
+                network.sendEvent("veto", i, activeTargets[i], lastValidRadarTime);
+                break;
+            }
+        }
+    }
+    vetoAlertActive = yoloVetoActive;
+}
+
+// Finished alerts go to the flash event log (queued, written by its own task)
+const uint8_t CLOSE_PASS_M = 3; // approaching car this close counts as a close pass
+
+AlertEpisode rapidEpisode(EVENT_RAPID);
+AlertEpisode closeEpisode(EVENT_CLOSE_PASS);
+
+void logEvent(EventRecord &rec) {
+    rec.unixMs = 0;
+    network.clock().wallClockMs(rec.startMs, rec.unixMs);
+    eventLog.append(rec);
+}
+
+void logAlertEpisodes(int count) {
+    unsigned long now = millis();
+    int rapid = findRapidTarget(count);
+    int close = -1;
+    for (int i = 0; i < count; i++) {
+        const RadarTarget &t = activeTargets[i];
+        if (t.approaching && t.distance <= CLOSE_PASS_M && (close < 0 || t.distance < activeTargets[close].distance))
+            close = i;
+    }
+
+    EventRecord rec;
+    if (rapidEpisode.update(rapid >= 0 ? &activeTargets[rapid] : nullptr, now, rec)) logEvent(rec);
+    if (closeEpisode.update(close >= 0 ? &activeTargets[close] : nullptr, now, rec)) logEvent(rec);
+}
+
+// Pre-wake: a sleeping camera is woken by an approaching target predicted to
+// reach CAMERA_CLOSE_RANGE_M within CAMERA_PREWAKE_MS, which at radar range
+// means on first detection of a real car, so exposure has settled before it is close.
+// Receding targets and far, slow ones do not wake it.
+const float CAMERA_CLOSE_RANGE_M = 10.0f;
+const unsigned long CAMERA_PREWAKE_MS = 8000;
+
+unsigned long lastCameraDemand = 0; // last time something needed the camera
+
+bool cameraPreWake(const RadarTarget *targets, int count) {
+    for (int i = 0; i < count; i++) {
+        const RadarTarget &t = targets[i];
+        if (!t.approaching) continue;
+        if (t.distance <= CAMERA_CLOSE_RANGE_M) return true;
+        if (t.speed == 0) continue;
+
+        float metersPerMs = t.speed / 3600.0f;
+        float etaMs = (t.distance - CAMERA_CLOSE_RANGE_M) / metersPerMs;
+        if (etaMs <= CAMERA_PREWAKE_MS) return true;
+    }
+    return false;
+}
+
+void updateCameraPower() {
+    unsigned long now = millis();
+
+    if (now - lastCameraDemand > cameraTimerMs) {
+        if (!isLowPower())
+            enterLowPowerMode();   // sensor standby, XCLK stopped
+    }
+    else if (isLowPower()) {
+        exitLowPowerMode();
+    }
+}
+
+void applyPowerProfile(const PowerProfile &p) {
+    setCpuFrequencyMhz(p.cpuMhz);
+
+    // Modem sleep only acts on the station interface; as a SoftAP the
+    // radio is turned down through TX power instead (clients are on the bike)
+    esp_wifi_set_ps(
+        p.wifiSave == WIFI_SAVE_NONE ? WIFI_PS_NONE
+        : (p.wifiSave == WIFI_SAVE_MIN ? WIFI_PS_MIN_MODEM : WIFI_PS_MAX_MODEM)
+    );
+    WiFi.setTxPower(p.wifiSave == WIFI_SAVE_MAX ? WIFI_POWER_8_5dBm : WIFI_POWER_19_5dBm);
+}
+
+void updatePowerPolicy() {
+    PowerInputs in = {
+        (uint32_t)millis(),
+        (uint32_t)lastValidRadarTime,
+        globalTargetCount,
+        network.wsClientCount(),
+        streamClientCount(),
+        cameraTimerMs
+    };
+
+    if (power.update(in))
+        applyPowerProfile(power.profile());
+}
 
-        if (cameraSleeping) {
-            exitLowPowerMode();
-            cameraSleeping = false;
+// Everything the HTTP handlers queued since the last pass, merged and applied
+// once. The handlers already clamped every value.
+void applyCommands() {
+    Command cmd;
+    ConfigPatch patch = {};
+    bool configure = false, wake = false, reboot = false;
+    uint32_t last = 0;
+
+    while (loopCommands.take(cmd)) {
+        if (cmd.type == CMD_CONFIG) {
+            patch.merge(cmd.config);
+            configure = true;
         }
+        else if (cmd.type == CMD_WAKE) wake = true;
+        else if (cmd.type == CMD_REBOOT) reboot = true;
+        last = cmd.ticket;
+    }
+    if (!last) return;
+
+    if (configure) {
+        if (patch.zonesSet) exclusions.set(patch.zones, patch.zoneCount);
+        if (patch.has(CFG_MAX_DIST)) cfg_max_dist = patch.value[CFG_MAX_DIST];
+        if (patch.has(CFG_DIRECTION)) cfg_direction = patch.value[CFG_DIRECTION];
+        if (patch.has(CFG_MIN_SPEED)) cfg_min_speed = patch.value[CFG_MIN_SPEED];
+        if (patch.has(CFG_DELAY_TIME)) cfg_delay_time = patch.value[CFG_DELAY_TIME];
+        if (patch.has(CFG_TRIGGER_ACC)) cfg_trigger_acc = patch.value[CFG_TRIGGER_ACC];
+        if (patch.has(CFG_SNR_LIMIT)) cfg_snr_limit = patch.value[CFG_SNR_LIMIT];
+        if (patch.has(CFG_RAPID_THRESHOLD)) cfg_rapid_threshold = patch.value[CFG_RAPID_THRESHOLD];
+        if (patch.has(CFG_CAMERA_TIMER)) cameraTimerMs = patch.value[CFG_CAMERA_TIMER];
+        if (patch.has(CFG_DISPLAY_FPS)) cfg_display_fps = patch.value[CFG_DISPLAY_FPS];
+        if (patch.has(CFG_CLUTTER)) cfg_clutter = patch.value[CFG_CLUTTER];
+        if (patch.has(CFG_RADAR_BAUD)) negotiateRadarBaud(true); // before the settings: the radars reboot
+
+        applyRadarSettings();
+        ui.redrawBackground();
+        configManager.save(); // save config to preference works with both radar and global variables since this is called with every change (im pepege)
+    }
+    if (wake) {
+        lastCameraDemand = millis();
+        exitLowPowerMode();
+    }
+    loopCommands.done(last);
+
+    if (reboot) {
+        delay(100); // let the HTTP response that posted it go out
+        ESP.restart();
     }
 }
 
 void setup() {
-    Serial1.begin(115200, SERIAL_8N1, RADAR_TX_PIN, RADAR_RX_PIN);
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+        radars[i].begin();
+        radars[i].exclusions = &exclusions;
+    }
     delay(500);
     
     // overrides config global variables by saved ones (if they exist)
     configManager.load();
 
+    // Move each radar link to the fastest verified rate (only the first boot steps up)
+    negotiateRadarBaud(false);
+
     ui.init();
     ui.updateMessage("BOOTING", ST77XX_CYAN);
 
     applyRadarSettings();
 
     myCam.init();
+    eventLog.begin();
+    publishLoopStats(); // before the first /stats request
     network.init();
     startCameraServer();
 
@@ -124,28 +346,32 @@ void setup() {
         ui.updateMessage("MDNS:ERR", ST77XX_RED);
     }
     lastValidRadarTime = millis();
+    lastCameraDemand = lastValidRadarTime;
+
+#if RADAR_INGEST_CORE >= 0
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++)
+        radars[i].startTask(RADAR_INGEST_CORE);
+#endif
 }
 
 void loop() {
-    static RadarSnapshot lastSnapshot = { -1 };
+    static SentSnapshot lastSnapshot = { -1 };
     static unsigned long lastForcedSend = 0;
     const unsigned long FORCE_INTERVAL_MS = 1000;
     bool shouldSend = false;
-    // 1. Parse Radar Frame
-    int newTargets = RadarParser::parse(
-        Serial1,
-        activeTargets,
-        5,
-        rawDebugBuffer,
-        &rawDebugLen
-    );
-    // 2. Apply Config if Needed
-    if (radarUpdatePending) {
-        radarUpdatePending = false;
-        applyRadarSettings();
-        ui.redrawBackground();
-        configManager.save(); // save config to preference works with both radar and global variables since this is called with every change (im pepege)
+    // 1. Parse Radar Frames (unless every sensor has its own ingest task)
+    bool freshFrame = false;
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+        if (!radars[i].hasTask())
+            radars[i].ingest();
+        if (radars[i].takeFresh())
+            freshFrame = true;
     }
+    int newTargets = freshFrame
+        ? mergeRadarTargets(radars, RADAR_SENSOR_COUNT, activeTargets, millis(), DATA_PERSIST_MS)
+        : 0;
+    // 2. Apply Config / power commands posted by the web handlers
+    applyCommands();
     // 3. Valid Targets Detected
     if (newTargets > 0) {
         if (carFirstDetectedTime == 0)
@@ -154,14 +380,26 @@ void loop() {
         globalTargetCount = newTargets;
         lastValidRadarTime = millis();
 
-        if (isLowPower())
-            exitLowPowerMode();
-
-        for (int i = 0; i < newTargets; i++) {
-            activeTargets[i].smoothedDist =
-                distFilter.smooth(i, (float)activeTargets[i].distance);
+        // While awake any target keeps the camera on, asleep only a predicted arrival wakes it
+        if (!isLowPower() || cameraPreWake(activeTargets, newTargets)) {
+            lastCameraDemand = millis();
+            updateCameraPower();
         }
-        ui.render(newTargets, activeTargets);
+
+        // Tag targets with the latest YOLO confirmation / veto before rendering
+        yoloVetoActive = vision.apply(activeTargets, newTargets, millis());
+
+        // On-device motion check: radar target with no visual change = likely ghost
+        MotionProfile profile;
+        bool profileValid = getMotionProfile(profile);
+        int ghost = motionFilter.apply(activeTargets, newTargets, profile, profileValid, millis());
+        if (ghost >= 0)
+            network.sendEvent("ghost", ghost, activeTargets[ghost], lastValidRadarTime);
+        publishRadarSnapshot();
+        publishAlertEvents(newTargets);
+        logAlertEpisodes(newTargets);
+
+        ui.update(newTargets, activeTargets, millis());
         if (globalTargetCount != lastSnapshot.count) {
             shouldSend = true;
         }
@@ -179,6 +417,18 @@ void loop() {
                     shouldSend = true;
                     break;
                 }
+                if (activeTargets[i].vision != lastSnapshot.vision[i]) {
+                    shouldSend = true;
+                    break;
+                }
+                if (activeTargets[i].motion != lastSnapshot.motion[i]) {
+                    shouldSend = true;
+                    break;
+                }
+                if (activeTargets[i].sensor != lastSnapshot.sensor[i]) {
+                    shouldSend = true;
+                    break;
+                }
             }
         }
         // Websocket heartbeat
@@ -196,24 +446,26 @@ void loop() {
                 lastSnapshot.distance[i] = activeTargets[i].distance;
                 lastSnapshot.speed[i] = activeTargets[i].speed;
                 lastSnapshot.approaching[i] = activeTargets[i].approaching;
+                lastSnapshot.vision[i] = activeTargets[i].vision;
+                lastSnapshot.motion[i] = activeTargets[i].motion;
+                lastSnapshot.sensor[i] = activeTargets[i].sensor;
             }
         }
     }
     else {
-        // 4. Debug Raw Capture
-        if (debugMode && Serial1.available() > 0) {
-            rawDebugLen = 0;
-            while (Serial1.available() > 0 && rawDebugLen < 64) {
-                rawDebugBuffer[rawDebugLen++] = Serial1.read();
-            }
-        }
-        // 5. Persistence Timeout
+        // 4. Persistence Timeout
         if (millis() - lastValidRadarTime > DATA_PERSIST_MS) {
             if (globalTargetCount > 0) {
                 globalTargetCount = 0;
-                for (int i = 0; i < 5; i++)
-                    distFilter.reset(i);
-                ui.render(0, nullptr);
+                yoloVetoActive = false;
+                rapidAlertActive = false;
+                vetoAlertActive = false;
+                motionFilter.reset();
+                logAlertEpisodes(0);
+                for (int i = 0; i < RADAR_SENSOR_COUNT; i++)
+                    radars[i].clear();
+                publishRadarSnapshot();
+                ui.update(0, nullptr, millis());
                 network.sendRadarUpdate();
                 lastForcedSend = millis();
                 lastSnapshot.count = 0;
@@ -224,8 +476,29 @@ void loop() {
         }
     }
 
+    ui.tick(millis());
     updateCameraPower();
+    setMotionWanted(globalTargetCount > 0 && !isLowPower());
+    updatePowerPolicy();
     //network.cleanupWS();
     network.handleHeartbeat();
-    delay(5);
+    network.handleUdp();
+    network.handleSync();
+
+    // UART link health windows, degraded/recovered edges go to the events topic
+    unsigned long now = millis();
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+        LinkEvent ev = radars[i].health().update(now, radars[i].linkStats().counters);
+        if (ev != LINK_EVENT_NONE) network.sendLinkEvent(radars[i].id(), ev, radars[i].health());
+    }
+    publishLoopStats();
+    network.handleStats();
+
+    // Raw UART tap, only filled while a client subscribed to the raw topic
+    bool rawWanted = network.hasSubscribers(WS_TOPIC_RAW);
+    for (int i = 0; i < RADAR_SENSOR_COUNT; i++) {
+        radars[i].tap.setEnabled(rawWanted);
+        if (rawWanted) network.sendRawTap(radars[i].id(), radars[i].tap);
+    }
+    delay(power.profile().loopDelayMs);
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Just enough of the Arduino / FreeRTOS API for the headers under test to
+// build natively (pio test -e native). Time is simulated: millis() and
+// micros() only move when a test calls delay() or hostAdvanceUs().
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <thread>
+
+inline std::atomic<uint64_t> hostNowUs{0};
+
+inline void hostAdvanceUs(uint64_t us) { hostNowUs += us; }
+inline unsigned long millis() { return (unsigned long)(hostNowUs.load() / 1000); }
+inline unsigned long micros() { return (unsigned long)hostNowUs.load(); }
+inline void delay(unsigned long ms) { hostAdvanceUs((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { hostAdvanceUs(us); }
+
+template <typename T, typename L, typename H>
+inline T constrain(T v, L lo, H hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+// portMUX: a spinlock, the tests do use threads
+struct portMUX_TYPE {
+    std::atomic<bool> locked;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+inline void hostEnterCritical(portMUX_TYPE *m) {
+    while (m->locked.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+}
+inline void hostExitCritical(portMUX_TYPE *m) {
+    m->locked.store(false, std::memory_order_release);
+}
+#define portENTER_CRITICAL(m) hostEnterCritical(m)
+#define portEXIT_CRITICAL(m)  hostExitCritical(m)
+
+// Tasks are never started on the host
+typedef void *TaskHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdPASS 1
+#define pdTRUE 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdMS_TO_TICKS(ms) (ms)
+inline void vTaskDelay(TickType_t ticks) { delay(ticks); }
+inline BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t, void *, int,
+                                          TaskHandle_t *handle, BaseType_t) {
+    if (handle) *handle = nullptr;
+    return pdPASS;
+}
+
+// Only taken by the tasks above, never started here
+typedef void *SemaphoreHandle_t;
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return nullptr; }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+
+#endif
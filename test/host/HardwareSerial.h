@@ -0,0 +1,44 @@
+#ifndef HOST_HARDWARE_SERIAL_H
+#define HOST_HARDWARE_SERIAL_H
+
+#include "Arduino.h"
+#include <functional>
+
+enum hardwareSerial_error_t {
+    UART_NO_ERROR,
+    UART_BREAK_ERROR,
+    UART_BUFFER_FULL_ERROR,
+    UART_FIFO_OVF_ERROR,
+    UART_FRAME_ERROR,
+    UART_PARITY_ERROR
+};
+
+#define SERIAL_8N1 0x800001c
+
+// A UART that never receives anything; tests subclass it (see ReplaySerial.h)
+class HardwareSerial {
+public:
+    std::function<void(hardwareSerial_error_t)> onError;
+    unsigned long baud = 0;
+
+    virtual ~HardwareSerial() {}
+
+    void begin(unsigned long rate, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) { updateBaudRate(rate); }
+    void end() {}
+    virtual void updateBaudRate(unsigned long rate) { baud = rate; }
+    size_t setRxBufferSize(size_t size) { return size; }
+    void onReceiveError(std::function<void(hardwareSerial_error_t)> cb) { onError = cb; }
+
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual size_t read(uint8_t *buf, size_t len) {
+        size_t n = 0;
+        for (int c; n < len && (c = read()) >= 0; ) buf[n++] = c;
+        return n;
+    }
+    virtual size_t write(const uint8_t *, size_t len) { return len; }
+    size_t write(uint8_t b) { return write(&b, 1); }
+    void flush() {}
+};
+
+#endif
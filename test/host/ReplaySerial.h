@@ -0,0 +1,65 @@
+#ifndef HOST_REPLAY_SERIAL_H
+#define HOST_REPLAY_SERIAL_H
+
+#include "HardwareSerial.h"
+#include <string>
+#include <vector>
+
+// Streams written by tools/ld2451_gen.py (see tools/test_streams.py)
+#ifndef TEST_DATA_DIR
+#define TEST_DATA_DIR ".pio/test_data"
+#endif
+
+inline bool loadTestStream(const char *name, std::vector<uint8_t> &out) {
+    std::string path = std::string(TEST_DATA_DIR) + "/" + name;
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+// Plays a recorded LD2451 byte stream into the radar pipeline one frame at a
+// time: the stream is cut before every data frame header, so corrupted bytes
+// arrive together with the frame they belong to.
+class ReplaySerial : public HardwareSerial {
+private:
+    std::vector<uint8_t> _data;
+    std::vector<size_t> _frameEnd; // end offset of every frame chunk
+    size_t _released = 0;          // bytes readable so far
+    size_t _pos = 0;
+    size_t _nextFrame = 0;
+
+public:
+    explicit ReplaySerial(const std::vector<uint8_t> &data) : _data(data) {
+        for (size_t i = 1; i + 4 <= _data.size(); i++) {
+            if (_data[i] == 0xF4 && _data[i + 1] == 0xF3 && _data[i + 2] == 0xF2 && _data[i + 3] == 0xF1)
+                _frameEnd.push_back(i);
+        }
+        _frameEnd.push_back(_data.size());
+    }
+
+    size_t frames() const { return _frameEnd.size(); }
+    bool done() const { return _nextFrame >= _frameEnd.size() && _pos >= _released; }
+
+    // Make the next frame readable; false once the stream is exhausted
+    bool feedFrame() {
+        if (_nextFrame >= _frameEnd.size()) return false;
+        _released = _frameEnd[_nextFrame++];
+        return true;
+    }
+
+    int available() override { return (int)(_released - _pos); }
+    int read() override { return _pos < _released ? _data[_pos++] : -1; }
+    size_t read(uint8_t *buf, size_t len) override {
+        size_t n = _released - _pos;
+        if (n > len) n = len;
+        memcpy(buf, _data.data() + _pos, n);
+        _pos += n;
+        return n;
+    }
+};
+
+#endif
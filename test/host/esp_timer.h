@@ -0,0 +1,18 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+// Wall clock, unlike millis(): code using it waits on real sockets. Tests
+// that need minutes to pass move it forward with hostTimerSkewUs.
+inline std::atomic<int64_t> hostTimerSkewUs{0};
+
+inline int64_t esp_timer_get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 + hostTimerSkewUs.load();
+}
+
+#endif
@@ -0,0 +1,139 @@
+// Runs ClockSync exchanges against simulated clients whose clock is offset
+// (browsers report unix ms) and drifts, with asymmetric queuing on the WiFi
+// path, and checks the per-client toClientUs() mapping against the truth.
+
+#include <unity.h>
+#include <random>
+#include "ClockSync.h"
+
+struct SimClient {
+    uint32_t id;
+    double   offsetUs;  // client - device at device time 0
+    double   driftPpm;
+    std::mt19937 rng;
+
+    double clientUs(int64_t deviceUs) const {
+        return deviceUs + offsetUs + driftPpm * 1e-6 * deviceUs;
+    }
+
+    // One request / reply. Queuing only ever adds delay, sometimes a lot.
+    bool exchange(ClockSync &sync, int64_t &t4) {
+        int64_t t1 = sync.request(id);
+        std::uniform_real_distribution<double> base(1500, 2500);
+        std::uniform_real_distribution<double> queued(0, 30000);
+        std::bernoulli_distribution busy(0.3);
+        double up = base(rng) + (busy(rng) ? queued(rng) : 0);
+        double down = base(rng) + (busy(rng) ? queued(rng) : 0);
+        double proc = 300;
+
+        double t2 = clientUs(t1 + (int64_t)up) / 1000.0;
+        double t3 = t2 + proc / 1000.0;
+        t4 = t1 + (int64_t)(up + proc + down);
+
+        char msg[80];
+        int n = snprintf(msg, sizeof(msg), "sync=%lld,%.3f,%.3f", (long long)t1, t2, t3);
+        ClientClock out;
+        return sync.reply(id, msg, n, t4, out);
+    }
+};
+
+static const double UNIX_NOW_US = 1.76e15; // browsers answer in unix ms
+
+// Exchanges every SYNC_INTERVAL_MS of simulated device time
+static void run(ClockSync &sync, SimClient **clients, int n, int exchanges) {
+    for (int e = 0; e < exchanges; e++) {
+        for (int i = 0; i < n; i++) {
+            int64_t t4;
+            TEST_ASSERT_TRUE(clients[i]->exchange(sync, t4));
+        }
+        hostTimerSkewUs += SYNC_INTERVAL_MS * 1000LL;
+    }
+}
+
+void setUp() { hostTimerSkewUs = 0; }
+void tearDown() {}
+
+void test_unsynced_client_has_no_mapping() {
+    ClockSync sync;
+    sync.add(1);
+    int64_t us;
+    TEST_ASSERT_FALSE(sync.toClientUs(1, esp_timer_get_time(), us));
+    TEST_ASSERT_FALSE(sync.toClientUs(2, esp_timer_get_time(), us));
+}
+
+void test_offset_after_one_exchange() {
+    ClockSync sync;
+    SimClient c = { 1, UNIX_NOW_US, 0, std::mt19937(1) };
+    sync.add(1);
+    int64_t t4;
+    TEST_ASSERT_TRUE(c.exchange(sync, t4));
+
+    int64_t dev = esp_timer_get_time(), us;
+    TEST_ASSERT_TRUE(sync.toClientUs(1, dev, us));
+    // Error is half the up / down asymmetry of that one exchange
+    TEST_ASSERT_TRUE(fabs(us - c.clientUs(dev)) < 20000);
+}
+
+void test_drift_is_tracked_between_exchanges() {
+    ClockSync sync;
+    SimClient c = { 1, UNIX_NOW_US, 45, std::mt19937(2) };
+    SimClient *list[] = { &c };
+    sync.add(1);
+    run(sync, list, 1, SYNC_SAMPLES * SYNC_WINDOW * 2);
+
+    ClientClock clocks[WS_MAX_CLIENTS];
+    TEST_ASSERT_EQUAL(1, sync.copy(clocks));
+    TEST_ASSERT_TRUE(fabs(clocks[0].drift * 1e6 - 45) < 5);
+
+    // 10 s past the last exchange, the fit still holds within a millisecond
+    int64_t dev = esp_timer_get_time() + 10000000, us;
+    TEST_ASSERT_TRUE(sync.toClientUs(1, dev, us));
+    TEST_ASSERT_TRUE(fabs(us - c.clientUs(dev)) < 1000);
+
+    double ms;
+    TEST_ASSERT_TRUE(sync.toClientMs(1, dev, ms));
+    TEST_ASSERT_TRUE(fabs(ms * 1000 - us) < 1);
+}
+
+void test_clients_are_mapped_independently() {
+    ClockSync sync;
+    SimClient a = { 1, UNIX_NOW_US, 30, std::mt19937(3) };
+    SimClient b = { 2, -5e6, -80, std::mt19937(4) }; // uptime-based client, slow clock
+    SimClient *list[] = { &a, &b };
+    sync.add(1);
+    sync.add(2);
+    run(sync, list, 2, SYNC_SAMPLES * SYNC_WINDOW * 2);
+
+    int64_t dev = esp_timer_get_time(), ua, ub;
+    TEST_ASSERT_TRUE(sync.toClientUs(1, dev, ua));
+    TEST_ASSERT_TRUE(sync.toClientUs(2, dev, ub));
+    TEST_ASSERT_TRUE(fabs(ua - a.clientUs(dev)) < 1000);
+    TEST_ASSERT_TRUE(fabs(ub - b.clientUs(dev)) < 1000);
+
+    sync.remove(1);
+    TEST_ASSERT_FALSE(sync.toClientUs(1, dev, ua));
+    TEST_ASSERT_TRUE(sync.toClientUs(2, dev, ub));
+}
+
+void test_stale_reply_is_ignored() {
+    ClockSync sync;
+    sync.add(1);
+    int64_t t1 = sync.request(1);
+    char msg[80];
+    int n = snprintf(msg, sizeof(msg), "sync=%lld,1000.0,1000.1", (long long)(t1 - 1));
+    ClientClock out;
+    TEST_ASSERT_FALSE(sync.reply(1, msg, n, t1 + 3000, out));
+    n = snprintf(msg, sizeof(msg), "sync=%lld,1000.0,1000.1", (long long)t1);
+    TEST_ASSERT_TRUE(sync.reply(1, msg, n, t1 + 3000, out));
+    TEST_ASSERT_FALSE(sync.reply(1, msg, n, t1 + 3000, out)); // answered already
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unsynced_client_has_no_mapping);
+    RUN_TEST(test_offset_after_one_exchange);
+    RUN_TEST(test_drift_is_tracked_between_exchanges);
+    RUN_TEST(test_clients_are_mapped_independently);
+    RUN_TEST(test_stale_reply_is_ignored);
+    return UNITY_END();
+}
@@ -0,0 +1,131 @@
+// SignalFilter on synthetic approaching cars: LD2451 frames every 100 ms
+// +-15 ms, distance quantized to 1 m on top of 0.6 m noise, speed in whole
+// km/h with 1 km/h noise. The alpha-beta tracker must keep the lag the old
+// double EMA had (0.18, once in the parser and once in loop()) off the
+// display with frame to frame jitter below the quantization, ride out lost
+// frames, and a slot handed to another car must not carry the first car's
+// estimate.
+
+#include <unity.h>
+#include <random>
+#include "FilterModule.h"
+
+static const int WARMUP = 10; // frames before the estimates are scored
+
+struct Score {
+    double lag;    // mean filtered - true distance, m (positive = behind an approaching car)
+    double jitter; // RMS of the frame to frame change of that error, m
+};
+
+struct DoubleEma {
+    float a = -1, b = -1;
+    float smooth(float raw) {
+        a = a < 0 ? raw : 0.18f * raw + 0.82f * a;
+        b = b < 0 ? a : 0.18f * a + 0.82f * b;
+        return b;
+    }
+};
+
+static void score(double err, double &prev, int k, double &sum, double &sq) {
+    if (k > WARMUP) sq += (err - prev) * (err - prev);
+    prev = err;
+    sum += err;
+}
+
+// One car approaching from 100 m at kmh until it is 5 m away
+static void replay(float kmh, uint32_t seed, Score &ab, Score &ema) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> distNoise(0, 0.6), speedNoise(0, 1);
+    std::uniform_int_distribution<int> jitterMs(-15, 15);
+
+    SignalFilter filter;
+    DoubleEma old;
+    double v = kmh / 3.6, d = 100;
+    unsigned long now = 1000;
+    double abSum = 0, abSq = 0, abPrev = 0, emaSum = 0, emaSq = 0, emaPrev = 0;
+    int k = 0, scored = 0;
+
+    while (d > 5 && k < 600) {
+        int raw = (int)lround(d + distNoise(rng));
+        if (raw < 0) raw = 0;
+        int speed = (int)lround(kmh + speedNoise(rng));
+        if (speed < 0) speed = 0;
+
+        float a = filter.smooth(0, (float)raw, -speed / 3.6f, now);
+        float e = old.smooth((float)raw);
+        if (k >= WARMUP) {
+            score(a - d, abPrev, k, abSum, abSq);
+            score(e - d, emaPrev, k, emaSum, emaSq);
+            scored++;
+        }
+
+        int step = 100 + jitterMs(rng);
+        now += step;
+        d -= v * step / 1000.0;
+        k++;
+    }
+    ab = { abSum / scored, sqrt(abSq / (scored - 1)) };
+    ema = { emaSum / scored, sqrt(emaSq / (scored - 1)) };
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_lag_and_jitter_per_speed() {
+    static const float speeds[] = { 0, 30, 60, 100 };
+    for (float kmh : speeds) {
+        Score ab, ema;
+        replay(kmh, 37 + (uint32_t)kmh, ab, ema);
+
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%3.0f km/h: lag %+.2f m (double EMA %+.2f), jitter %.2f m (%.2f)",
+                 kmh, ab.lag, ema.lag, ab.jitter, ema.jitter);
+        TEST_MESSAGE(msg);
+
+        // Within half the distance quantization at every speed, where the
+        // EMA trails by metres; the EMA is only steadier on a parked car
+        TEST_ASSERT_TRUE(fabs(ab.lag) < 0.5);
+        TEST_ASSERT_TRUE(ab.jitter < 0.25);
+        if (kmh >= 30) TEST_ASSERT_TRUE(fabs(ab.lag) < ema.lag / 10);
+        if (kmh >= 60) TEST_ASSERT_TRUE(ab.jitter < ema.jitter);
+    }
+}
+
+void test_missed_frames_keep_track() {
+    // 100 km/h, two frames lost: 8.3 m covered since the last one, more than
+    // the bare 3 m gate but still the same car
+    SignalFilter filter;
+    float v = 100 / 3.6f, d = 90;
+    unsigned long now = 1000;
+    for (int k = 0; k < 15; k++, now += 100, d -= v / 10) filter.smooth(0, lroundf(d), -v, now);
+    now += 200;
+    d -= 2 * v / 10;
+    for (int k = 0; k < 5; k++, now += 100, d -= v / 10) {
+        // A restarted track would snap to the quantized raw value
+        float out = filter.smooth(0, lroundf(d), -v, now);
+        TEST_ASSERT_FLOAT_WITHIN(0.3f, d, out);
+    }
+}
+
+void test_slot_handed_to_another_car_restarts() {
+    // Slot 0 follows a car at 18-19 m, then a nearer car takes the slot after
+    // an exclusion or clutter suppression compacted the list
+    SignalFilter filter;
+    unsigned long now = 1000;
+    for (int k = 0; k < 30; k++, now += 100) filter.smooth(0, 19, -1 / 3.6f, now);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 19, filter.smooth(0, 19, -1 / 3.6f, now));
+    now += 100;
+    TEST_ASSERT_EQUAL_FLOAT(10, filter.smooth(0, 10, -20 / 3.6f, now));
+
+    // ...and tracks the new car from there
+    float out = filter.smooth(0, 10, -20 / 3.6f, now + 100);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 10, out);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_lag_and_jitter_per_speed);
+    RUN_TEST(test_missed_frames_keep_track);
+    RUN_TEST(test_slot_handed_to_another_car_restarts);
+    return UNITY_END();
+}
@@ -0,0 +1,338 @@
+// JsonWriter output validity (checked with a strict parser below) and a
+// benchmark of the radar message against the snprintf code it replaced.
+
+#include <unity.h>
+#include <chrono>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include "JsonWriter.h"
+
+// ---- strict RFC 8259 validator (no extensions, whole input) ----
+
+static const char *skipWs(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    return p;
+}
+
+static const char *parseValue(const char *p);
+
+static const char *parseString(const char *p) {
+    if (*p++ != '"') return nullptr;
+    while (*p != '"') {
+        if ((unsigned char)*p < 0x20) return nullptr;
+        if (*p == '\\') {
+            p++;
+            if (*p == 'u') {
+                for (int i = 1; i <= 4; i++) {
+                    if (!isxdigit((unsigned char)p[i])) return nullptr;
+                }
+                p += 4;
+            } else if (!strchr("\"\\/bfnrt", *p) || !*p) {
+                return nullptr;
+            }
+        }
+        p++;
+    }
+    return p + 1;
+}
+
+static const char *parseNumber(const char *p) {
+    if (*p == '-') p++;
+    if (*p == '0') p++;
+    else if (*p >= '1' && *p <= '9') while (isdigit((unsigned char)*p)) p++;
+    else return nullptr;
+    if (*p == '.') {
+        p++;
+        if (!isdigit((unsigned char)*p)) return nullptr;
+        while (isdigit((unsigned char)*p)) p++;
+    }
+    return p;
+}
+
+static const char *parseContainer(const char *p, char close, bool object) {
+    p = skipWs(p + 1);
+    if (*p == close) return p + 1;
+    for (;;) {
+        if (object) {
+            p = parseString(skipWs(p));
+            if (!p) return nullptr;
+            p = skipWs(p);
+            if (*p++ != ':') return nullptr;
+        }
+        p = parseValue(p);
+        if (!p) return nullptr;
+        p = skipWs(p);
+        if (*p == close) return p + 1;
+        if (*p++ != ',') return nullptr;
+    }
+}
+
+static const char *parseValue(const char *p) {
+    p = skipWs(p);
+    if (*p == '{') return parseContainer(p, '}', true);
+    if (*p == '[') return parseContainer(p, ']', false);
+    if (*p == '"') return parseString(p);
+    if (!strncmp(p, "true", 4)) return p + 4;
+    if (!strncmp(p, "false", 5)) return p + 5;
+    if (!strncmp(p, "null", 4)) return p + 4;
+    return parseNumber(p);
+}
+
+static bool validJson(const char *s) {
+    const char *end = parseValue(s);
+    return end && *skipWs(end) == '\0';
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ---- writer ----
+
+void test_nested_document() {
+    char buf[256];
+    JsonWriter w(buf, sizeof(buf));
+    w.beginObject()
+        .fieldStr("type", "stats")
+        .fieldU("uptime", 1234)
+        .beginArray("hits");
+    for (int i = 0; i < 3; i++) w.valueU(i);
+    w.endArray()
+        .beginObject("camera")
+            .fieldBool("standby", true)
+            .field("skew", -5)
+        .endObject()
+        .beginArray("empty").endArray()
+    .endObject();
+
+    TEST_ASSERT_TRUE(w.ok());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"stats\",\"uptime\":1234,\"hits\":[0,1,2],\"camera\":{\"standby\":1,\"skew\":-5},\"empty\":[]}",
+        buf);
+    TEST_ASSERT_EQUAL_size_t(strlen(buf), w.length());
+    TEST_ASSERT_TRUE(validJson(buf));
+}
+
+void test_array_of_objects() {
+    char buf[128];
+    JsonWriter w(buf, sizeof(buf));
+    w.beginObject().beginArray("targets");
+    for (int i = 0; i < 2; i++) w.beginObject().field("id", i).endObject();
+    w.endArray().endObject();
+    TEST_ASSERT_EQUAL_STRING("{\"targets\":[{\"id\":0},{\"id\":1}]}", buf);
+    TEST_ASSERT_TRUE(validJson(buf));
+}
+
+void test_integer_limits() {
+    char buf[256];
+    JsonWriter w(buf, sizeof(buf));
+    w.beginObject()
+        .field("min", INT32_MIN)
+        .field("max", INT32_MAX)
+        .fieldU("umax", UINT32_MAX)
+        .field("zero", 0)
+        .field64("min64", INT64_MIN)
+        .field64("max64", INT64_MAX)
+        .field64("neg64", -1234567890123LL)
+    .endObject();
+    TEST_ASSERT_TRUE(w.ok());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"min\":-2147483648,\"max\":2147483647,\"umax\":4294967295,\"zero\":0,"
+        "\"min64\":-9223372036854775808,\"max64\":9223372036854775807,\"neg64\":-1234567890123}",
+        buf);
+    TEST_ASSERT_TRUE(validJson(buf));
+}
+
+void test_string_escaping() {
+    char buf[128];
+    JsonWriter w(buf, sizeof(buf));
+    w.beginObject()
+        .fieldStr("quote", "say \"hi\"")
+        .fieldStr("slash", "a\\b")
+        .fieldStr("ctrl", "tab\there\nnl")
+        .fieldStr("empty", "")
+    .endObject();
+    TEST_ASSERT_TRUE(w.ok());
+    // Control characters are replaced, they never occur in the strings we send
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"quote\":\"say \\\"hi\\\"\",\"slash\":\"a\\\\b\",\"ctrl\":\"tab here nl\",\"empty\":\"\"}", buf);
+    TEST_ASSERT_TRUE(validJson(buf));
+}
+
+void test_fixed_point() {
+    char buf[256];
+    JsonWriter w(buf, sizeof(buf));
+    w.beginObject()
+        .fieldFixed("a", 12.34f, 1)
+        .fieldFixed("b", -12.36f, 1)
+        .fieldFixed("c", -0.04f, 1)   // rounds to zero: no "-0.0"
+        .fieldFixed("d", 0.5f, 0)
+        .fieldFixed("e", 3.14159f, 3)
+        .fieldFixed("f", 1.0f, 2)
+        .fieldFixed("g", NAN, 1)      // NaN is not JSON
+        .fieldFixed("h", 7.0f, 9)     // clamped to 6 decimals
+    .endObject();
+    TEST_ASSERT_TRUE(w.ok());
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"a\":12.3,\"b\":-12.4,\"c\":0.0,\"d\":1,\"e\":3.142,\"f\":1.00,\"g\":0,\"h\":7.000000}", buf);
+    TEST_ASSERT_TRUE(validJson(buf));
+}
+
+void test_out_of_range_fixed_point_overflows() {
+    char buf[64];
+    JsonWriter w(buf, sizeof(buf));
+    w.beginObject().fieldFixed("inf", INFINITY, 1).endObject();
+    TEST_ASSERT_FALSE(w.ok());
+
+    JsonWriter w2(buf, sizeof(buf));
+    w2.beginObject().fieldFixed("big", -5.0e9f, 0).endObject();
+    TEST_ASSERT_FALSE(w2.ok());
+}
+
+void test_overflow_is_flagged_and_terminated() {
+    // Every prefix length of the same document
+    char full[128];
+    JsonWriter ref(full, sizeof(full));
+    ref.beginObject().fieldStr("type", "radar").fieldU("timestamp", 4000000000u).field("n", -7).endObject();
+    TEST_ASSERT_TRUE(ref.ok());
+
+    for (size_t cap = 1; cap <= ref.length(); cap++) {
+        char buf[128];
+        memset(buf, 'x', sizeof(buf));
+        JsonWriter w(buf, cap);
+        w.beginObject().fieldStr("type", "radar").fieldU("timestamp", 4000000000u).field("n", -7).endObject();
+        TEST_ASSERT_FALSE(w.ok());
+        TEST_ASSERT_TRUE(w.length() < cap);
+        TEST_ASSERT_EQUAL_INT('\0', buf[w.length()]);
+        TEST_ASSERT_EQUAL_INT('x', buf[cap]); // never wrote past the buffer
+        TEST_ASSERT_EQUAL_INT(0, strncmp(buf, full, w.length()));
+    }
+
+    char buf[128];
+    JsonWriter exact(buf, ref.length() + 1);
+    exact.beginObject().fieldStr("type", "radar").fieldU("timestamp", 4000000000u).field("n", -7).endObject();
+    TEST_ASSERT_TRUE(exact.ok());
+}
+
+void test_zero_capacity() {
+    char c = 'x';
+    JsonWriter w(&c, 0);
+    w.beginObject().endObject();
+    TEST_ASSERT_FALSE(w.ok());
+    TEST_ASSERT_EQUAL_INT('x', c);
+}
+
+void test_unbalanced_and_too_deep() {
+    char buf[128];
+    JsonWriter open(buf, sizeof(buf));
+    open.beginObject().beginArray("a");
+    TEST_ASSERT_FALSE(open.ok());
+
+    JsonWriter deep(buf, sizeof(buf));
+    deep.beginObject();
+    for (int i = 0; i < 9; i++) deep.beginObject("x");
+    for (int i = 0; i < 9; i++) deep.endObject();
+    deep.endObject();
+    TEST_ASSERT_FALSE(deep.ok());
+}
+
+// ---- benchmark: 5 target radar message, JsonWriter vs the old snprintf path ----
+
+struct BenchTarget {
+    int distance, speed, angle, snr;
+    bool approaching;
+    float smoothed;
+    unsigned vision, motion, sensor;
+};
+
+static const BenchTarget TARGETS[5] = {
+    { 12, 38, -12, 41, true, 12.34f, 2, 1, 0 },
+    { 27, 51, 4, 36, true, 26.81f, 0, 0, 0 },
+    { 45, 22, 17, 18, false, 45.12f, 1, 0, 1 },
+    { 63, 70, -33, 25, true, 62.47f, 0, 2, 1 },
+    { 98, 9, 55, 9, false, 97.93f, 0, 0, 0 },
+};
+
+static size_t radarSnprintf(char *buf, size_t cap, uint32_t ts) {
+    int off = snprintf(buf, cap, "{\"type\":\"radar\",\"timestamp\":%lu,\"veto\":%d,\"count\":%d,\"targets\":[",
+                       (unsigned long)ts, 0, 5);
+    for (int i = 0; i < 5 && off < (int)cap; i++) {
+        const BenchTarget &t = TARGETS[i];
+        off += snprintf(buf + off, cap - off,
+                        "{\"id\":%d,\"distance\":%d,\"speed\":%d,\"approaching\":%d,\"angle\":%d,\"snr\":%d,"
+                        "\"smoothdis\":%.1f,\"vision\":%u,\"motion\":%u,\"sensor\":%u}%s",
+                        i, t.distance, t.speed, t.approaching ? 1 : 0, t.angle, t.snr, t.smoothed,
+                        t.vision, t.motion, t.sensor, i < 4 ? "," : "");
+    }
+    if (off < (int)cap) off += snprintf(buf + off, cap - off, "]}");
+    return off;
+}
+
+static size_t radarWriter(char *buf, size_t cap, uint32_t ts) {
+    JsonWriter w(buf, cap);
+    w.beginObject()
+        .fieldStr("type", "radar")
+        .fieldU("timestamp", ts)
+        .fieldBool("veto", false)
+        .field("count", 5)
+        .beginArray("targets");
+    for (int i = 0; i < 5; i++) {
+        const BenchTarget &t = TARGETS[i];
+        w.beginObject()
+            .field("id", i)
+            .field("distance", t.distance)
+            .field("speed", t.speed)
+            .fieldBool("approaching", t.approaching)
+            .field("angle", t.angle)
+            .field("snr", t.snr)
+            .fieldFixed("smoothdis", t.smoothed, 1)
+            .fieldU("vision", t.vision)
+            .fieldU("motion", t.motion)
+            .fieldU("sensor", t.sensor)
+        .endObject();
+    }
+    w.endArray().endObject();
+    return w.ok() ? w.length() : 0;
+}
+
+template <typename F>
+static double nsPerCall(F fn, int iterations) {
+    volatile size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) sink = sink + fn((uint32_t)i);
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+}
+
+void test_bench_radar_message() {
+    char a[1024], b[1024];
+    // Same bytes as the code it replaced
+    TEST_ASSERT_EQUAL_size_t(radarSnprintf(a, sizeof(a), 123456), radarWriter(b, sizeof(b), 123456));
+    TEST_ASSERT_EQUAL_STRING(a, b);
+    TEST_ASSERT_TRUE(validJson(b));
+
+    const int N = 200000;
+    double printfNs = nsPerCall([&](uint32_t ts) { return radarSnprintf(a, sizeof(a), ts); }, N);
+    double writerNs = nsPerCall([&](uint32_t ts) { return radarWriter(b, sizeof(b), ts); }, N);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "5 target radar message (%u bytes): snprintf %.0f ns, JsonWriter %.0f ns",
+             (unsigned)strlen(b), printfNs, writerNs);
+    TEST_MESSAGE(msg);
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nested_document);
+    RUN_TEST(test_array_of_objects);
+    RUN_TEST(test_integer_limits);
+    RUN_TEST(test_string_escaping);
+    RUN_TEST(test_fixed_point);
+    RUN_TEST(test_out_of_range_fixed_point_overflows);
+    RUN_TEST(test_overflow_is_flagged_and_terminated);
+    RUN_TEST(test_zero_capacity);
+    RUN_TEST(test_unbalanced_and_too_deep);
+    RUN_TEST(test_bench_radar_message);
+    return UNITY_END();
+}
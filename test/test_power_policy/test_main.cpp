@@ -0,0 +1,213 @@
+// Drives PowerPolicy the way loop() does, with the target counts a real
+// RadarSensor decodes from the replayed rear stream (idle, overtake, convoy,
+// ghost, idle). Frames arrive every 100 ms of simulated time and every pass
+// sleeps the loop delay of the current profile, so a low power state really
+// delays how soon the next frame is seen.
+
+#include <unity.h>
+#include "ReplaySerial.h"
+#include "RadarSensor.h"
+#include "PowerPolicy.h"
+
+static const unsigned long PERSIST_MS = 800;
+static const uint32_t FRAME_MS = 100;
+
+static std::vector<uint8_t> rearStream;
+
+struct Transition {
+    uint32_t at;
+    PowerState from, to;
+};
+
+struct TraceResult {
+    std::vector<Transition> transitions;
+    uint32_t start, end;
+    uint32_t timeIn[POWER_STATE_COUNT];
+    uint32_t maxRampUpMs;     // frame with targets due -> policy ACTIVE
+    uint32_t targetFrames;
+    uint32_t missedReapply;   // profile changed but update() returned false
+    uint32_t spuriousReapply; // update() returned true for an unchanged profile
+    bool     sawMaxSave;
+};
+
+static bool sameProfile(const PowerProfile &a, const PowerProfile &b) {
+    return a.cpuMhz == b.cpuMhz && a.wifiSave == b.wifiSave && a.loopDelayMs == b.loopDelayMs;
+}
+
+static TraceResult replayTrace(uint32_t cameraTimerMs, int wsClients, int streamClients,
+                               uint64_t startMs = 0) {
+    TraceResult r = {};
+    hostNowUs = startMs * 1000;
+
+    ReplaySerial rear(rearStream);
+    RadarSensor radar(0, rear, -1, -1);
+    radar.begin();
+    radar.settings.clutter = CLUTTER_SUPPRESS;
+
+    PowerPolicy policy;
+    PowerProfile applied = policy.profile();
+    RadarTarget merged[RADAR_MERGED_MAX];
+
+    uint32_t lastTarget = (uint32_t)millis(); // setup() starts the quiet timer
+    uint32_t nextFrame = lastTarget;
+    uint32_t pendingSince = 0;                // due time of an unanswered target frame
+    bool pending = false;
+    r.start = (uint32_t)millis();
+
+    for (;;) {
+        uint32_t now = (uint32_t)millis();
+        // Every frame that became due while the loop slept is in the UART buffer
+        bool more = true;
+        while ((int32_t)(now - nextFrame) >= 0 && (more = rear.feedFrame()))
+            nextFrame += FRAME_MS;
+        if (!more) break;
+
+        radar.ingest();
+        int count = radar.takeFresh()
+            ? mergeRadarTargets(&radar, 1, merged, millis(), PERSIST_MS)
+            : 0;
+        if (count > 0) {
+            lastTarget = now;
+            r.targetFrames++;
+            if (!pending && policy.state() != POWER_ACTIVE) {
+                pending = true;
+                pendingSince = nextFrame - FRAME_MS;
+            }
+        }
+
+        PowerInputs in = { now, lastTarget, count, wsClients, streamClients, cameraTimerMs };
+        PowerState before = policy.state();
+        bool reapply = policy.update(in);
+        if (policy.state() != before)
+            r.transitions.push_back({now, before, policy.state()});
+
+        PowerProfile p = policy.profile();
+        bool changed = !sameProfile(p, applied);
+        if (changed && !reapply) r.missedReapply++;
+        if (!changed && reapply) r.spuriousReapply++;
+        if (reapply) applied = p;
+        if (p.wifiSave == WIFI_SAVE_MAX) r.sawMaxSave = true;
+
+        if (pending && policy.state() == POWER_ACTIVE) {
+            pending = false;
+            if (now - pendingSince > r.maxRampUpMs) r.maxRampUpMs = now - pendingSince;
+        }
+        r.end = now;
+        delay(p.loopDelayMs);
+    }
+
+    for (int s = 0; s < POWER_STATE_COUNT; s++) r.timeIn[s] = policy.timeIn((PowerState)s);
+    return r;
+}
+
+static int countTo(const TraceResult &r, PowerState s) {
+    int n = 0;
+    for (const Transition &t : r.transitions) n += t.to == s;
+    return n;
+}
+
+void setUp() {
+    if (rearStream.empty())
+        TEST_IGNORE_MESSAGE("no test streams, run tools/test_streams.py");
+}
+void tearDown() {}
+
+void test_targets_ramp_up_within_one_loop_delay() {
+    TraceResult r = replayTrace(4000, 0, 0);
+    TEST_ASSERT_TRUE(r.targetFrames > 0);
+    TEST_ASSERT_TRUE(countTo(r, POWER_STANDBY) > 0);
+    // The first frame with a target is handled on the next pass, whatever the state
+    TEST_ASSERT_LESS_OR_EQUAL(15, r.maxRampUpMs);
+    for (const Transition &t : r.transitions) {
+        if (t.to == POWER_ACTIVE) TEST_ASSERT_TRUE(t.from != POWER_ACTIVE);
+    }
+}
+
+void test_steps_down_through_idle() {
+    TraceResult r = replayTrace(4000, 0, 0);
+    for (const Transition &t : r.transitions) {
+        if (t.to == POWER_STANDBY) TEST_ASSERT_EQUAL(POWER_IDLE, t.from);
+        if (t.to == POWER_IDLE) TEST_ASSERT_EQUAL(POWER_ACTIVE, t.from);
+    }
+    // The trace starts and ends with 5 s of heartbeats only
+    TEST_ASSERT_TRUE(r.transitions.size() >= 4);
+    TEST_ASSERT_EQUAL(POWER_IDLE, r.transitions[0].to);
+    TEST_ASSERT_EQUAL(POWER_STANDBY, r.transitions[1].to);
+    TEST_ASSERT_EQUAL(POWER_STANDBY, r.transitions.back().to);
+}
+
+void test_shortest_camera_timer_still_steps_through_idle() {
+    // camera_timer_ms 3000 equals the ACTIVE hold: both expire on the same pass
+    TraceResult r = replayTrace(3000, 0, 0);
+    TEST_ASSERT_TRUE(countTo(r, POWER_STANDBY) > 0);
+    for (const Transition &t : r.transitions) {
+        if (t.to == POWER_STANDBY) TEST_ASSERT_EQUAL(POWER_IDLE, t.from);
+    }
+}
+
+void test_camera_timer_holds_idle() {
+    // Longer than any quiet gap in the trace: never deeper than IDLE
+    TraceResult r = replayTrace(15000, 0, 0);
+    TEST_ASSERT_TRUE(countTo(r, POWER_IDLE) > 0);
+    TEST_ASSERT_EQUAL(0, countTo(r, POWER_STANDBY));
+}
+
+void test_stream_client_holds_idle() {
+    TraceResult r = replayTrace(4000, 0, 1);
+    TEST_ASSERT_TRUE(countTo(r, POWER_IDLE) > 0);
+    TEST_ASSERT_EQUAL(0, countTo(r, POWER_STANDBY));
+}
+
+void test_ws_client_softens_radio_only() {
+    TraceResult none = replayTrace(4000, 0, 0);
+    TraceResult ws = replayTrace(4000, 1, 0);
+    TEST_ASSERT_TRUE(none.sawMaxSave);
+    TEST_ASSERT_FALSE(ws.sawMaxSave);
+    TEST_ASSERT_EQUAL(countTo(none, POWER_STANDBY), countTo(ws, POWER_STANDBY));
+}
+
+void test_update_reports_every_profile_change() {
+    const int ws[] = {0, 1, 0};
+    const int stream[] = {0, 0, 1};
+    for (int i = 0; i < 3; i++) {
+        TraceResult r = replayTrace(4000, ws[i], stream[i]);
+        TEST_ASSERT_EQUAL_UINT32(0, r.missedReapply);
+        TEST_ASSERT_EQUAL_UINT32(0, r.spuriousReapply);
+    }
+}
+
+void test_time_accounting_adds_up() {
+    TraceResult r = replayTrace(4000, 0, 0);
+    uint32_t sum = r.timeIn[POWER_ACTIVE] + r.timeIn[POWER_IDLE] + r.timeIn[POWER_STANDBY];
+    TEST_ASSERT_EQUAL_UINT32(r.end - r.start, sum);
+    TEST_ASSERT_TRUE(r.timeIn[POWER_STANDBY] > 0);
+}
+
+void test_millis_wrap() {
+    // millis() wraps after 49.7 days; start 20 s before it so the convoy straddles it
+    TraceResult ref = replayTrace(4000, 0, 0);
+    TraceResult wrap = replayTrace(4000, 0, 0, 0x100000000ULL - 20000);
+    TEST_ASSERT_EQUAL(ref.transitions.size(), wrap.transitions.size());
+    for (size_t i = 0; i < ref.transitions.size(); i++) {
+        TEST_ASSERT_EQUAL(ref.transitions[i].to, wrap.transitions[i].to);
+        TEST_ASSERT_EQUAL_UINT32(ref.transitions[i].at - ref.start, wrap.transitions[i].at - wrap.start);
+    }
+    for (int s = 0; s < POWER_STATE_COUNT; s++)
+        TEST_ASSERT_EQUAL_UINT32(ref.timeIn[s], wrap.timeIn[s]);
+}
+
+int main(int, char **) {
+    loadTestStream("rear.bin", rearStream);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_targets_ramp_up_within_one_loop_delay);
+    RUN_TEST(test_steps_down_through_idle);
+    RUN_TEST(test_shortest_camera_timer_still_steps_through_idle);
+    RUN_TEST(test_camera_timer_holds_idle);
+    RUN_TEST(test_stream_client_holds_idle);
+    RUN_TEST(test_ws_client_softens_radio_only);
+    RUN_TEST(test_update_reports_every_profile_change);
+    RUN_TEST(test_time_accounting_adds_up);
+    RUN_TEST(test_millis_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,311 @@
+// RadarSensor::negotiateBaud against a simulated LD2451 on the other end of
+// the UART: it has its own rate, answers the config commands at it, switches
+// rate on restart and streams the recorded rear trace between commands.
+// Bytes arrive at wire speed in simulated time, read at the wrong rate they
+// are garbage, and a rate above what the wiring carries corrupts some of
+// them. The last test measures every rate: wire time of a data frame, the
+// delay until loop() can see its targets, and the parse CPU per frame.
+
+#include <unity.h>
+#include <chrono>
+#include <deque>
+#include <random>
+#include "ReplaySerial.h"
+#include "RadarSensor.h"
+
+static const uint32_t RATES[RADAR_BAUD_RATES] = { 115200, 230400, 256000, 460800 };
+static const uint64_t FRAME_US = 100000;  // LD2451 report interval
+static const uint64_t BOOT_US = 500000;   // restart until it answers again
+static const uint32_t POLL_MS = 2;        // ingest task cadence
+
+static std::vector<uint8_t> rearStream;
+
+class SimLd2451 : public HardwareSerial {
+private:
+    struct Byte {
+        uint8_t  value;
+        uint32_t rate;  // sent at
+        uint64_t at;    // fully received
+    };
+
+    std::deque<Byte> _rx;        // radar -> device
+    double   _txFree = 0;        // radar TX busy until
+    std::vector<uint8_t> _cmd;   // device -> radar, not parsed yet
+    bool     _config = false;    // config mode: no data frames
+    uint32_t _pendingRate = 0;   // applied on restart
+    uint64_t _bootUntil = 0;
+    std::mt19937 _rng{49};
+
+    std::vector<size_t> _frameEnd;
+    size_t   _nextFrame = 0;
+    uint64_t _nextFrameAt = 0;
+
+    double byteUs(uint32_t rate) const { return 10e6 / rate; }
+
+    void transmit(const uint8_t *buf, size_t len, double start) {
+        if (start < _txFree) start = _txFree;
+        double us = byteUs(rate);
+        for (size_t i = 0; i < len; i++) {
+            uint8_t v = buf[i];
+            if (rate > maxGoodRate && std::bernoulli_distribution(byteErrors)(_rng)) v ^= 0x10;
+            _rx.push_back({ v, rate, (uint64_t)(start + (i + 1) * us) });
+        }
+        _txFree = start + len * us;
+    }
+
+    // Data frames every FRAME_US while reporting
+    void pump() {
+        uint64_t now = hostNowUs;
+        while (stream && !_config && now >= _bootUntil && _nextFrameAt <= now &&
+               _nextFrame < _frameEnd.size()) {
+            size_t begin = _nextFrame ? _frameEnd[_nextFrame - 1] : 0;
+            size_t end = _frameEnd[_nextFrame++];
+            double start = _nextFrameAt > _txFree ? _nextFrameAt : _txFree;
+            transmit(rearStream.data() + begin, end - begin, start);
+            sent.push_back({ (uint64_t)start, (uint64_t)_txFree });
+            _nextFrameAt += FRAME_US;
+        }
+        if (_nextFrameAt < _bootUntil) _nextFrameAt = _bootUntil;
+    }
+
+    void ack(uint16_t word, const uint8_t *data, size_t len) {
+        uint8_t f[32] = { 0xFD, 0xFC, 0xFB, 0xFA, (uint8_t)(4 + len), 0,
+                          (uint8_t)word, (uint8_t)((word >> 8) | 0x01), 0, 0 };
+        memcpy(f + 10, data, len);
+        memcpy(f + 10 + len, "\x04\x03\x02\x01", 4);
+        transmit(f, 14 + len, hostNowUs + 100.0); // command handling
+    }
+
+    void command(uint16_t word, const uint8_t *value, size_t len) {
+        commands++;
+        static const uint8_t PROTOCOL[4] = { 0x01, 0x00, 0x40, 0x00 };
+        static const uint8_t PARAMS[4] = { 100, 2, 0, 5 };
+        static const uint32_t TABLE[] = { 9600, 19200, 38400, 57600, 115200, 230400, 256000, 460800 };
+        switch (word) {
+            case 0x00FF: _config = true; ack(word, PROTOCOL, 4); break;
+            case 0x00FE: _config = false; ack(word, nullptr, 0); break;
+            case 0x0012: ack(word, PARAMS, 4); break;
+            case 0x00A1:
+                if (len >= 1 && value[0] >= 1 && value[0] <= 8) _pendingRate = TABLE[value[0] - 1];
+                ack(word, nullptr, 0);
+                break;
+            case 0x00A3:
+                ack(word, nullptr, 0);
+                if (_pendingRate) rate = _pendingRate;
+                _pendingRate = 0;
+                _config = false;
+                _bootUntil = (uint64_t)_txFree + BOOT_US;
+                break;
+            default: ack(word, nullptr, 0); break;
+        }
+    }
+
+public:
+    uint32_t rate = RADAR_BAUD_DEFAULT;     // the radar's own UART rate
+    uint32_t maxGoodRate = 460800;          // above this the wiring corrupts bytes
+    double   byteErrors = 0.02;
+    bool     stream = false;
+    uint32_t commands = 0;                  // understood by the radar
+    struct Sent { uint64_t start, end; };
+    std::vector<Sent> sent;                 // data frames on the wire
+
+    SimLd2451() {
+        for (size_t i = 1; i + 4 <= rearStream.size(); i++) {
+            if (!memcmp(&rearStream[i], "\xF4\xF3\xF2\xF1", 4)) _frameEnd.push_back(i);
+        }
+        if (!rearStream.empty()) _frameEnd.push_back(rearStream.size());
+        _nextFrameAt = hostNowUs;
+    }
+
+    bool streamDone() const { return _nextFrame >= _frameEnd.size(); }
+
+    int available() override {
+        pump();
+        int n = 0;
+        for (const Byte &b : _rx) {
+            if (b.at > hostNowUs) break;
+            n++;
+        }
+        return n;
+    }
+
+    int read() override {
+        pump();
+        if (_rx.empty() || _rx.front().at > hostNowUs) return -1;
+        Byte b = _rx.front();
+        _rx.pop_front();
+        // Sampled at the wrong rate a byte is noise
+        return b.rate == baud ? b.value : (uint8_t)(b.value * 37 + 11);
+    }
+
+    size_t read(uint8_t *buf, size_t len) override {
+        size_t n = 0;
+        for (int c; n < len && (c = read()) >= 0; ) buf[n++] = c;
+        return n;
+    }
+
+    size_t write(const uint8_t *buf, size_t len) override {
+        pump();
+        // Lost while it reboots, noise at the wrong rate
+        if (hostNowUs < _bootUntil || baud != rate) return len;
+        if (rate > maxGoodRate &&
+            std::bernoulli_distribution(1 - pow(1 - byteErrors, len))(_rng)) return len;
+
+        _cmd.insert(_cmd.end(), buf, buf + len);
+        while (_cmd.size() >= 12) {
+            if (memcmp(_cmd.data(), "\xFD\xFC\xFB\xFA", 4)) { _cmd.erase(_cmd.begin()); continue; }
+            size_t body = _cmd[4] | (_cmd[5] << 8);
+            if (_cmd.size() < 6 + body + 4) break;
+            command(_cmd[6] | (_cmd[7] << 8), &_cmd[8], body - 2);
+            _cmd.erase(_cmd.begin(), _cmd.begin() + 6 + body + 4);
+        }
+        return len;
+    }
+};
+
+void setUp() { hostNowUs = 0; }
+void tearDown() {}
+
+void test_steps_up_to_fastest_rate() {
+    SimLd2451 sim;
+    RadarSensor radar(0, sim, -1, -1);
+    radar.begin();
+
+    TEST_ASSERT_EQUAL_UINT32(460800, radar.negotiateBaud(0));
+    TEST_ASSERT_EQUAL_UINT32(460800, sim.rate);
+    TEST_ASSERT_EQUAL_UINT32(460800, radar.baud());
+
+    BaudProbe probes[RADAR_BAUD_RATES];
+    TEST_ASSERT_EQUAL(4, radar.baudProbes(probes));
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_UINT32(RATES[i], probes[i].baud);
+        TEST_ASSERT_TRUE(probes[i].ok);
+    }
+    // A parameter read gets faster with the rate (two short frames on the wire)
+    TEST_ASSERT_TRUE(probes[3].readUs <= probes[0].readUs);
+}
+
+void test_falls_back_below_lossy_rate() {
+    SimLd2451 sim;
+    sim.maxGoodRate = 256000;
+    RadarSensor radar(0, sim, -1, -1);
+    radar.begin();
+
+    TEST_ASSERT_EQUAL_UINT32(256000, radar.negotiateBaud(0));
+    TEST_ASSERT_EQUAL_UINT32(256000, sim.rate);
+
+    BaudProbe probes[RADAR_BAUD_RATES];
+    int n = radar.baudProbes(probes);
+    TEST_ASSERT_EQUAL_UINT32(460800, probes[n - 1].baud);
+    TEST_ASSERT_FALSE(probes[n - 1].ok);
+}
+
+void test_stored_rate_is_only_verified() {
+    SimLd2451 sim;
+    sim.rate = 230400;
+    RadarSensor radar(0, sim, -1, -1);
+    radar.begin();
+
+    TEST_ASSERT_EQUAL_UINT32(230400, radar.negotiateBaud(230400));
+    TEST_ASSERT_EQUAL_UINT32(230400, sim.rate);
+    BaudProbe probes[RADAR_BAUD_RATES];
+    TEST_ASSERT_EQUAL(1, radar.baudProbes(probes));
+    TEST_ASSERT_LESS_THAN(100, millis()); // no restart, no stepping
+}
+
+void test_runtime_renegotiation_while_streaming() {
+    if (rearStream.empty()) TEST_IGNORE_MESSAGE("no test streams, run tools/test_streams.py");
+
+    // Booted at 115200 and reporting, as after a first boot with RADAR_BAUD_MAX 115200
+    SimLd2451 sim;
+    sim.stream = true;
+    RadarSensor radar(0, sim, -1, -1);
+    radar.begin();
+    for (int i = 0; i < 3000 / (int)POLL_MS; i++) { radar.ingest(); delay(POLL_MS); }
+    uint32_t framesBefore = radar.health().counters.frames + radar.health().counters.heartbeats;
+    TEST_ASSERT_TRUE(framesBefore > 20);
+
+    // What loop() does for POST /config radar_baud=0
+    TEST_ASSERT_TRUE(radar.pause());
+    uint32_t baud = radar.negotiateBaud(0);
+    radar.resume();
+    TEST_ASSERT_EQUAL_UINT32(460800, baud);
+    TEST_ASSERT_EQUAL_UINT32(460800, sim.rate);
+
+    // Reporting again at the new rate, without frame errors
+    for (int i = 0; i < 3000 / (int)POLL_MS; i++) { radar.ingest(); delay(POLL_MS); }
+    const LinkCounters &c = radar.health().counters;
+    TEST_ASSERT_TRUE(c.frames + c.heartbeats > 20);
+    TEST_ASSERT_EQUAL_UINT32(0, c.badLength + c.footerMismatch);
+}
+
+void test_wire_time_and_cpu_per_rate() {
+    if (rearStream.empty()) TEST_IGNORE_MESSAGE("no test streams, run tools/test_streams.py");
+
+    uint32_t wireUs[RADAR_BAUD_RATES], errors[RADAR_BAUD_RATES];
+    double latencyUs[RADAR_BAUD_RATES];
+    for (int r = 0; r < RADAR_BAUD_RATES; r++) {
+        hostNowUs = 0;
+        SimLd2451 sim;
+        sim.rate = RATES[r];
+        sim.stream = true;
+        RadarSensor radar(0, sim, -1, -1);
+        radar.begin(RATES[r]);
+
+        // The ingest task's loop: everything buffered every POLL_MS
+        double cpuNs = 0, latency = 0;
+        uint32_t fresh = 0, passes = 0;
+        while (!sim.streamDone() || sim.available()) {
+            auto t0 = std::chrono::steady_clock::now();
+            radar.ingest();
+            cpuNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            passes++;
+            if (radar.takeFresh()) {
+                // Newest data frame fully received: its first byte left the radar at start
+                for (size_t i = sim.sent.size(); i-- > 0; ) {
+                    if (sim.sent[i].end > hostNowUs) continue;
+                    latency += hostNowUs - sim.sent[i].start;
+                    fresh++;
+                    break;
+                }
+            }
+            delay(POLL_MS);
+        }
+
+        const LinkCounters &c = radar.health().counters;
+        TEST_ASSERT_TRUE(c.frames > 0);
+        errors[r] = c.badLength + c.footerMismatch; // the trace's own corrupt frames
+        // Same formula as the link wireUs in /stats
+        wireUs[r] = (uint32_t)((uint64_t)c.frameBytes * 10000000 / c.frames / RATES[r]);
+        latencyUs[r] = latency / fresh;
+
+        char msg[160];
+        snprintf(msg, sizeof(msg),
+                 "%6u baud: %2u B/frame, wire %4u us, targets after %4.0f us, UART busy %.2f %%, parse %.0f ns/frame",
+                 (unsigned)RATES[r], (unsigned)(c.frameBytes / c.frames), (unsigned)wireUs[r], latencyUs[r],
+                 100.0 * c.bytes * 10 / RATES[r] / (hostNowUs / 1e6),
+                 cpuNs / (c.frames + c.heartbeats));
+        TEST_MESSAGE(msg);
+    }
+
+    // Wire time scales with 1 / rate, the delay before targets follows it
+    TEST_ASSERT_UINT32_WITHIN(2, wireUs[0] / 4, wireUs[3]);
+    for (int r = 1; r < RADAR_BAUD_RATES; r++) {
+        TEST_ASSERT_EQUAL_UINT32(errors[0], errors[r]);
+        TEST_ASSERT_TRUE(wireUs[r] < wireUs[r - 1]);
+        TEST_ASSERT_TRUE(latencyUs[r] <= latencyUs[r - 1]); // seen on a POLL_MS pass
+    }
+    TEST_ASSERT_TRUE(latencyUs[3] < latencyUs[0]);
+}
+
+int main(int, char **) {
+    loadTestStream("rear.bin", rearStream);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_steps_up_to_fastest_rate);
+    RUN_TEST(test_falls_back_below_lossy_rate);
+    RUN_TEST(test_stored_rate_is_only_verified);
+    RUN_TEST(test_runtime_renegotiation_while_streaming);
+    RUN_TEST(test_wire_time_and_cpu_per_rate);
+    return UNITY_END();
+}
@@ -0,0 +1,209 @@
+// Replays generated LD2451 streams through one and two RadarSensor pipelines
+// (rear: mixed traffic with corrupted frames, side: clutter + convoy):
+// a second sensor must not change what the first one decodes, the clutter
+// map must only drop what the generator's ground truth calls clutter, and the
+// benchmark reports the loop() cost of ingest + merge per 100 ms tick.
+
+#define RADAR_SENSOR_COUNT 2
+
+#include <unity.h>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include "ReplaySerial.h"
+#include "RadarSensor.h"
+
+static const int REPEAT = 50;            // replays per benchmark run
+static const unsigned long PERSIST_MS = 800;
+
+static std::vector<uint8_t> rearStream, sideStream;
+
+// Ground truth of a stream, one entry per frame: time and the kind of every
+// target in frame order (see tools/ld2451_gen.py --truth)
+struct TruthFrame {
+    uint32_t tMs;
+    std::vector<std::string> kinds;
+};
+static std::vector<TruthFrame> sideTruth;
+
+static void loadTruth(const char *name, std::vector<TruthFrame> &out) {
+    std::ifstream in(std::string(TEST_DATA_DIR) + "/" + name);
+    std::string line;
+    while (std::getline(in, line)) {
+        TruthFrame f = { (uint32_t)atof(line.c_str() + line.find(':') + 1), {} };
+        for (size_t at = line.find("\"kind\": \""); at != std::string::npos; at = line.find("\"kind\": \"", at)) {
+            at += 9;
+            f.kinds.push_back(line.substr(at, line.find('"', at) - at));
+        }
+        out.push_back(f);
+    }
+}
+
+struct ReplayResult {
+    uint32_t ticks;
+    uint32_t chunks[2];       // frame chunks fed per sensor
+    LinkCounters counters[2]; // of the last replay
+    uint32_t merged;          // targets out of mergeRadarTargets
+    uint32_t mergedSide;      // of those, tagged with sensor 1
+    uint32_t maxMerged;
+    double   usPerTick;
+};
+
+static ReplayResult replay(int sensors, int repeat) {
+    ReplayResult r = {};
+    double totalUs = 0;
+
+    for (int rep = 0; rep < repeat; rep++) {
+        ReplaySerial rear(rearStream), side(sideStream);
+        RadarSensor radar[2] = {
+            RadarSensor(0, rear, -1, -1),
+            RadarSensor(1, side, -1, -1),
+        };
+        for (int i = 0; i < sensors; i++) {
+            radar[i].begin();
+            radar[i].settings.clutter = CLUTTER_SUPPRESS;
+        }
+        r.chunks[0] = rear.frames();
+        r.chunks[1] = side.frames();
+
+        RadarTarget merged[RADAR_MERGED_MAX];
+        for (;;) {
+            bool more = rear.feedFrame();
+            if (sensors > 1) more |= side.feedFrame();
+            if (!more) break;
+            delay(100); // LD2451 frame interval
+
+            // What loop() does per pass with polled sensors
+            auto t0 = std::chrono::steady_clock::now();
+            bool fresh = false;
+            for (int i = 0; i < sensors; i++) {
+                radar[i].ingest();
+                if (radar[i].takeFresh()) fresh = true;
+            }
+            int n = fresh ? mergeRadarTargets(radar, sensors, merged, millis(), PERSIST_MS) : 0;
+            totalUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+            r.ticks++;
+            r.merged += n;
+            if ((uint32_t)n > r.maxMerged) r.maxMerged = n;
+            for (int i = 0; i < n; i++) {
+                if (merged[i].sensor == 1) r.mergedSide++;
+            }
+        }
+        for (int i = 0; i < sensors; i++) r.counters[i] = radar[i].health().counters;
+    }
+    r.usPerTick = totalUs / r.ticks;
+    return r;
+}
+
+static bool sameDecode(const LinkCounters &a, const LinkCounters &b) {
+    return a.bytes == b.bytes && a.frames == b.frames && a.heartbeats == b.heartbeats &&
+           a.resyncBytes == b.resyncBytes && a.badLength == b.badLength &&
+           a.footerMismatch == b.footerMismatch && a.frameBytes == b.frameBytes;
+}
+
+void setUp() {
+    if (rearStream.empty() || sideStream.empty())
+        TEST_IGNORE_MESSAGE("no test streams, run tools/test_streams.py");
+}
+void tearDown() {}
+
+void test_clean_stream_decodes_every_frame() {
+    ReplayResult r = replay(2, 1);
+    const LinkCounters &side = r.counters[1];
+    TEST_ASSERT_EQUAL_UINT32(r.chunks[1], side.frames + side.heartbeats);
+    TEST_ASSERT_EQUAL_UINT32(0, side.resyncBytes + side.badLength + side.footerMismatch);
+    TEST_ASSERT_EQUAL_UINT32(sideStream.size(), side.bytes);
+}
+
+void test_corrupted_stream_resyncs() {
+    ReplayResult r = replay(1, 1);
+    const LinkCounters &rear = r.counters[0];
+    uint32_t good = rear.frames + rear.heartbeats;
+    TEST_ASSERT_TRUE(rear.resyncBytes + rear.badLength + rear.footerMismatch > 0);
+    TEST_ASSERT_TRUE(good * 100 >= r.chunks[0] * 95); // ~2 % corrupted frames, each loses at most itself and a neighbour
+    TEST_ASSERT_EQUAL_UINT32(rearStream.size(), rear.bytes);
+}
+
+void test_second_sensor_is_independent() {
+    ReplayResult one = replay(1, 1);
+    ReplayResult two = replay(2, 1);
+    TEST_ASSERT_TRUE(sameDecode(one.counters[0], two.counters[0]));
+    TEST_ASSERT_EQUAL_UINT32(0, one.mergedSide);
+    TEST_ASSERT_TRUE(two.mergedSide > 0);
+    TEST_ASSERT_TRUE(two.maxMerged > RADAR_MAX_TARGETS); // both sensors' targets in one list
+    TEST_ASSERT_LESS_OR_EQUAL(RADAR_MERGED_MAX, two.maxMerged);
+}
+
+void test_clutter_suppresses_reflectors_not_cars() {
+    // Side stream frame by frame through the parser and a suppressing map,
+    // each dropped detection checked against the kind the generator gave it
+    TEST_ASSERT_FALSE(sideTruth.empty());
+    LinkCounters counters = {};
+    RadarParser parser(counters);
+    ClutterMap map;
+    ReplaySerial side(sideStream);
+    uint32_t clutter = 0, cars = 0, clutterDropped = 0, carsDropped = 0;
+    size_t frame = 0;
+
+    while (side.feedFrame()) {
+        uint8_t chunk[128];
+        size_t got;
+        while ((got = side.read(chunk, sizeof(chunk))) > 0) parser.push(chunk, got);
+
+        RadarTarget parsed[RADAR_MAX_TARGETS], before[RADAR_MAX_TARGETS];
+        int n;
+        while ((n = parser.next(parsed, RADAR_MAX_TARGETS)) != RADAR_PARSE_NEED_MORE) {
+            TEST_ASSERT_TRUE(frame < sideTruth.size());
+            const TruthFrame &truth = sideTruth[frame++];
+            if (n <= 0) continue;
+            TEST_ASSERT_TRUE(truth.kinds.size() >= (size_t)n); // closest RADAR_MAX_TARGETS kept
+
+            memcpy(before, parsed, n * sizeof(RadarTarget));
+            int kept = map.apply(CLUTTER_SUPPRESS, parsed, n, 1000 + truth.tMs);
+
+            // Kept detections stay in order: walk both lists to find the dropped ones
+            for (int i = 0, k = 0; i < n; i++) {
+                bool isClutter = truth.kinds[i] == "clutter";
+                (isClutter ? clutter : cars)++;
+                if (k < kept && !memcmp(&before[i], &parsed[k], sizeof(RadarTarget))) { k++; continue; }
+                (isClutter ? clutterDropped : carsDropped)++;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(sideTruth.size(), frame);
+    TEST_ASSERT_EQUAL_UINT32(map.stats().suppressed, clutterDropped + carsDropped);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "clutter %u/%u suppressed, cars %u/%u suppressed",
+             clutterDropped, clutter, carsDropped, cars);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL_UINT32(0, carsDropped);
+    TEST_ASSERT_TRUE(cars > 0);
+    TEST_ASSERT_TRUE(clutterDropped * 100 >= clutter * 60); // learning takes the first seconds
+}
+
+void test_bench_one_vs_two_sensors() {
+    ReplayResult one = replay(1, REPEAT);
+    ReplayResult two = replay(2, REPEAT);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "ingest + merge per 100 ms tick: 1 sensor %.2f us, 2 sensors %.2f us (x%.2f), %u ticks",
+             one.usPerTick, two.usPerTick, two.usPerTick / one.usPerTick, (unsigned)two.ticks);
+    TEST_MESSAGE(msg);
+}
+
+int main(int, char **) {
+    loadTestStream("rear.bin", rearStream);
+    loadTestStream("side.bin", sideStream);
+    loadTruth("side.jsonl", sideTruth);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_clean_stream_decodes_every_frame);
+    RUN_TEST(test_corrupted_stream_resyncs);
+    RUN_TEST(test_second_sensor_is_independent);
+    RUN_TEST(test_clutter_suppresses_reflectors_not_cars);
+    RUN_TEST(test_bench_one_vs_two_sensors);
+    return UNITY_END();
+}
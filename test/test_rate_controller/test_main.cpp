@@ -0,0 +1,168 @@
+// RateController driving a throttled link model: a 25 fps camera whose JPEG
+// size follows the ladder level, one viewer behind a 16 KB socket send
+// buffer drained at the link rate, and the StreamFanout rules (send() pumps
+// for up to STREAM_PUMP_MS, a viewer still behind skips new frames). The
+// link steps 20 -> 4 -> 1.5 -> 8 -> 2.6 Mbit/s; each phase must settle on the
+// expected level and stay there but for rare, backed off retries of the
+// level above. The level / kbps trajectory is printed as CSV, one line per
+// second.
+
+#include <unity.h>
+#include <random>
+#include "RateController.h"
+
+static const uint32_t FRAME_US = 40000;   // 25 fps camera
+static const uint32_t PUMP_US = 40000;    // STREAM_PUMP_MS
+static const uint32_t SOCK_BUF = 16384;   // lwIP send buffer of the viewer
+static const uint32_t PHASE_S = 90;
+
+// Typical JPEG size of each ladder level for a street scene (bytes)
+static const uint32_t LEVEL_BYTES[RateController::LEVELS] = {
+    46000, 33800, 24000, 19500, 12000, 10240, 7700,
+};
+
+struct Phase {
+    uint32_t linkKbps;
+    int      level;      // expected settled level
+    int      settleS;    // seconds allowed to get there
+};
+
+struct Link {
+    double queued = 0;   // bytes handed to the socket, not yet on the air
+    uint32_t kbps;
+
+    double bytesPerUs() const { return kbps / 8000.0; }
+    uint32_t usUntilFits() const {
+        return queued <= SOCK_BUF ? 0 : (uint32_t)((queued - SOCK_BUF) / bytesPerUs());
+    }
+    void advance(uint32_t us) {
+        queued -= us * bytesPerUs();
+        if (queued < 0) queued = 0;
+    }
+};
+
+static const Phase PHASES[] = {
+    { 20000, 1, 5 },   // VGA q10 is over the 8 Mbit/s budget on its own
+    {  4000, 3, 10 },  // VGA q22 retried now and then, the link is short of it
+    {  1500, 6, 10 },  // ladder bottom, the link still cannot carry 25 fps
+    {  8000, 1, 60 },  // climbs back one level per clear stretch
+    {  2600, 4, 10 },  // marginal: retries back off instead of oscillating
+};
+static const int PHASE_COUNT = sizeof(PHASES) / sizeof(PHASES[0]);
+
+struct Trace {
+    int      levelAt[PHASE_COUNT * PHASE_S];  // level at the end of every second
+    uint32_t changes[PHASE_COUNT];            // level changes per phase
+};
+
+static void run(Trace &tr, bool csv) {
+    RateController rc;
+    Link link;
+    std::mt19937 rng(43);
+    std::uniform_real_distribution<double> sizeJitter(0.9, 1.1);
+
+    uint64_t now = 1000000;
+    uint32_t nextSecond = 1;
+    memset(&tr, 0, sizeof(tr));
+    if (csv) printf("t_s,link_kbps,level,framesize,quality,kbps,send_ms,skip_pct\n");
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        link.kbps = PHASES[p].linkKbps;
+        uint64_t end = now + (uint64_t)PHASE_S * 1000000;
+        while (now < end) {
+            uint32_t us;
+            uint8_t sent = 0, skipped = 0;
+            uint32_t bytes = (uint32_t)(LEVEL_BYTES[rc.level()] * sizeJitter(rng));
+
+            if (link.queued > SOCK_BUF) {
+                // Still behind on the previous frame: skip this one, pump the old one
+                skipped = 1;
+                us = link.usUntilFits();
+                if (us <= PUMP_US) sent = 1;
+                else us = PUMP_US;
+            } else {
+                link.queued += bytes;
+                us = link.usUntilFits();
+                if (us <= PUMP_US) sent = 1;
+                else us = PUMP_US;
+                us += 200; // writev of the part header and the copy into lwIP
+            }
+            rc.onFrame(bytes, us, sent, skipped);
+
+            uint32_t step = us > FRAME_US ? us : FRAME_US;
+            link.advance(step);
+            now += step;
+
+            int before = rc.level();
+            if (rc.update((uint32_t)(now / 1000), 1) && rc.level() != before) tr.changes[p]++;
+
+            if (now / 1000000 >= nextSecond + 1) {
+                int s = nextSecond - 1;
+                if (s < PHASE_COUNT * (int)PHASE_S) tr.levelAt[s] = rc.level();
+                if (csv) {
+                    RateLevel l = rc.current();
+                    printf("%u,%u,%d,%u,%u,%u,%u,%u\n", nextSecond, link.kbps, rc.level(),
+                           l.framesize, l.quality, rc.kbps(), rc.avgSendMs(), rc.skipPct());
+                }
+                nextSecond++;
+            }
+        }
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Steps back up from the settled level after settling, each one a retry
+static int retriesOf(const Trace &tr, int p, int *lastGap) {
+    int first = p * PHASE_S + PHASES[p].settleS, retries = 0, last = -1;
+    *lastGap = 0;
+    for (int s = first + 1; s < (p + 1) * (int)PHASE_S; s++) {
+        if (tr.levelAt[s] < tr.levelAt[s - 1]) {
+            if (last >= 0) *lastGap = s - last;
+            last = s;
+            retries++;
+        }
+    }
+    return retries;
+}
+
+void test_levels_settle_per_link_rate() {
+    Trace tr;
+    run(tr, true);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        int first = p * PHASE_S + PHASES[p].settleS, end = (p + 1) * PHASE_S, at = 0;
+        for (int s = first; s < end; s++) {
+            // Settled, and only ever one step above it while retrying
+            TEST_ASSERT_TRUE(tr.levelAt[s] == PHASES[p].level || tr.levelAt[s] == PHASES[p].level - 1);
+            if (tr.levelAt[s] == PHASES[p].level) at++;
+        }
+        int gap, retries = retriesOf(tr, p, &gap);
+        char msg[112];
+        snprintf(msg, sizeof(msg), "%5u kbps: level %d by %d s, there %d %% of the time, %d retries, %u changes",
+                 PHASES[p].linkKbps, PHASES[p].level, PHASES[p].settleS, at * 100 / (end - first),
+                 retries, tr.changes[p]);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_TRUE(at * 100 >= (end - first) * 85);
+    }
+}
+
+void test_failed_retries_back_off() {
+    // Where the level above does not fit, each failed retry doubles the wait
+    // up to RATE_MAX_BACKOFF windows instead of flapping every RATE_UP_WINDOWS
+    Trace tr;
+    run(tr, false);
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        int gap, retries = retriesOf(tr, p, &gap);
+        int span = PHASE_S - PHASES[p].settleS;
+        TEST_ASSERT_TRUE(retries <= span / RATE_MAX_BACKOFF + 2);
+        if (retries >= 3) TEST_ASSERT_TRUE(gap >= RATE_MAX_BACKOFF);
+    }
+}
+
+int main(int, char **) {
+    UNITY_BEGIN();
+    RUN_TEST(test_levels_settle_per_link_rate);
+    RUN_TEST(test_failed_retries_back_off);
+    return UNITY_END();
+}
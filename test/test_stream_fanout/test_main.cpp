@@ -0,0 +1,370 @@
+// Serves real loopback TCP viewers from StreamFanout, fed like the stream
+// task does: one camera buffer refilled for every frame at 25 fps. Viewers
+// parse the multipart stream and check every JPEG byte, so a frame sent from
+// a reused camera buffer would show up as corrupt. The previous handler
+// (one writev, then finish the frame within 250 ms or drop the viewer) is
+// kept below as the benchmark reference.
+
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <string>
+#include "Arduino.h"
+#include "StreamFanout.h"
+
+static const size_t JPEG_BYTES = 30000;    // VGA at quality 10 is 20-40 KB
+static const int SOCK_BUF = 8192;          // close to lwIP's TCP_SND_BUF
+static const uint32_t FRAME_US = 40000;    // 25 fps camera
+static const int RUN_MS = 2000;
+
+static uint8_t pattern(uint32_t ts, size_t i) { return (uint8_t)(ts * 31 + i * 7); }
+
+// ===== Viewer: reads and checks the multipart stream on its own thread =====
+struct Viewer {
+    int fd = -1;        // client side
+    int serverFd = -1;  // accepted side, handed to the server under test
+    uint32_t pauseUs;   // after every read: 0 = fast phone
+    size_t chunk;
+    std::thread th;
+    std::vector<uint8_t> buf;
+    uint32_t frames = 0;
+    uint32_t bad = 0;
+
+    Viewer(uint32_t pauseUs, size_t chunk) : pauseUs(pauseUs), chunk(chunk) {}
+
+    void parse() {
+        size_t pos = 0;
+        const size_t blen = strlen(_STREAM_BOUNDARY);
+        for (;;) {
+            const uint8_t *p = buf.data() + pos;
+            size_t avail = buf.size() - pos;
+            const uint8_t *end = (const uint8_t*)memmem(p, avail, "\r\n\r\n", 4);
+            if (!end) break;
+            size_t hlen = end + 4 - p;
+
+            unsigned len = 0, ts = 0;
+            std::string head((const char*)p, hlen);
+            if (sscanf(head.c_str(), "Content-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %u", &len, &ts) != 2) {
+                bad++;
+                buf.clear();
+                return;
+            }
+            if (avail < hlen + len + blen) break;
+
+            const uint8_t *jpeg = p + hlen;
+            bool ok = memcmp(jpeg + len, _STREAM_BOUNDARY, blen) == 0;
+            for (size_t i = 0; ok && i < len; i++) ok = jpeg[i] == pattern(ts, i);
+            if (ok) frames++;
+            else bad++;
+            pos += hlen + len + blen;
+        }
+        buf.erase(buf.begin(), buf.begin() + pos);
+    }
+
+    void start() {
+        th = std::thread([this] {
+            std::vector<uint8_t> tmp(chunk);
+            for (;;) {
+                ssize_t n = recv(fd, tmp.data(), tmp.size(), 0);
+                if (n <= 0) break;
+                buf.insert(buf.end(), tmp.begin(), tmp.begin() + n);
+                parse();
+                if (pauseUs) std::this_thread::sleep_for(std::chrono::microseconds(pauseUs));
+            }
+        });
+    }
+
+    // Server side closes its end, the thread reads to EOF
+    void finish() {
+        shutdown(serverFd, SHUT_WR);
+        th.join();
+        close(fd);
+    }
+};
+
+static int listener() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    listen(fd, 8);
+    return fd;
+}
+
+static void connectViewer(int lfd, Viewer &v) {
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    getsockname(lfd, (struct sockaddr*)&addr, &alen);
+
+    v.fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(v.fd, SOL_SOCKET, SO_RCVBUF, &SOCK_BUF, sizeof(SOCK_BUF));
+    connect(v.fd, (struct sockaddr*)&addr, sizeof(addr));
+
+    v.serverFd = accept(lfd, NULL, NULL);
+    int one = 1;
+    setsockopt(v.serverFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(v.serverFd, SOL_SOCKET, SO_SNDBUF, &SOCK_BUF, sizeof(SOCK_BUF));
+    fcntl(v.serverFd, F_SETFL, fcntl(v.serverFd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// ===== Reference: the handler StreamFanout replaced =====
+class LegacyStream {
+private:
+    static const int FINISH_MS = 250;
+    struct Client { int fd; size_t offset; };
+    Client _clients[STREAM_MAX_CLIENTS];
+    int _count = 0;
+
+    enum SendResult { SEND_DONE, SEND_PARTIAL, SEND_BLOCKED, SEND_FAILED };
+
+    void closeClient(Client &c) { close(c.fd); c.fd = -1; c.offset = 0; _count--; }
+
+    SendResult sendFrom(Client &c, const struct iovec *iov, int iovcnt, size_t total) {
+        struct iovec part[3];
+        int n = 0;
+        size_t skip = c.offset;
+        for (int i = 0; i < iovcnt; i++) {
+            if (skip >= iov[i].iov_len) { skip -= iov[i].iov_len; continue; }
+            part[n].iov_base = (uint8_t*)iov[i].iov_base + skip;
+            part[n].iov_len = iov[i].iov_len - skip;
+            skip = 0;
+            n++;
+        }
+        ssize_t sent = writev(c.fd, part, n);
+        if (sent < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? SEND_BLOCKED : SEND_FAILED;
+        c.offset += sent;
+        if (c.offset < total) return SEND_PARTIAL;
+        c.offset = 0;
+        return SEND_DONE;
+    }
+
+public:
+    uint32_t dropped = 0;
+
+    LegacyStream() { for (Client &c : _clients) c = { -1, 0 }; }
+    bool add(int fd) {
+        for (Client &c : _clients) {
+            if (c.fd < 0) { c = { fd, 0 }; _count++; return true; }
+        }
+        return false;
+    }
+    int count() const { return _count; }
+
+    uint32_t send(const uint8_t *jpeg, size_t len, uint32_t timestampMs) {
+        char part_buf[96];
+        size_t hlen = snprintf(part_buf, sizeof(part_buf), _STREAM_PART, (unsigned)len, (unsigned)timestampMs);
+        struct iovec iov[3] = {
+            { part_buf, hlen },
+            { (void*)jpeg, len },
+            { (void*)_STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY) },
+        };
+        size_t total = hlen + len + iov[2].iov_len;
+
+        int64_t start = esp_timer_get_time();
+        bool started[STREAM_MAX_CLIENTS] = {};
+        for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+            Client &c = _clients[i];
+            if (c.fd < 0) continue;
+            SendResult r = sendFrom(c, iov, 3, total);
+            if (r == SEND_PARTIAL) started[i] = true;
+            else if (r == SEND_FAILED) closeClient(c);
+        }
+
+        int64_t deadline = start + FINISH_MS * 1000LL;
+        for (;;) {
+            fd_set wfds;
+            FD_ZERO(&wfds);
+            int maxFd = -1;
+            for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+                if (started[i] && _clients[i].fd >= 0) {
+                    FD_SET(_clients[i].fd, &wfds);
+                    if (_clients[i].fd > maxFd) maxFd = _clients[i].fd;
+                }
+            }
+            if (maxFd < 0) break;
+
+            int64_t left = deadline - esp_timer_get_time();
+            if (left <= 0) {
+                for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+                    if (started[i] && _clients[i].fd >= 0) { closeClient(_clients[i]); dropped++; }
+                }
+                break;
+            }
+            struct timeval tv = { (long)(left / 1000000), (long)(left % 1000000) };
+            if (select(maxFd + 1, NULL, &wfds, NULL, &tv) <= 0) continue;
+
+            for (int i = 0; i < STREAM_MAX_CLIENTS; i++) {
+                Client &c = _clients[i];
+                if (!started[i] || c.fd < 0 || !FD_ISSET(c.fd, &wfds)) continue;
+                SendResult r = sendFrom(c, iov, 3, total);
+                if (r == SEND_FAILED) { closeClient(c); started[i] = false; }
+                else if (r == SEND_DONE) started[i] = false;
+            }
+        }
+        return esp_timer_get_time() - start;
+    }
+};
+
+// ===== Stream task stand-in =====
+struct RunResult {
+    uint32_t offered;
+    double   fps;
+    double   cpuUsPerFrame; // stream task CPU inside send()
+    uint32_t maxSendUs;
+    uint32_t copies;
+    uint32_t fastFrames;    // of the first viewer
+    uint32_t slowFrames;    // of the last viewer
+    uint32_t bad;
+    int      connected;     // viewers left at the end
+    int      behind;
+};
+
+static int64_t threadCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint32_t sendUs(StreamFanout &s, const uint8_t *jpeg, size_t len, uint32_t ts, uint32_t &copies) {
+    StreamSendResult r = s.send(jpeg, len, ts);
+    copies += r.copied;
+    return r.us;
+}
+static uint32_t sendUs(LegacyStream &s, const uint8_t *jpeg, size_t len, uint32_t ts, uint32_t &) {
+    return s.send(jpeg, len, ts);
+}
+static void drain(StreamFanout &s) {
+    for (int i = 0; i < 2000 && s.behind(); i++) {
+        s.pump();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+static void drain(LegacyStream &) {}
+
+// viewers: read pause per viewer (0 = fast); closeAfterMs: first viewer hangs up then
+template <typename Server>
+static RunResult run(const std::vector<uint32_t> &pauses, int closeAfterMs = -1) {
+    RunResult r = {};
+    Server server;
+    int lfd = listener();
+
+    std::vector<Viewer*> viewers;
+    for (uint32_t pause : pauses) {
+        Viewer *v = new Viewer(pause, pause ? 2048 : 65536);
+        connectViewer(lfd, *v);
+        server.add(v->serverFd);
+        v->start();
+        viewers.push_back(v);
+    }
+
+    std::vector<uint8_t> camera(JPEG_BYTES); // one buffer, refilled for every frame
+    int64_t start = esp_timer_get_time(), cpu = 0;
+    int64_t next = start;
+    bool hungUp = false;
+
+    while (esp_timer_get_time() - start < RUN_MS * 1000LL) {
+        int64_t wait = next - esp_timer_get_time();
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::microseconds(wait));
+        int64_t now = esp_timer_get_time();
+        next = (next + FRAME_US > now) ? next + FRAME_US : now; // latest frame, like CAMERA_GRAB_LATEST
+
+        if (closeAfterMs >= 0 && !hungUp && now - start >= closeAfterMs * 1000LL) {
+            shutdown(viewers[0]->fd, SHUT_RDWR);
+            hungUp = true;
+        }
+
+        uint32_t ts = (uint32_t)((now - start) / 1000);
+        for (size_t i = 0; i < camera.size(); i++) camera[i] = pattern(ts, i);
+
+        int64_t c0 = threadCpuUs();
+        uint32_t us = sendUs(server, camera.data(), camera.size(), ts, r.copies);
+        cpu += threadCpuUs() - c0;
+        if (us > r.maxSendUs) r.maxSendUs = us;
+        r.offered++;
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    drain(server);
+    r.connected = server.count();
+    if constexpr (std::is_same<Server, StreamFanout>::value) r.behind = server.behind();
+
+    for (Viewer *v : viewers) {
+        v->finish();
+        r.bad += v->bad;
+    }
+    r.fastFrames = viewers.front()->frames;
+    r.slowFrames = viewers.back()->frames;
+    r.fps = r.offered * 1e6 / elapsed;
+    r.cpuUsPerFrame = (double)cpu / r.offered;
+
+    for (Viewer *v : viewers) delete v;
+    close(lfd);
+    return r;
+}
+
+static const uint32_t SLOW_PAUSE_US = 10000; // 2 KB per 10 ms: a 30 KB frame takes ~150 ms
+
+void setUp() {}
+void tearDown() {}
+
+void test_fast_viewers_get_every_frame() {
+    RunResult r = run<StreamFanout>({0, 0});
+    TEST_ASSERT_EQUAL_UINT32(0, r.bad);
+    TEST_ASSERT_EQUAL(2, r.connected);
+    TEST_ASSERT_TRUE(r.fastFrames * 100 >= r.offered * 95);
+    TEST_ASSERT_TRUE(r.slowFrames * 100 >= r.offered * 95); // second fast viewer
+}
+
+void test_slow_viewer_does_not_stall_capture() {
+    RunResult r = run<StreamFanout>({0, SLOW_PAUSE_US});
+    TEST_ASSERT_EQUAL_UINT32(0, r.bad);
+    TEST_ASSERT_EQUAL(2, r.connected);       // never dropped
+    TEST_ASSERT_EQUAL(0, r.behind);          // drained once frames stop
+    TEST_ASSERT_TRUE(r.fps >= 20);           // camera pace kept (25 fps)
+    TEST_ASSERT_TRUE(r.fastFrames * 100 >= r.offered * 90);
+    TEST_ASSERT_TRUE(r.slowFrames > 0);
+    TEST_ASSERT_TRUE(r.slowFrames < r.fastFrames);
+    TEST_ASSERT_TRUE(r.copies > 0);          // its frames outlived the camera buffer
+    TEST_ASSERT_LESS_OR_EQUAL(STREAM_PUMP_MS * 1000 + 15000, r.maxSendUs);
+}
+
+void test_closed_viewer_is_released() {
+    RunResult r = run<StreamFanout>({SLOW_PAUSE_US, 0}, 500);
+    TEST_ASSERT_EQUAL(1, r.connected);
+    TEST_ASSERT_EQUAL(0, r.behind);
+    TEST_ASSERT_TRUE(r.slowFrames * 100 >= r.offered * 90); // the fast one kept going
+}
+
+void test_bench_fanout_vs_legacy() {
+    const std::vector<uint32_t> setups[] = { {0, 0}, {0, SLOW_PAUSE_US} };
+    const char *names[] = { "2 fast", "fast + slow" };
+
+    for (int i = 0; i < 2; i++) {
+        RunResult legacy = run<LegacyStream>(setups[i]);
+        RunResult fanout = run<StreamFanout>(setups[i]);
+        char msg[256];
+        snprintf(msg, sizeof(msg),
+                 "%s: legacy %.1f fps, %.0f us CPU/frame, max send %u us, fast %u slow %u frames, %d viewers left | "
+                 "fanout %.1f fps, %.0f us CPU/frame, max send %u us, fast %u slow %u frames, %u copies, %d viewers left",
+                 names[i],
+                 legacy.fps, legacy.cpuUsPerFrame, (unsigned)legacy.maxSendUs,
+                 (unsigned)legacy.fastFrames, (unsigned)legacy.slowFrames, legacy.connected,
+                 fanout.fps, fanout.cpuUsPerFrame, (unsigned)fanout.maxSendUs,
+                 (unsigned)fanout.fastFrames, (unsigned)fanout.slowFrames, (unsigned)fanout.copies, fanout.connected);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(int, char **) {
+    signal(SIGPIPE, SIG_IGN); // lwIP reports a closed peer through errno only
+
+    UNITY_BEGIN();
+    RUN_TEST(test_fast_viewers_get_every_frame);
+    RUN_TEST(test_slow_viewer_does_not_stall_capture);
+    RUN_TEST(test_closed_viewer_is_released);
+    RUN_TEST(test_bench_fanout_vs_legacy);
+    return UNITY_END();
+}
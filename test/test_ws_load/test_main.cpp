@@ -0,0 +1,311 @@
+// Host version of tools/loadtest.py, over the parts of the network path that
+// build natively. Radar frames of the replayed rear stream go through
+// RadarSensor, mergeRadarTargets and the RadarSnapshot seqlock as in loop(),
+// are serialized once per distinct format (radarMessageJson /
+// radarMessageBinary) and fanned out by WsSubscriptions::fanOut onto stand-in
+// WS clients: a bounded message queue per client that drops new messages
+// when full, like AsyncWebSocketClient::queueIsFull() makes fanOut do, and a
+// thread draining it. Meanwhile StreamFanout serves a fast and a slow MJPEG
+// viewer over loopback TCP at 25 fps.
+//
+// Latency is taken on the radar topic: from the frame "timestamp" the
+// message carries to the moment a client thread takes it off its queue.
+// Steps through 1, 2, 4 and 8 WS clients, the first of them slow.
+
+#define RADAR_SENSOR_COUNT 1
+
+#include <unity.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <signal.h>
+#include <string>
+#include <thread>
+#include "ReplaySerial.h"
+#include "RadarSensor.h"
+#include "RadarMessage.h"
+#include "StreamFanout.h"
+
+static const uint32_t RADAR_US = 25000;     // 4x the LD2451 rate, to load the path
+static const uint32_t FRAME_US = 40000;     // 25 fps camera
+static const int STEP_MS = 3000;
+static const size_t WS_QUEUE = 32;          // WS_MAX_QUEUED_MESSAGES of AsyncWebSocket
+static const uint32_t SLOW_WS_US = 100000;  // a phone on a bad link takes 10 messages/s
+static const size_t JPEG_BYTES = 30000;
+static const int SOCK_BUF = 8192;
+static const unsigned long PERSIST_MS = 800;
+
+static std::vector<uint8_t> rearStream;
+
+static double wallMs() { return esp_timer_get_time() / 1000.0; }
+
+// ===== WS client stand-in =====
+struct WsClient {
+    uint32_t id;
+    uint8_t format;
+    bool slow;
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<WsBuffer> queue;
+    bool stop = false;
+    std::thread th;
+
+    uint32_t received = 0;
+    uint32_t dropped = 0;      // queue full, not queued
+    std::vector<double> latencyMs;
+
+    WsClient(uint32_t id, uint8_t format, bool slow) : id(id), format(format), slow(slow) {}
+
+    void push(const WsBuffer &buf) {
+        std::lock_guard<std::mutex> lock(m);
+        if (queue.size() >= WS_QUEUE) { dropped++; return; }
+        queue.push_back(buf);
+        cv.notify_one();
+    }
+
+    uint32_t timestampOf(const std::vector<uint8_t> &msg) const {
+        if (format == WS_FORMAT_BINARY) {
+            uint32_t ts;
+            memcpy(&ts, msg.data() + 2, 4);
+            return ts;
+        }
+        std::string text(msg.begin(), msg.end());
+        return (uint32_t)strtoul(text.c_str() + text.find("\"timestamp\":") + 12, nullptr, 10);
+    }
+
+    void start() {
+        th = std::thread([this] {
+            std::unique_lock<std::mutex> lock(m);
+            for (;;) {
+                cv.wait(lock, [this] { return stop || !queue.empty(); });
+                if (queue.empty()) return;
+                WsBuffer msg = queue.front();
+                queue.pop_front();
+                lock.unlock();
+
+                latencyMs.push_back(wallMs() - timestampOf(*msg));
+                received++;
+                if (slow) std::this_thread::sleep_for(std::chrono::microseconds(SLOW_WS_US));
+                lock.lock();
+            }
+        });
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stop = true;
+            queue.clear();
+        }
+        cv.notify_one();
+        th.join();
+    }
+
+    double percentile(int p) {
+        if (latencyMs.empty()) return NAN;
+        std::vector<double> v = latencyMs;
+        std::sort(v.begin(), v.end());
+        return v[std::min(v.size() - 1, (size_t)(p / 100.0 * (v.size() - 1) + 0.5))];
+    }
+};
+
+// ===== MJPEG viewer: counts parts, like loadtest.py =====
+struct Viewer {
+    int fd = -1;
+    int serverFd = -1;
+    uint32_t pauseUs;
+    std::thread th;
+    uint32_t frames = 0;
+
+    explicit Viewer(uint32_t pauseUs) : pauseUs(pauseUs) {}
+
+    void start() {
+        th = std::thread([this] {
+            std::vector<char> buf(pauseUs ? 2048 : 65536);
+            std::string tail;
+            for (;;) {
+                ssize_t n = recv(fd, buf.data(), buf.size(), 0);
+                if (n <= 0) break;
+                std::string data = tail + std::string(buf.data(), n);
+                for (size_t at = data.find("image/jpeg"); at != std::string::npos; at = data.find("image/jpeg", at + 1))
+                    frames++;
+                tail = data.size() > 9 ? data.substr(data.size() - 9) : data;
+                if (pauseUs) std::this_thread::sleep_for(std::chrono::microseconds(pauseUs));
+            }
+        });
+    }
+};
+
+static int listener() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    listen(fd, 8);
+    return fd;
+}
+
+static void connectViewer(int lfd, Viewer &v) {
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    getsockname(lfd, (struct sockaddr*)&addr, &alen);
+
+    v.fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(v.fd, SOL_SOCKET, SO_RCVBUF, &SOCK_BUF, sizeof(SOCK_BUF));
+    connect(v.fd, (struct sockaddr*)&addr, sizeof(addr));
+
+    v.serverFd = accept(lfd, NULL, NULL);
+    int one = 1;
+    setsockopt(v.serverFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(v.serverFd, SOL_SOCKET, SO_SNDBUF, &SOCK_BUF, sizeof(SOCK_BUF));
+    fcntl(v.serverFd, F_SETFL, fcntl(v.serverFd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// ===== One load step =====
+struct StepResult {
+    uint32_t published;      // radar messages fanned out
+    uint32_t serializations;
+    double   streamFps[2];   // fast, slow viewer
+};
+
+static StepResult runStep(std::vector<WsClient*> &clients) {
+    StepResult r = {};
+    WsSubscriptions subs;
+    for (WsClient *c : clients) {
+        WsSubscription out;
+        subs.add(c->id);
+        subs.configure(c->id, c->format == WS_FORMAT_BINARY ? "fmt=bin" : "fmt=json",
+                       c->format == WS_FORMAT_BINARY ? 7 : 8, out);
+        c->start();
+    }
+
+    // Stream task: one reused camera buffer, a fast and a slow viewer
+    int lfd = listener();
+    Viewer fast(0), slow(100000); // slow: 2 KB per 100 ms, loadtest.py's --slow-rate
+    StreamFanout fanout;
+    for (Viewer *v : { &fast, &slow }) {
+        connectViewer(lfd, *v);
+        fanout.add(v->serverFd);
+        v->start();
+    }
+    std::atomic<bool> streaming{true};
+    std::thread stream([&] {
+        std::vector<uint8_t> jpeg(JPEG_BYTES);
+        auto next = std::chrono::steady_clock::now();
+        while (streaming) {
+            uint32_t ts = (uint32_t)wallMs();
+            for (size_t i = 0; i < jpeg.size(); i++) jpeg[i] = (uint8_t)(ts + i);
+            fanout.send(jpeg.data(), jpeg.size(), ts);
+            next += std::chrono::microseconds(FRAME_US);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    // loop(): ingest, merge, publish, fan out on every fresh frame
+    ReplaySerial rear(rearStream);
+    RadarSensor radar[1] = { RadarSensor(0, rear, -1, -1) };
+    radar[0].begin();
+    SeqLock<RadarSnapshot> snapshots;
+    static RadarSnapshot snap;
+    static char scratch[2048];
+
+    auto start = std::chrono::steady_clock::now(), next = start;
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(STEP_MS)) {
+        if (!rear.feedFrame()) break;
+        delay(100); // the sensor's own clock sees LD2451 frame intervals
+        radar[0].ingest();
+        if (radar[0].takeFresh()) {
+            snap.count = mergeRadarTargets(radar, 1, snap.targets, millis(), PERSIST_MS);
+            snap.timestamp = (unsigned long)wallMs();
+            snapshots.publish(snap);
+
+            RadarSnapshot out;
+            snapshots.read(out);
+            subs.fanOut(WS_TOPIC_RADAR, true, (const uint8_t*)scratch,
+                        [&](uint8_t format, uint8_t fields, bool &binary) -> size_t {
+                r.serializations++;
+                binary = format == WS_FORMAT_BINARY;
+                return binary ? radarMessageBinary(out, (uint8_t*)scratch)
+                              : radarMessageJson(scratch, sizeof(scratch), out, fields);
+            }, [&](uint32_t id, const WsBuffer &buf, bool) {
+                for (WsClient *c : clients) {
+                    if (c->id == id) c->push(buf);
+                }
+            });
+            r.published++;
+        }
+        next += std::chrono::microseconds(RADAR_US);
+        std::this_thread::sleep_until(next);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    streaming = false;
+    stream.join();
+    for (WsClient *c : clients) c->finish();
+    for (Viewer *v : { &fast, &slow }) {
+        shutdown(v->serverFd, SHUT_RDWR);
+        v->th.join();
+        close(v->fd);
+        close(v->serverFd);
+    }
+    close(lfd);
+    r.streamFps[0] = fast.frames / seconds;
+    r.streamFps[1] = slow.frames / seconds;
+    return r;
+}
+
+void setUp() {
+    if (rearStream.empty()) TEST_IGNORE_MESSAGE("no test streams, run tools/test_streams.py");
+}
+void tearDown() {}
+
+void test_ws_clients_under_load() {
+    static const int STEPS[] = { 1, 2, 4, 8 };
+    for (int n : STEPS) {
+        // Client 0 is slow, the others alternate JSON (all fields) and binary
+        std::vector<WsClient*> clients;
+        for (int i = 0; i < n; i++)
+            clients.push_back(new WsClient(100 + i, i % 2 ? WS_FORMAT_BINARY : WS_FORMAT_JSON, i == 0));
+        StepResult r = runStep(clients);
+
+        char msg[160];
+        snprintf(msg, sizeof(msg), "=== %d WS clients: %u radar messages, %u serializations, stream %.1f / %.1f fps (fast / slow viewer)",
+                 n, r.published, r.serializations, r.streamFps[0], r.streamFps[1]);
+        TEST_MESSAGE(msg);
+        for (WsClient *c : clients) {
+            snprintf(msg, sizeof(msg), "  ws%d %-4s %-4s %5u msgs %4u dropped  latency p50 %5.1f p95 %5.1f p99 %5.1f ms",
+                     c->id - 100, c->slow ? "slow" : "", c->format == WS_FORMAT_BINARY ? "bin" : "json",
+                     c->received, c->dropped, c->percentile(50), c->percentile(95), c->percentile(99));
+            TEST_MESSAGE(msg);
+        }
+
+        // One serialization per distinct format, however many clients
+        TEST_ASSERT_EQUAL_UINT32(r.published * (n > 1 ? 2 : 1), r.serializations);
+        TEST_ASSERT_TRUE(r.published > 50);
+        TEST_ASSERT_TRUE(r.streamFps[0] > 20);
+
+        for (WsClient *c : clients) {
+            if (c->slow) {
+                // Its queue fills and new messages are dropped, nothing waits on it
+                TEST_ASSERT_TRUE(c->dropped > 0);
+                TEST_ASSERT_TRUE(c->received + c->dropped + WS_QUEUE >= r.published);
+            } else {
+                TEST_ASSERT_EQUAL_UINT32(0, c->dropped);
+                TEST_ASSERT_EQUAL_UINT32(r.published, c->received);
+                TEST_ASSERT_TRUE(c->percentile(99) < 20);
+            }
+        }
+        for (WsClient *c : clients) delete c;
+    }
+}
+
+int main(int, char **) {
+    signal(SIGPIPE, SIG_IGN);
+    loadTestStream("rear.bin", rearStream);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_ws_clients_under_load);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+"""
+Gzips the web UI (web/) into include/WebAssets.h at build time.
+
+Runs as a PlatformIO pre script (extra_scripts = pre:tools/build_web.py)
+or by hand: python tools/build_web.py
+
+Each asset is stored gzipped in flash with a strong ETag (hash of the
+compressed bytes), so the firmware can stream it as-is and answer 304s.
+The header is only rewritten when its content changes, so unchanged
+assets do not trigger a rebuild.
+"""
+
+import gzip
+import hashlib
+import os
+
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+}
+
+
+def symbol_for(name):
+    return "web_" + "".join(c if c.isalnum() else "_" for c in name) + "_gz"
+
+
+def generate(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    out_path = os.path.join(project_dir, "include", "WebAssets.h")
+
+    lines = [
+        "// Generated by tools/build_web.py from web/ - do not edit",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "    const char    *path;",
+        "    const char    *type;",
+        "    const uint8_t *data; // gzipped, in flash",
+        "    size_t         len;",
+        "    const char    *etag;",
+        "};",
+        "",
+    ]
+    table = []
+    total_raw = total_gz = 0
+
+    for name in sorted(os.listdir(web_dir)):
+        path = os.path.join(web_dir, name)
+        ext = os.path.splitext(name)[1]
+        if not os.path.isfile(path) or ext not in MIME_TYPES:
+            continue
+
+        with open(path, "rb") as f:
+            raw = f.read()
+        # mtime=0 keeps the output (and the ETag) stable across builds
+        gz = gzip.compress(raw, compresslevel=9, mtime=0)
+        etag = '\\"' + hashlib.sha1(gz).hexdigest()[:16] + '\\"'
+        sym = symbol_for(name)
+
+        lines.append("static const uint8_t %s[] PROGMEM = {" % sym)
+        for i in range(0, len(gz), 16):
+            lines.append("    " + ",".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+
+        url = "/" if name == "index.html" else "/" + name
+        table.append('    { "%s", "%s", %s, sizeof(%s), "%s" },' % (url, MIME_TYPES[ext], sym, sym, etag))
+        total_raw += len(raw)
+        total_gz += len(gz)
+
+    lines.append("static const WebAsset WEB_ASSETS[] = {")
+    lines += table
+    lines.append("};")
+    lines.append("static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+    lines.append("")
+    lines.append("#endif")
+    lines.append("")
+    content = "\n".join(lines)
+
+    old = None
+    if os.path.exists(out_path):
+        with open(out_path) as f:
+            old = f.read()
+    if old != content:
+        with open(out_path, "w") as f:
+            f.write(content)
+
+    print("web assets: %d files, %d -> %d bytes gzipped" % (len(table), total_raw, total_gz))
+
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO)
+    generate(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,281 @@
+"""
+Synthetic HLK-LD2451 frame generator.
+
+Produces byte-exact LD2451 reporting frames (F4 F3 F2 F1 | len | payload |
+F8 F7 F6 F5, the format RadarParser decodes) from scripted traffic scenarios,
+so the parser, tracker and network paths can be exercised without a radar.
+
+    python tools/ld2451_gen.py convoy --cars 6 --fps 10 --out convoy.bin --truth convoy.jsonl
+    python tools/ld2451_gen.py mixed --corrupt 0.02 --out mixed.bin
+    python tools/ld2451_gen.py overtake --realtime --serial /dev/ttyUSB0   # needs pyserial
+
+Scenarios (combine with "mixed", which plays them back to back):
+  overtake   one car closing in from behind and passing
+  convoy     --cars vehicles in a line, closing at slightly different speeds
+  ghost      low SNR targets flickering at random ranges/angles
+  clutter    stationary reflectors (rail posts, parked cars) with a convoy passing through
+  idle       heartbeat-only period (no targets)
+  mixed      idle, overtake, convoy, ghost, idle
+
+Payload layout: target count, alarm byte, then 5 bytes per target:
+angle + 0x80, distance (m), direction (0 = approaching), speed (km/h), SNR.
+
+--truth writes one JSON line per frame with the time, the ideal targets and
+what was done to the frame (corruption kind), for benchmarks that need the
+ground truth next to the byte stream. Every target carries its "kind": car,
+ghost or clutter, in the order the frame encodes them (closest first).
+"""
+
+import argparse
+import json
+import math
+import random
+import sys
+import time
+
+HEADER = bytes([0xF4, 0xF3, 0xF2, 0xF1])
+FOOTER = bytes([0xF8, 0xF7, 0xF6, 0xF5])
+MAX_RANGE_M = 100
+MAX_PAYLOAD = 100  # RadarParser rejects longer length fields
+
+
+def encode_frame(targets):
+    """targets: list of dicts with angle (deg), distance (m), approaching, speed (km/h), snr"""
+    payload = bytearray([len(targets), 0x01 if targets else 0x00]) if targets else bytearray()
+    for t in targets:
+        payload += bytes([
+            max(0, min(255, int(round(t["angle"])) + 0x80)),
+            max(0, min(255, int(round(t["distance"])))),
+            0x00 if t["approaching"] else 0x01,
+            max(0, min(255, int(round(t["speed"])))),
+            max(0, min(255, int(t["snr"]))),
+        ])
+    return HEADER + len(payload).to_bytes(2, "little") + bytes(payload) + FOOTER
+
+
+# ---------------- traffic models ----------------
+
+class Car:
+    """Straight line approach from behind; rel_kmh > 0 closes in."""
+
+    def __init__(self, start_m, rel_kmh, angle, snr, t0=0.0):
+        self.start_m, self.rel_kmh, self.angle, self.snr, self.t0 = start_m, rel_kmh, angle, snr, t0
+
+    def at(self, t, rng):
+        if t < self.t0:
+            return None
+        d = self.start_m - self.rel_kmh / 3.6 * (t - self.t0)
+        if d < 1 or d > MAX_RANGE_M:
+            return None
+        # Passing cars swing out in angle as they get close
+        angle = self.angle * (1 + 4.0 / max(d, 1.0))
+        return {
+            "angle": angle + rng.gauss(0, 0.5),
+            "distance": d,
+            "approaching": self.rel_kmh > 0,
+            "speed": abs(self.rel_kmh) + rng.gauss(0, 0.7),
+            "snr": self.snr + rng.randint(-2, 2),
+            "kind": "car",
+        }
+
+
+def scenario_overtake(args, rng):
+    cars = [Car(MAX_RANGE_M, args.speed, rng.uniform(-8, -3), 30)]
+    return cars, MAX_RANGE_M / (args.speed / 3.6) + 1
+
+
+def scenario_convoy(args, rng):
+    cars = []
+    for i in range(args.cars):
+        cars.append(Car(
+            MAX_RANGE_M,
+            args.speed + rng.uniform(-5, 5),
+            rng.uniform(-10, 10),
+            rng.randint(15, 40),
+            t0=i * rng.uniform(0.8, 1.6),
+        ))
+    duration = max(c.t0 + MAX_RANGE_M / (c.rel_kmh / 3.6) for c in cars) + 1
+    return cars, duration
+
+
+class Ghost:
+    """Clutter: short-lived low SNR returns at random positions."""
+
+    def __init__(self, rng):
+        self.next_change = 0.0
+        self.cur = None
+        self.rng = rng
+
+    def at(self, t, rng):
+        if t >= self.next_change:
+            self.next_change = t + rng.uniform(0.1, 0.6)
+            self.cur = None if rng.random() < 0.4 else {
+                "angle": rng.uniform(-40, 40),
+                "distance": rng.uniform(3, 60),
+                "approaching": rng.random() < 0.5,
+                "speed": rng.uniform(0, 8),
+                "snr": rng.randint(1, 5),
+                "kind": "ghost",
+            }
+        return dict(self.cur) if self.cur else None
+
+
+def scenario_ghost(args, rng):
+    return [Ghost(rng) for _ in range(3)], args.duration
+
+
+class Reflector:
+    """Stationary clutter: a near-zero speed return at a fixed spot, seen in most frames."""
+
+    def __init__(self, rng):
+        self.angle = rng.uniform(-45, 45)
+        self.distance = rng.uniform(2, 40)
+        self.snr = rng.randint(4, 20)
+        self.visible = rng.uniform(0.5, 0.95)
+
+    def at(self, t, rng):
+        if rng.random() > self.visible:
+            return None
+        return {
+            "angle": self.angle + rng.gauss(0, 1),
+            "distance": self.distance + rng.gauss(0, 0.3),
+            "approaching": rng.random() < 0.5,
+            "speed": abs(rng.gauss(0, 1)),
+            "snr": self.snr + rng.randint(-2, 2),
+            "kind": "clutter",
+        }
+
+
+def scenario_clutter(args, rng):
+    cars, duration = scenario_convoy(args, rng)
+    for c in cars:
+        c.t0 += 5  # let the map learn the scene first
+    return [Reflector(rng) for _ in range(4)] + cars, max(duration + 5, args.duration)
+
+
+def scenario_idle(args, rng):
+    return [], args.duration
+
+
+SCENARIOS = {
+    "overtake": scenario_overtake,
+    "convoy": scenario_convoy,
+    "ghost": scenario_ghost,
+    "clutter": scenario_clutter,
+    "idle": scenario_idle,
+}
+
+
+def timeline(args, rng):
+    """Yields (scenario name, objects, duration) segments."""
+    if args.scenario == "mixed":
+        for name in ("idle", "overtake", "convoy", "ghost", "idle"):
+            objs, dur = SCENARIOS[name](args, rng)
+            yield name, objs, dur
+    else:
+        objs, dur = SCENARIOS[args.scenario](args, rng)
+        yield args.scenario, objs, dur
+
+
+# ---------------- corruption ----------------
+
+def corrupt(frame, rng):
+    kind = rng.choice(["bitflip", "truncate", "garbage", "badlen", "footer"])
+    f = bytearray(frame)
+    if kind == "bitflip":
+        i = rng.randrange(len(f))
+        f[i] ^= 1 << rng.randrange(8)
+    elif kind == "truncate":
+        f = f[:rng.randrange(1, len(f))]
+    elif kind == "garbage":
+        junk = bytes(rng.randrange(256) for _ in range(rng.randint(1, 40)))
+        f = junk + f if rng.random() < 0.5 else f + junk
+    elif kind == "badlen":
+        f[4:6] = rng.randint(MAX_PAYLOAD + 1, 0xFFFF).to_bytes(2, "little")
+    elif kind == "footer":
+        f[-1] ^= 0xFF
+    return bytes(f), kind
+
+
+# ---------------- main ----------------
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("scenario", choices=sorted(SCENARIOS) + ["mixed"])
+    ap.add_argument("--fps", type=float, default=10, help="frame rate (LD2451 default ~10)")
+    ap.add_argument("--jitter-ms", type=float, default=0, help="uniform +- frame interval jitter")
+    ap.add_argument("--speed", type=float, default=40, help="closing speed km/h (overtake/convoy)")
+    ap.add_argument("--cars", type=int, default=6, help="vehicles in the convoy")
+    ap.add_argument("--duration", type=float, default=5, help="seconds for ghost/idle segments")
+    ap.add_argument("--max-targets", type=int, default=8, help="targets per frame (closest first)")
+    ap.add_argument("--corrupt", type=float, default=0, help="probability a frame is corrupted")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--out", help="binary output file (default: stdout)")
+    ap.add_argument("--truth", help="JSON lines ground truth per frame")
+    ap.add_argument("--realtime", action="store_true", help="pace output at the frame rate")
+    ap.add_argument("--serial", help="write to a serial port at --baud (needs pyserial)")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    rng = random.Random(args.seed)
+    max_targets = min(args.max_targets, (MAX_PAYLOAD - 2) // 5)
+
+    if args.serial:
+        import serial  # pyserial
+        out = serial.Serial(args.serial, args.baud)
+    elif args.out:
+        out = open(args.out, "wb")
+    else:
+        out = sys.stdout.buffer
+    truth = open(args.truth, "w") if args.truth else None
+
+    t_global = 0.0
+    frames = corrupted = total_bytes = 0
+    wall0 = time.monotonic()
+
+    for name, objs, duration in timeline(args, rng):
+        t = 0.0
+        while t < duration:
+            targets = [x for x in (o.at(t, rng) for o in objs) if x]
+            targets.sort(key=lambda x: x["distance"])
+            targets = targets[:max_targets]
+
+            frame = encode_frame(targets)
+            kind = None
+            if args.corrupt and rng.random() < args.corrupt:
+                frame, kind = corrupt(frame, rng)
+                corrupted += 1
+
+            if args.realtime:
+                delay = wall0 + t_global - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            out.write(frame)
+            if args.realtime:
+                out.flush()
+
+            if truth:
+                truth.write(json.dumps({
+                    "t_ms": round(t_global * 1000, 1),
+                    "scenario": name,
+                    "targets": [{k: (round(v, 2) if isinstance(v, float) else v) for k, v in x.items()}
+                                for x in targets],
+                    "corrupt": kind,
+                }) + "\n")
+
+            frames += 1
+            total_bytes += len(frame)
+            step = 1.0 / args.fps + rng.uniform(-args.jitter_ms, args.jitter_ms) / 1000.0
+            t += step
+            t_global += step
+
+    if out is not sys.stdout.buffer:
+        out.close()
+    if truth:
+        truth.close()
+    print("%d frames (%d corrupted), %d bytes, %.1f s of traffic" % (frames, corrupted, total_bytes, t_global),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
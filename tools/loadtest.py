@@ -0,0 +1,278 @@
+"""
+Multi-client load test for the SafeBaige network layer.
+
+Opens N WebSocket clients (/ws) and M MJPEG viewers (:81/stream) against a
+running unit, some of them deliberately slow, and reports per-client delivery
+rate, latency percentiles and the device heap as N grows.
+
+    python tools/loadtest.py --host safebaige.local --ws 1,2,4,8 --streams 0,1,2 --slow 1 --duration 20
+
+Latency is measured on the radar topic, whose "timestamp" is the device
+millis() of the radar frame, so it covers loop() processing, serialization
+and the client queue at the frame rate rather than once a second. Device and
+host clocks are aligned per client on the fastest message seen, so the
+reported figures are queuing delay on top of the best case, which is what
+grows under load.
+
+test/test_ws_load is the host counterpart: the same radar serialization and
+fan-out plus StreamFanout, against stand-in clients, no device needed.
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import statistics
+import struct
+import threading
+import time
+import urllib.request
+
+
+# ---------------- minimal WebSocket client ----------------
+
+class WsClient:
+    def __init__(self, host, port, path="/ws", timeout=5):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        key = base64.b64encode(os.urandom(16)).decode()
+        req = (
+            "GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (path, host, key)
+        )
+        self.sock.sendall(req.encode())
+        self.buf = b""
+        while b"\r\n\r\n" not in self.buf:
+            chunk = self.sock.recv(1024)
+            if not chunk:
+                raise ConnectionError("handshake closed")
+            self.buf += chunk
+        head, self.buf = self.buf.split(b"\r\n\r\n", 1)
+        if b" 101 " not in head.split(b"\r\n")[0]:
+            raise ConnectionError(head.split(b"\r\n")[0].decode(errors="replace"))
+
+    def _read(self, n):
+        while len(self.buf) < n:
+            chunk = self.sock.recv(4096)
+            if not chunk:
+                raise ConnectionError("closed")
+            self.buf += chunk
+        out, self.buf = self.buf[:n], self.buf[n:]
+        return out
+
+    def send_text(self, text):
+        payload = text.encode()
+        mask = os.urandom(4)
+        header = bytes([0x81])
+        n = len(payload)
+        if n < 126:
+            header += bytes([0x80 | n])
+        else:
+            header += bytes([0x80 | 126]) + struct.pack(">H", n)
+        masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+        self.sock.sendall(header + mask + masked)
+
+    def recv(self):
+        """Returns (opcode, payload) of the next complete message."""
+        b0, b1 = self._read(2)
+        opcode = b0 & 0x0F
+        n = b1 & 0x7F
+        if n == 126:
+            n = struct.unpack(">H", self._read(2))[0]
+        elif n == 127:
+            n = struct.unpack(">Q", self._read(8))[0]
+        return opcode, self._read(n)
+
+    def close(self):
+        try:
+            self.sock.close()
+        except OSError:
+            pass
+
+
+# ---------------- clients ----------------
+
+class WsLoad(threading.Thread):
+    def __init__(self, args, index, slow):
+        super().__init__(daemon=True)
+        self.args, self.index, self.slow = args, index, slow
+        self.messages = 0
+        self.bytes = 0
+        self.latency = []  # host_ms - device_ms, aligned later
+        self.error = None
+        self.stop = threading.Event()
+
+    def run(self):
+        try:
+            ws = WsClient(self.args.host, self.args.port)
+        except (OSError, ConnectionError) as e:
+            self.error = str(e)
+            return
+        ws.sock.settimeout(2)
+        ws.send_text("topics=radar,stats,events;fmt=json")
+        try:
+            while not self.stop.is_set():
+                try:
+                    opcode, payload = ws.recv()
+                except socket.timeout:
+                    continue
+                now = time.monotonic() * 1000
+                if opcode == 0x8:
+                    self.error = "closed by server"
+                    break
+                self.messages += 1
+                self.bytes += len(payload)
+                if opcode == 0x1:
+                    try:
+                        msg = json.loads(payload)
+                    except ValueError:
+                        continue
+                    if msg.get("type") == "radar":
+                        self.latency.append(now - msg["timestamp"])
+                if self.slow:
+                    # A phone on a bad link: the server side queue fills up
+                    time.sleep(self.args.slow_delay)
+        except (OSError, ConnectionError) as e:
+            self.error = str(e)
+        finally:
+            ws.close()
+
+
+class StreamLoad(threading.Thread):
+    def __init__(self, args, index, slow):
+        super().__init__(daemon=True)
+        self.args, self.index, self.slow = args, index, slow
+        self.frames = 0
+        self.bytes = 0
+        self.error = None
+        self.stop = threading.Event()
+
+    def run(self):
+        try:
+            sock = socket.create_connection((self.args.host, self.args.stream_port), timeout=5)
+            sock.sendall(b"GET /stream HTTP/1.1\r\nHost: %s\r\n\r\n" % self.args.host.encode())
+        except OSError as e:
+            self.error = str(e)
+            return
+        if self.slow:
+            # Small receive window so the device sees a full send buffer
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+        sock.settimeout(2)
+        tail = b""
+        try:
+            while not self.stop.is_set():
+                try:
+                    chunk = sock.recv(4096 if self.slow else 65536)
+                except socket.timeout:
+                    continue
+                if not chunk:
+                    self.error = "closed by server"
+                    break
+                self.bytes += len(chunk)
+                data = tail + chunk
+                self.frames += data.count(b"Content-Type: image/jpeg")
+                tail = data[-32:]
+                if self.slow:
+                    time.sleep(len(chunk) / self.args.slow_rate)
+        except OSError as e:
+            self.error = str(e)
+        finally:
+            sock.close()
+
+
+# ---------------- device stats ----------------
+
+def fetch_stats(args):
+    try:
+        with urllib.request.urlopen("http://%s:%d/stats" % (args.host, args.port), timeout=3) as r:
+            return json.loads(r.read())
+    except (OSError, ValueError):
+        return None
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    values = sorted(values)
+    k = min(len(values) - 1, int(round(p / 100.0 * (len(values) - 1))))
+    return values[k]
+
+
+def run_step(args, n_ws, n_stream):
+    ws = [WsLoad(args, i, i < args.slow) for i in range(n_ws)]
+    streams = [StreamLoad(args, i, i < args.slow) for i in range(n_stream)]
+    for c in ws + streams:
+        c.start()
+        time.sleep(0.05)
+
+    heap = []
+    start = time.monotonic()
+    while time.monotonic() - start < args.duration:
+        st = fetch_stats(args)
+        if st:
+            heap.append((st.get("heap", 0), st.get("minHeap", 0)))
+        time.sleep(1)
+    elapsed = time.monotonic() - start
+
+    for c in ws + streams:
+        c.stop.set()
+    for c in ws + streams:
+        c.join(timeout=3)
+
+    print("\n=== %d WS clients, %d stream clients (%d slow each) ===" % (n_ws, n_stream, args.slow))
+    for c in ws:
+        lat = c.latency
+        base = min(lat) if lat else 0
+        lat = [x - base for x in lat]
+        print(
+            "  ws%-2d %-4s %6.1f msg/s %8.1f kB/s  latency p50 %6.1f p95 %6.1f p99 %6.1f ms%s"
+            % (
+                c.index, "slow" if c.slow else "", c.messages / elapsed, c.bytes / elapsed / 1024,
+                percentile(lat, 50), percentile(lat, 95), percentile(lat, 99),
+                ("  ERROR: " + c.error) if c.error else "",
+            )
+        )
+    for c in streams:
+        print(
+            "  mj%-2d %-4s %6.1f fps    %8.1f kB/s%s"
+            % (
+                c.index, "slow" if c.slow else "", c.frames / elapsed, c.bytes / elapsed / 1024,
+                ("  ERROR: " + c.error) if c.error else "",
+            )
+        )
+    if heap:
+        print("  heap min %d  avg %d  device minHeap %d" % (
+            min(h for h, _ in heap), statistics.mean(h for h, _ in heap), min(m for _, m in heap)))
+    st = fetch_stats(args)
+    if st and "stream" in st:
+        s = st["stream"]
+        print("  device stream: fps %s sent %s skipped %s behind %s copies %s dropped %s sendAvgUs %s" % (
+            s.get("fps"), s.get("sent"), s.get("skipped"), s.get("behind"), s.get("copies"),
+            s.get("dropped"), s.get("sendAvgUs")))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="safebaige.local")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--stream-port", type=int, default=81)
+    ap.add_argument("--ws", default="1,2,4,8", help="WS client counts to step through")
+    ap.add_argument("--streams", default="0", help="MJPEG client counts, paired with --ws (last value repeats)")
+    ap.add_argument("--slow", type=int, default=0, help="slow clients per kind in each step")
+    ap.add_argument("--slow-delay", type=float, default=0.5, help="seconds a slow WS client sleeps per message")
+    ap.add_argument("--slow-rate", type=float, default=20000, help="bytes/s a slow stream client reads")
+    ap.add_argument("--duration", type=float, default=20, help="seconds per step")
+    args = ap.parse_args()
+
+    ws_steps = [int(x) for x in args.ws.split(",")]
+    stream_steps = [int(x) for x in args.streams.split(",")]
+    for i, n_ws in enumerate(ws_steps):
+        n_stream = stream_steps[min(i, len(stream_steps) - 1)]
+        run_step(args, n_ws, n_stream)
+        time.sleep(2)  # let the device close the previous sockets
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+"""
+Generates the radar byte streams the native tests replay (test/), with
+tools/ld2451_gen.py and fixed seeds, so every run sees the same bytes.
+
+Runs as a PlatformIO pre script of [env:native]
+(extra_scripts = pre:tools/test_streams.py) or by hand:
+python tools/test_streams.py
+
+Output goes to .pio/test_data/<name>.bin (+ .jsonl ground truth) and is
+only regenerated when ld2451_gen.py changed.
+"""
+
+import os
+import subprocess
+import sys
+
+STREAMS = {
+    # Rear radar: idle, overtake, convoy, ghosts, idle, with 2 % corrupted frames
+    "rear": ["mixed", "--corrupt", "0.02", "--seed", "1"],
+    # Side radar: stationary reflectors with a convoy passing through
+    "side": ["clutter", "--seed", "2"],
+}
+
+
+def generate(project_dir):
+    gen = os.path.join(project_dir, "tools", "ld2451_gen.py")
+    out_dir = os.path.join(project_dir, ".pio", "test_data")
+    os.makedirs(out_dir, exist_ok=True)
+
+    for name, args in sorted(STREAMS.items()):
+        out = os.path.join(out_dir, name + ".bin")
+        truth = os.path.join(out_dir, name + ".jsonl")
+        if os.path.exists(out) and os.path.getmtime(out) >= os.path.getmtime(gen):
+            continue
+        subprocess.check_call([sys.executable, gen] + args + ["--out", out, "--truth", truth],
+                              stderr=subprocess.DEVNULL)
+        print("test stream %s: %d bytes" % (name, os.path.getsize(out)))
+    return out_dir
+
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO)
+    data_dir = generate(env["PROJECT_DIR"])  # noqa: F821
+    env.Append(CPPDEFINES=[("TEST_DATA_DIR", env.StringifyMacro(data_dir))])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        print(generate(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
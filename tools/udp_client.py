@@ -0,0 +1,364 @@
+"""
+UDP radar telemetry stand-in client, compared against the WebSocket channel.
+
+Registers for the UDP channel (POST /udp), subscribes to the binary radar
+topic on /ws at the same time and reports, per channel, how many radar frames
+arrived, how many were lost or skipped and their latency percentiles.
+
+    python tools/udp_client.py --host safebaige.local --loss 0.05 --duration 60
+
+--loss simulates packet loss on the receive side:
+  UDP  the datagram is dropped; the client sees a sequence gap and moves on.
+  WS   TCP would retransmit, so the message arrives --rto ms late and every
+       later message waits behind it (head-of-line blocking).
+For a measurement on a real lossy link, leave --loss at 0 and shape the host
+interface instead (e.g. tc qdisc add dev wlan0 root netem loss 5%).
+
+--local runs without the device: a stand-in on 127.0.0.1 replays a radar
+trace written by ld2451_gen.py --truth (default: generated on the fly from
+"mixed --seed 1") at its frame times, on both channels, in the device's
+datagram and WS record formats. --loss then acts on the stand-in's side of
+the link instead: datagrams are dropped before sendto(), and a lost WS message
+is held for --rto ms with everything queued behind it.
+
+    python tools/udp_client.py --local --loss 0.05 --duration 30
+
+Latency is per radar frame (its device timestamp), from the frame time to the
+first arrival on each channel. Device and host clocks are aligned on the
+fastest arrival over both channels, so the figures are relative to the best
+case seen.
+"""
+
+import argparse
+import base64
+import hashlib
+import http.server
+import json
+import os
+import queue
+import random
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.parse
+import urllib.request
+
+from loadtest import WsClient, percentile
+
+UDP_TYPE = 0x54
+RADAR_TYPE = 0x52
+
+
+def parse_record(data):
+    """'R' record -> frame timestamp (device ms) or None"""
+    if len(data) < 8 or data[0] != RADAR_TYPE:
+        return None
+    return struct.unpack_from("<I", data, 2)[0]
+
+
+def register(args, port, stop=False):
+    body = {"port": port}
+    if args.broadcast:
+        body["broadcast"] = 1
+    if stop:
+        body["stop"] = 1
+    req = urllib.request.Request(
+        "http://%s:%d/udp" % (args.host, args.port),
+        data=urllib.parse.urlencode(body).encode(),
+        method="POST",
+    )
+    with urllib.request.urlopen(req, timeout=3) as r:
+        return r.read().decode()
+
+
+class Channel:
+    def __init__(self, name):
+        self.name = name
+        self.arrivals = {}  # frame timestamp -> first host arrival (ms)
+        self.received = 0
+        self.lost = 0       # detected (UDP gaps) or simulated (WS retransmits)
+        self.skipped = 0    # out of order / duplicates
+
+    def seen(self, ts, now):
+        self.received += 1
+        if ts not in self.arrivals:
+            self.arrivals[ts] = now
+
+
+def udp_receiver(args, sock, ch, stop, rng):
+    last_seq = None
+    while not stop.is_set():
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            continue
+        now = time.monotonic() * 1000
+        if len(data) < 10 or data[0] != UDP_TYPE:
+            continue
+        if rng.random() < args.loss:
+            continue  # simulated loss, never seen
+
+        seq = struct.unpack_from("<I", data, 2)[0]
+        if last_seq is not None:
+            if seq <= last_seq:
+                ch.skipped += 1
+                continue
+            ch.lost += seq - last_seq - 1
+        last_seq = seq
+
+        ts = parse_record(data[10:])
+        if ts is not None:
+            ch.seen(ts, now)
+
+
+def ws_receiver(args, ch, stop, rng):
+    ws = WsClient(args.host, args.port)
+    ws.sock.settimeout(1)
+    ws.send_text("topics=radar;fmt=bin")
+    delivered = 0.0  # host time the previous message was handed to the app
+    try:
+        while not stop.is_set():
+            try:
+                opcode, payload = ws.recv()
+            except socket.timeout:
+                continue
+            now = time.monotonic() * 1000
+            if opcode != 0x2:
+                continue
+            if rng.random() < args.loss:
+                ch.lost += 1
+                now += args.rto
+            # In-order delivery: nothing overtakes a retransmitted message
+            now = max(now, delivered)
+            delivered = now
+            ts = parse_record(payload)
+            if ts is not None:
+                ch.seen(ts, now)
+    finally:
+        ws.close()
+
+
+# ---------------- local stand-in ----------------
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+
+def load_trace(path):
+    """ld2451_gen.py --truth lines -> [(t_ms, targets)]"""
+    if not path:
+        tmp = tempfile.NamedTemporaryFile(suffix=".jsonl", delete=False)
+        tmp.close()
+        gen = os.path.join(os.path.dirname(os.path.abspath(__file__)), "ld2451_gen.py")
+        subprocess.run([sys.executable, gen, "mixed", "--seed", "1", "--out", os.devnull, "--truth", tmp.name],
+                       check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        path = tmp.name
+    with open(path) as f:
+        return [(d["t_ms"], d["targets"]) for d in map(json.loads, f)]
+
+
+def radar_record(ts, targets):
+    """Same layout as the device's binary radar frame (see README)"""
+    rec = struct.pack("<BBIBB", RADAR_TYPE, 1, ts, 0, len(targets))
+    for i, x in enumerate(targets):
+        dist = min(255, int(x["distance"]))
+        flags = 1 if x.get("approaching") else 0
+        rec += struct.pack("<BBBBbBBH", i, dist, min(255, int(x["speed"])), flags,
+                           int(round(x["angle"])), x["snr"], 0, int(x["distance"] * 10))
+    return rec
+
+
+class StandIn:
+    """Device stand-in on 127.0.0.1 with a lossy link in front of it"""
+
+    def __init__(self, trace, loss, rto, rng):
+        self.trace, self.loss, self.rto, self.rng = trace, loss, rto, rng
+        self.udp_clients = set()
+        self.ws_queues = []
+        self.dropped = self.held = 0
+        self.lock = threading.Lock()
+        self.t0 = time.monotonic()
+        self.udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+
+        standin = self
+
+        class Handler(http.server.BaseHTTPRequestHandler):
+            def log_message(self, *a):
+                pass
+
+            def do_POST(self):
+                body = urllib.parse.parse_qs(self.rfile.read(int(self.headers["Content-Length"])).decode())
+                port = int(body["port"][0])
+                with standin.lock:
+                    if "stop" in body:
+                        standin.udp_clients.discard(port)
+                    else:
+                        standin.udp_clients.add(port)
+                self.send_response(200)
+                self.end_headers()
+                self.wfile.write(b'{"ip":"127.0.0.1","port":%d}' % port)
+
+            def do_GET(self):
+                key = self.headers["Sec-WebSocket-Key"] + WS_GUID
+                accept = base64.b64encode(hashlib.sha1(key.encode()).digest()).decode()
+                self.send_response(101)
+                self.send_header("Upgrade", "websocket")
+                self.send_header("Connection", "Upgrade")
+                self.send_header("Sec-WebSocket-Accept", accept)
+                self.end_headers()
+                self.wfile.flush()
+                q = queue.Queue()
+                with standin.lock:
+                    standin.ws_queues.append(q)
+                threading.Thread(target=standin.ws_writer, args=(self.connection, q), daemon=True).start()
+                while self.connection.recv(1024):  # topics line, then until the client closes
+                    pass
+                q.put(None)
+
+        self.http = http.server.ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+        self.port = self.http.server_address[1]
+        threading.Thread(target=self.http.serve_forever, daemon=True).start()
+
+    def now_ms(self):
+        return int((time.monotonic() - self.t0) * 1000)
+
+    def ws_writer(self, conn, q):
+        while True:
+            item = q.get()
+            if item is None:
+                return
+            release, payload = item
+            wait = release - time.monotonic()
+            if wait > 0:
+                time.sleep(wait)
+            n = len(payload)
+            head = bytes([0x82, n]) if n < 126 else bytes([0x82, 126]) + struct.pack(">H", n)
+            try:
+                conn.sendall(head + payload)
+            except OSError:
+                return
+
+    def play(self, stop):
+        seq = 0
+        released = 0.0  # WS: nothing overtakes a retransmitted segment
+        loop_ms = self.trace[-1][0] + 100
+        start = time.monotonic()
+        base = 0.0
+        while not stop.is_set():
+            for t_ms, targets in self.trace:
+                wait = start + (base + t_ms) / 1000 - time.monotonic()
+                if wait > 0:
+                    time.sleep(wait)
+                if stop.is_set():
+                    return
+                now = self.now_ms()
+                rec = radar_record(now, targets)
+
+                seq += 1
+                dgram = struct.pack("<BBII", UDP_TYPE, 1, seq, now) + rec
+                with self.lock:
+                    ports = list(self.udp_clients)
+                    queues = list(self.ws_queues)
+                for port in ports:
+                    if self.rng.random() < self.loss:
+                        self.dropped += 1
+                    else:
+                        self.udp.sendto(dgram, ("127.0.0.1", port))
+
+                release = time.monotonic()
+                if queues and self.rng.random() < self.loss:
+                    self.held += 1
+                    release += self.rto / 1000
+                released = max(released, release)
+                for q in queues:
+                    q.put((released, rec))
+            base += loop_ms
+
+    def close(self):
+        self.http.shutdown()
+
+
+def report(ch, offset, stale_ms):
+    lat = [arr - ts - offset for ts, arr in ch.arrivals.items()]
+    stale = sum(1 for x in lat if x > stale_ms)
+    print("  %-3s frames %5d  msgs %5d  lost %4d  skipped %3d  latency p50 %6.1f p95 %6.1f p99 %6.1f ms  stale(>%d ms) %d"
+          % (ch.name, len(ch.arrivals), ch.received, ch.lost, ch.skipped,
+             percentile(lat, 50), percentile(lat, 95), percentile(lat, 99), stale_ms, stale))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="safebaige.local")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--udp-port", type=int, default=4210, help="local port to receive on")
+    ap.add_argument("--broadcast", action="store_true", help="register for subnet broadcast")
+    ap.add_argument("--loss", type=float, default=0.0, help="simulated loss probability")
+    ap.add_argument("--rto", type=float, default=200, help="simulated TCP retransmit delay (ms)")
+    ap.add_argument("--stale-ms", type=int, default=300, help="latency counted as stale")
+    ap.add_argument("--duration", type=float, default=30)
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--local", action="store_true", help="replay a trace from a local device stand-in")
+    ap.add_argument("--trace", help="ld2451_gen.py --truth file for --local")
+    args = ap.parse_args()
+
+    rng = random.Random(args.seed)
+    standin = None
+    link = threading.Event()
+    if args.local:
+        standin = StandIn(load_trace(args.trace), args.loss, args.rto, random.Random(rng.random()))
+        args.host, args.port = "127.0.0.1", standin.port
+        args.loss = 0.0  # applied by the stand-in's link instead
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(("", args.udp_port))
+    sock.settimeout(1)
+
+    print("registered:", register(args, args.udp_port))
+
+    udp, ws = Channel("udp"), Channel("ws")
+    stop = threading.Event()
+    threads = [
+        threading.Thread(target=udp_receiver, args=(args, sock, udp, stop, random.Random(rng.random())), daemon=True),
+        threading.Thread(target=ws_receiver, args=(args, ws, stop, random.Random(rng.random())), daemon=True),
+    ]
+    for t in threads:
+        t.start()
+    if standin:
+        time.sleep(0.5)  # WS subscribed before the first frame
+        threading.Thread(target=standin.play, args=(link,), daemon=True).start()
+
+    start = time.monotonic()
+    renewed = start
+    while time.monotonic() - start < args.duration:
+        time.sleep(0.5)
+        if time.monotonic() - renewed > 10:  # lease is 30 s on the device
+            register(args, args.udp_port)
+            renewed = time.monotonic()
+
+    link.set()
+    stop.set()
+    for t in threads:
+        t.join(timeout=3)
+    try:
+        register(args, args.udp_port, stop=True)
+    except OSError:
+        pass
+    loss = args.loss
+    if standin:
+        standin.close()
+        ws.lost = standin.held  # retransmits are invisible to a TCP receiver
+        loss = standin.loss
+        print("link: %d datagrams dropped, %d WS messages retransmitted" % (standin.dropped, standin.held))
+
+    offsets = [arr - ts for ch in (udp, ws) for ts, arr in ch.arrivals.items()]
+    offset = min(offsets) if offsets else 0
+    print("\n%.0f s, simulated loss %.1f %%, rto %d ms" % (args.duration, loss * 100, args.rto))
+    report(udp, offset, args.stale_ms)
+    report(ws, offset, args.stale_ms)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,150 @@
+function g(id){ return document.getElementById(id).value; }
+function s(id,val){ document.getElementById(id).value = val; }
+// ---------------- WS Check ----------------
+let ws;
+
+// The raw UART tap is a debug aid: the device only fills its ring while
+// someone subscribes, so ask for it only when the toggle is on
+function subscribeWS(){
+    if (!ws || ws.readyState !== WebSocket.OPEN) return;
+    const raw = document.getElementById("rawTap").checked ? ",raw" : "";
+    ws.send(`topics=radar,stats,events,sync${raw};fmt=json`);
+}
+
+function connectWS(){
+    ws = new WebSocket(`ws://${location.host}/ws`);
+
+    ws.onopen = () => {
+        log("WS Connected");
+        subscribeWS();
+    };
+
+    ws.binaryType = "arraybuffer";
+
+    ws.onmessage = (event) => {
+        if (typeof event.data === "string") {
+            if (event.data.startsWith('{"type":"sync')) {
+                handleSync(event.data);
+                return;
+            }
+            log("RX: " + event.data);
+            return;
+        }
+        // Raw UART tap: 11 byte header, then radar bytes
+        const b = new Uint8Array(event.data);
+        if (b[0] !== 0x55) return;
+        const hex = Array.from(b.slice(11), x => x.toString(16).padStart(2, "0")).join(" ");
+        log("RAW" + b[2] + ": " + hex);
+    };
+
+    ws.onclose = () => {
+        log("WS Disconnected - retrying...");
+        setTimeout(connectWS, 2000);
+    };
+
+    ws.onerror = (err) => {
+        log("WS Error");
+    };
+}
+
+// ---------------- CLOCK SYNC ----------------
+// Answer device clock requests; the result maps device timestamps to this clock
+let clock = null;
+
+function nowMs(){ return performance.timeOrigin + performance.now(); }
+
+function handleSync(text){
+    const t2 = nowMs();
+    const m = JSON.parse(text);
+    if (m.type === "sync") {
+        ws.send(`sync=${m.t1},${t2.toFixed(3)},${nowMs().toFixed(3)}`);
+        return;
+    }
+    if (!clock) log(`Clock synced: offset ${(m.offsetUs / 1000).toFixed(1)} ms, rtt ${(m.rttUs / 1000).toFixed(1)} ms`);
+    clock = m;
+}
+
+// Device millis() -> local ms (null until synced)
+function deviceToLocal(deviceMs){
+    if (!clock) return null;
+    const us = deviceMs * 1000;
+    return (us + clock.offsetUs + clock.driftPpm / 1e6 * (us - clock.refUs)) / 1000;
+}
+
+function log(msg){
+    const el = document.getElementById("wslog");
+    el.textContent += msg + "\n";
+    el.scrollTop = el.scrollHeight;
+}
+// ---------------- CAMERA COMMAND ----------------
+function cmd(type){
+    fetch(`/cam?cmd=${type}`);
+}
+
+// ---------------- SAVE CONFIG ----------------
+function save(){
+    const params = new URLSearchParams({
+        max_distance: g('dist'),
+        direction_mode: g('dir'),
+        min_speed: g('speed'),
+        trigger_delay_ms: g('delay'),
+        trigger_acc: g('acc'),
+        snr_limit: g('snr'),
+        rapid_threshold: g('rapid'),
+        camera_timer_ms: g('camTimer'),
+        display_fps: g('displayFps'),
+        zones: g('zones'),
+        clutter: g('clutter')
+    });
+
+    fetch('/config', {
+        method: 'POST',
+        headers: {'Content-Type':'application/x-www-form-urlencoded'},
+        body: params.toString()
+    })
+    .then(r => {
+        alert(r.ok ? "Configuration Saved"
+            : r.status == 503 ? "Device busy, try again"
+            : "Invalid exclusion zones, nothing saved");
+    });
+}
+
+// ---------------- LOAD CONFIG ON PAGE LOAD ----------------
+window.onload = function(){
+    
+    connectWS();
+
+    fetch('/config')
+    .then(r => r.json())
+    .then(cfg => {
+        s('dist', cfg.dist);
+        s('dir', cfg.dir);
+        s('speed', cfg.speed);
+        s('delay', cfg.delay);
+        s('acc', cfg.acc);
+        s('snr', cfg.snr);
+        s('rapid', cfg.rapid);
+        s('camTimer', cfg.camTimer);
+        s('displayFps', cfg.displayFps);
+        s('zones', cfg.zones);
+        s('clutter', cfg.clutter);
+    });
+}
+
+// ---------------- PROFILE PRESETS ----------------
+const presets = {
+    city:      {dist:40, speed:0, delay:0, acc:5, snr:6, rapid:15},
+    highway:   {dist:100, speed:10, delay:0, acc:3, snr:4, rapid:20},
+    rain:      {dist:60, speed:5, delay:1, acc:6, snr:10, rapid:15},
+    commuter:  {dist:70, speed:5, delay:0, acc:4, snr:4, rapid:15},
+    performance:{dist:100, speed:0, delay:0, acc:2, snr:4, rapid:25}
+};
+
+function applyProfile(p) {
+    if (!presets[p]) return;
+    const cfg = presets[p];
+    for (const key in cfg) {
+        document.getElementById(key).value = cfg[key];
+    }
+    alert(`Profile "${p}" applied - press SAVE`);
+}